@@ -24,5 +24,22 @@ Dash.Config = {
 	joystick: {
 		speed: 1.5,
 		turnRate: Math.PI * 2
+	},
+	frames: {
+		fps: 10,
+		// 'runs' for the lossless blobber runs, 'jpeg' for a classification image
+		classification: 'runs'
+	},
+	state: {
+		// updates per second of each state topic, add 'localizer' to get the particles
+		topics: {
+			robot: 30,
+			wheels: 30,
+			vision: 30,
+			controller: 10,
+			status: 30
+		},
+		// every update of this topic adds the combined state to the history, the status topic changes on every frame
+		historyTopic: 'status'
 	}
 };
\ No newline at end of file
@@ -2,6 +2,10 @@ Dash.FrameCanvas = function(id) {
 	this.id = id || 'frame-canvas';
 	this.element = null;
 	this.c = null;
+	this.classification = null;
+	this.opacity = 0.8;
+	this.mouseX = -1000;
+	this.mouseY = -1000;
 };
 
 Dash.FrameCanvas.prototype.init = function() {
@@ -39,13 +43,98 @@ Dash.FrameCanvas.prototype.init = function() {
 	});
 };
 
+// draws the classification from blobber runs, a run is a color index byte (0 for none) and a base 128 varint length
+Dash.FrameCanvas.prototype.renderRuns = function(data, width, height) {
+	var colorCount = data[0],
+		offset = 1 + colorCount * 3,
+		pixelCount = width * height,
+		pixel = 0,
+		image,
+		pixels,
+		color,
+		length,
+		shift,
+		value,
+		red,
+		green,
+		blue,
+		end;
+
+	if (this.classification === null) {
+		this.classification = document.createElement('canvas');
+	}
+
+	if (this.classification.width !== width || this.classification.height !== height) {
+		this.classification.width = width;
+		this.classification.height = height;
+	}
+
+	image = this.classification.getContext('2d').createImageData(width, height);
+	pixels = image.data;
+
+	while (offset < data.length && pixel < pixelCount) {
+		color = data[offset++];
+		length = 0;
+		shift = 0;
+
+		do {
+			value = data[offset++];
+			length |= (value & 0x7F) << shift;
+			shift += 7;
+		} while (value & 0x80);
+
+		red = green = blue = 0;
+
+		if (color > 0) {
+			red = data[1 + (color - 1) * 3];
+			green = data[2 + (color - 1) * 3];
+			blue = data[3 + (color - 1) * 3];
+		}
+
+		end = Math.min(pixel + length, pixelCount);
+
+		for (; pixel < end; pixel++) {
+			pixels[pixel * 4] = red;
+			pixels[pixel * 4 + 1] = green;
+			pixels[pixel * 4 + 2] = blue;
+			pixels[pixel * 4 + 3] = 255;
+		}
+	}
+
+	this.classification.getContext('2d').putImageData(image, 0, 0);
+
+	this.render(this.mouseX, this.mouseY);
+};
+
+Dash.FrameCanvas.prototype.clearRuns = function() {
+	if (this.classification !== null) {
+		this.classification = null;
+
+		this.render(this.mouseX, this.mouseY);
+	}
+};
+
+Dash.FrameCanvas.prototype.setOpacity = function(opacity) {
+	this.opacity = opacity;
+
+	this.render(this.mouseX, this.mouseY);
+};
+
 Dash.FrameCanvas.prototype.render = function(x, y) {
 	var brush = parseInt($('#threshold-brush').val());
 	
+	this.mouseX = x;
+	this.mouseY = y;
 	this.element.width = this.width = $('#' + this.id).width();
 	this.element.height = this.height = $('#' + this.id).height();
 	
 	this.c.clearRect(0, 0, this.width, this.height);
+
+	if (this.classification !== null) {
+		this.c.globalAlpha = this.opacity;
+		this.c.drawImage(this.classification, 0, 0, this.width, this.height);
+		this.c.globalAlpha = 1.0;
+	}
 	
 	this.c.strokeStyle = '#090';
 	
@@ -353,6 +353,16 @@ Dash.Renderer.prototype.renderState = function(state) {
 		state.gyroOrientation
 	);*/
 
+	// particles of the localizer state topic
+	if (typeof(state.localizer) === 'object' && state.localizer !== null && typeof(state.localizer.particles) !== 'undefined') {
+		for (var i = 0; i < state.localizer.particles.length; i++) {
+			this.drawParticle(
+				state.localizer.particles[i][0],
+				state.localizer.particles[i][1]
+			);
+		}
+	}
+
 	if (state.controllerState !== null) {
 		/*if (state.controllerState.odometerLocalizer !== null && typeof(state.controllerState.odometerLocalizer) === 'object') {
 			this.drawRobot(
@@ -28,6 +28,7 @@ Dash.Socket.prototype.open = function(host, port) {
 	this.host = host;
 	this.port = port;
 	this.ws = new WebSocket('ws://' + this.host + ':' + this.port);
+	this.ws.binaryType = 'arraybuffer';
 	this.opening = true;
 	
 	this.ws.onopen = function() {
@@ -14,6 +14,8 @@ Dash.UI = function() {
 	this.currentStateIndex = 0;
 	this.repeatedLogCount = 0;
 	this.extractedCameraTranslator = false;
+	this.liveState = null;
+	this.liveStateTopics = {};
 };
 
 Dash.UI.prototype = new Dash.Bindable();
@@ -23,6 +25,12 @@ Dash.UI.Event = {
 	KEY_UP: 'key-up'
 }
 
+// first byte of binary messages
+Dash.UI.BinaryMessage = {
+	FRAME: 1,
+	RUNS_FRAME: 2
+};
+
 Dash.UI.prototype.init = function() {
 	this.initDebugListener();
 	this.initSlider();
@@ -248,6 +256,8 @@ Dash.UI.prototype.initSocket = function() {
 			dash.socket.send('<get-controller>');
 		//}, 2000);
 
+		self.subscribeState();
+
 		self.setupParameterFields();
 		self.setupRefereeFields();
 	});
@@ -281,6 +291,13 @@ Dash.UI.prototype.initSocket = function() {
 	
 	dash.socket.bind(Dash.Socket.Event.MESSAGE_RECEIVED, function(e) {
 		var message;
+
+		if (e.message.data instanceof ArrayBuffer) {
+			self.handleBinaryMessage(e.message.data);
+			self.flashClass('#rx', 'active', 100);
+
+			return;
+		}
 		
 		try {
 			message = JSON.parse(e.message.data);
@@ -527,7 +544,7 @@ Dash.UI.prototype.initControls = function() {
 	$('#fetch-frame-btn').click(function() {
 		dash.ui.showModal('camera-view');
 		
-		dash.socket.send('<get-frame>');
+		dash.socket.send('<stream-frames:' + dash.config.frames.fps + ':' + dash.config.frames.classification + '>');
 		dash.socket.send('<list-screenshots>');
 	});
 
@@ -692,6 +709,7 @@ Dash.UI.prototype.initControls = function() {
 
 	$('#camera-opacity').on('input', function() {
 		$('#frame-classification').css('opacity', $(this).val() / 100);
+		self.frameCanvas.setOpacity($(this).val() / 100);
 	});
 	
 	$('#frame-img, #frame-classification, #frame-canvas').mousedown(function(e) {
@@ -855,6 +873,10 @@ Dash.UI.prototype.handleMessage = function(message) {
 		case 'state':
 			this.handleStateMessage(message.payload);
 		break;
+
+		case 'state-delta':
+			this.handleStateDeltaMessage(message.payload);
+		break;
 		
 		case 'log':
 			this.handleLogMessage(message.payload);
@@ -898,14 +920,79 @@ Dash.UI.prototype.handleControllerMessage = function(controller) {
 			$(this).hide();
 		}
 	});
-
-	dash.socket.send('<get-state>');
 };
 
 Dash.UI.prototype.handleStateMessage = function(state) {
 	this.addState(state);
+};
+
+Dash.UI.prototype.subscribeState = function() {
+	var topic;
+
+	this.liveState = {};
+	this.liveStateTopics = {};
+
+	for (topic in dash.config.state.topics) {
+		dash.socket.send('<subscribe:' + topic + ':' + dash.config.state.topics[topic] + '>');
+	}
+};
+
+Dash.UI.prototype.handleStateDeltaMessage = function(delta) {
+	var path,
+		topic,
+		i;
 
-	dash.socket.send('<get-state>'); // request for new state
+	if (this.liveState === null) {
+		return;
+	}
+
+	for (i = 0; i < delta.remove.length; i++) {
+		this.setStateValue(this.liveState, delta.remove[i], undefined);
+	}
+
+	for (path in delta.set) {
+		this.setStateValue(this.liveState, path, delta.set[path]);
+	}
+
+	this.liveStateTopics[delta.topic] = true;
+
+	if (delta.topic !== dash.config.state.historyTopic) {
+		return;
+	}
+
+	// the state is complete once every topic has sent its values
+	for (topic in dash.config.state.topics) {
+		if (!this.liveStateTopics[topic]) {
+			return;
+		}
+	}
+
+	this.addState(JSON.parse(JSON.stringify(this.liveState)));
+};
+
+// sets a dot separated path in the state, an undefined value removes it
+Dash.UI.prototype.setStateValue = function(state, path, value) {
+	var keys = path.split('.'),
+		target = state,
+		i;
+
+	for (i = 0; i < keys.length - 1; i++) {
+		if (target[keys[i]] === null || typeof(target[keys[i]]) !== 'object') {
+			if (typeof(value) === 'undefined') {
+				return;
+			}
+
+			target[keys[i]] = {};
+		}
+
+		target = target[keys[i]];
+	}
+
+	if (typeof(value) === 'undefined') {
+		delete target[keys[keys.length - 1]];
+	} else {
+		target[keys[keys.length - 1]] = value;
+	}
 };
 
 Dash.UI.prototype.handleLogMessage = function(messages) {
@@ -939,8 +1026,67 @@ Dash.UI.prototype.handleBlobberCalibrationMessage = function(calibration) {
 	this.showModal('blobber-calibration');
 };
 
+Dash.UI.prototype.handleBinaryMessage = function(data) {
+	var view = new DataView(data);
+
+	switch (view.getUint8(0)) {
+		case Dash.UI.BinaryMessage.FRAME:
+		case Dash.UI.BinaryMessage.RUNS_FRAME:
+			this.handleFrameMessage(this.parseFrameMessage(data));
+		break;
+
+		default:
+			dash.dbg.log('- Unsupported binary message received: ' + view.getUint8(0));
+		break;
+	}
+
+	this.rxCounter.step();
+};
+
+Dash.UI.prototype.parseFrameMessage = function(data) {
+	var view = new DataView(data),
+		type = view.getUint8(0),
+		rgbLength = view.getUint32(10, true),
+		classificationLength = view.getUint32(14, true),
+		nameLength = view.getUint8(18),
+		offset = 19,
+		activeStream = '',
+		i;
+
+	for (i = 0; i < nameLength; i++) {
+		activeStream += String.fromCharCode(view.getUint8(offset + i));
+	}
+
+	offset += nameLength;
+
+	return {
+		camera: view.getUint8(1),
+		frameNumber: view.getUint32(2, true),
+		width: view.getUint16(6, true),
+		height: view.getUint16(8, true),
+		activeStream: activeStream,
+		rgb: new Blob([new Uint8Array(data, offset, rgbLength)], { type: 'image/jpeg' }),
+		classification: type === Dash.UI.BinaryMessage.FRAME ? new Blob([new Uint8Array(data, offset + rgbLength, classificationLength)], { type: 'image/jpeg' }) : null,
+		runs: type === Dash.UI.BinaryMessage.RUNS_FRAME ? new Uint8Array(data, offset + rgbLength, classificationLength) : null
+	};
+};
+
+Dash.UI.prototype.setFrameImage = function(id, blob) {
+	var url = URL.createObjectURL(blob),
+		img = $('#' + id);
+
+	img.one('load error', function() {
+		URL.revokeObjectURL(url);
+	});
+
+	img.attr('src', url);
+};
+
 Dash.UI.prototype.handleFrameMessage = function(frame) {
 	if (!$('#camera-view').is(':visible')) {
+		// stop the stream once the view is closed
+		dash.socket.send('<stream-frames:0>');
+
 		return;
 	}
 
@@ -950,8 +1096,16 @@ Dash.UI.prototype.handleFrameMessage = function(frame) {
 	$('#frame-img').attr('width', '640');
 	$('#frame-img').attr('height', '512');
 
-	$('#frame-img').attr('src', 'data:image/jpeg;base64,' + frame.rgb);
-	$('#frame-classification').attr('src', 'data:image/jpeg;base64,' + frame.classification);
+	this.setFrameImage('frame-img', frame.rgb);
+
+	if (frame.runs !== null) {
+		$('#frame-classification').hide();
+		this.frameCanvas.renderRuns(frame.runs, frame.width, frame.height);
+	} else {
+		$('#frame-classification').show();
+		this.frameCanvas.clearRuns();
+		this.setFrameImage('frame-classification', frame.classification);
+	}
 	$('#stream-choice OPTION.selected').attr('selected', false);
 	$('#stream-choice OPTION[value=' + frame.activeStream + ']').attr('selected', 'selected');
 
@@ -961,8 +1115,6 @@ Dash.UI.prototype.handleFrameMessage = function(frame) {
 	}
 
 	this.applyScreenshotState();
-
-	dash.socket.send('<get-frame>');
 };
 
 
@@ -1235,6 +1387,10 @@ Dash.UI.prototype.showStateStats = function(state) {
 	) {
 		delete state.controllerState.particleLocalizer.particles;
 	}
+
+	if (typeof(state.localizer) === 'object' && state.localizer !== null) {
+		delete state.localizer.particles;
+	}
 };
 
 Dash.UI.prototype.showControllerState = function(state) {
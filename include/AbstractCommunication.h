@@ -2,9 +2,17 @@
 #define ABSTRACT_COMMUNICATION_H
 
 #include "Thread.h"
+#include "BinaryProtocol.h"
+#include "RingQueue.h"
+#include "StringView.h"
+#include "Config.h"
 
 #include <string>
 #include <queue>
+#include <vector>
+#include <atomic>
+
+class LineFramer;
 
 class AbstractCommunication : public Thread {
 
@@ -15,16 +23,68 @@ public:
 		virtual void handleCommunicationMessage(std::string message) = 0;
 	};
 
+	// called on the communication thread as soon as a message is received, before it is queued for the main loop
+	// the message view is only valid during the call
+	class ReceiveListener {
+
+	public:
+		// the robot owns listeners such as the odometry accumulator through this interface
+		virtual ~ReceiveListener() {}
+
+		virtual void onCommunicationReceive(const StringView& message) = 0;
+	};
+
+	// outgoing side counters of implementations that schedule their sends
+	struct SendStats {
+		SendStats() : pending(0), coalesced(0), dropped(0), datagrams(0), inFlight(0), maxInFlight(0), backPressure(0), errors(0) {}
+
+		int pending;
+		int coalesced;
+		int dropped;
+		int datagrams;
+		int inFlight;
+		int maxInFlight;
+		int backPressure;
+		int errors;
+	};
+
 	typedef std::queue<std::string> Messages;
 	enum { MAX_SIZE = 4098 };
 
+	AbstractCommunication() : receivedMessages(Config::communicationQueueSize), binaryProtocol(false) {}
+
 	virtual void send(std::string message) = 0;
-	virtual bool gotMessages() = 0;
-	virtual std::string dequeueMessage() = 0;
 	//virtual int start() { return 0; };
 	virtual void close() = 0;
 	virtual void sync() {};
 
+	// marks the end of a control tick, implementations that batch outgoing commands send them now
+	virtual void flush() {};
+
+	// received messages are consumed by a single thread, without locking
+	bool gotMessages() const { return !receivedMessages.isEmpty(); }
+	std::string dequeueMessage();
+	int dequeueMessages(std::string* buffer, int maxCount) { return receivedMessages.popBatch(buffer, maxCount); }
+	int getQueueDepth() const { return receivedMessages.getDepth(); }
+	int getMaxQueueDepth() const { return receivedMessages.getMaxDepth(); }
+	int getDroppedMessageCount() const { return receivedMessages.getDropCount(); }
+	virtual SendStats getSendStats() const { return SendStats(); }
+
+	// receive listeners must be added before the communication thread is started and outlive it
+	void addReceiveListener(ReceiveListener* listener) { receiveListeners.push_back(listener); }
+
+	// sends the speeds as a binary frame once the firmware has acknowledged the binary protocol, as text otherwise
+	void sendSpeeds(int FL, int FR, int RL, int RR, int dribbler);
+	void requestBinaryProtocol() { send("protocol:binary"); }
+	bool isBinaryProtocol() const { return binaryProtocol; }
+
+	// the firmware starts over in the text protocol, the binary one has to be requested again
+	void sendReset() {
+		binaryProtocol = false;
+
+		send("reset");
+	}
+
 	// temporary speeds hack
 	void setSpeeds(int FL, int FR, int RL, int RR, int dribbler) {
 		speedFL = FL;
@@ -36,6 +96,41 @@ public:
 	}
 
 protected:
+	virtual void sendFrame(const unsigned char* data, int length) = 0;
+
+	// called by the single receiving thread, the message is copied into a reused buffer that is swapped with a free queue slot
+	// binary tells whether the message was decoded from a binary frame
+	void receiveMessage(const StringView& message, bool binary = false) {
+		notifyReceived(message, binary);
+
+		queuedMessage.assign(message.getData(), message.getLength());
+		receivedMessages.push(queuedMessage);
+	}
+
+	// frames a chunk of a byte stream and receives the complete messages
+	void receiveBytes(LineFramer& framer, const char* data, int length);
+
+	void notifyReceived(const StringView& message, bool binary) {
+		if (message == "<protocol:binary>") {
+			binaryProtocol = true;
+		} else if (message == "<protocol:text>") {
+			binaryProtocol = false;
+		} else if (binaryProtocol && !binary && message.startsWith("<speeds:")) {
+			// the firmware reports the speeds as text again once it has restarted, negotiate again
+			binaryProtocol = false;
+		}
+
+		for (std::vector<ReceiveListener*>::const_iterator it = receiveListeners.begin(); it != receiveListeners.end(); it++) {
+			(*it)->onCommunicationReceive(message);
+		}
+	}
+
+	std::vector<ReceiveListener*> receiveListeners;
+	RingQueue<std::string> receivedMessages;
+	std::string queuedMessage;
+	BinaryProtocol::Decoder decoder;
+	std::atomic<bool> binaryProtocol;
+
 	int speedFL;
 	int speedFR;
 	int speedRL;
@@ -4,26 +4,34 @@
 #include "Maths.h"
 #include "Object.h"
 
+#include <vector>
+
 class BallLocalizer {
 
 public:
 	class Ball {
 
     public:
-        Ball(float x, float y);
-        void updateVisible(float x, float y, float dt);
-        void updateInvisible(float dt);
+        Ball(float x, float y, double time);
+        void predict(double time);
+        void updateVisible(float x, float y, double time);
+        void updateInvisible();
         void markForRemoval(double afterSeconds);
-        bool shouldBeRemoved();
+        bool shouldBeRemoved() const;
+        Math::Point getPredictedPosition(double time) const;
 
         int id;
         double createdTime;
         double updatedTime;
         double removeTime;
+        double stateTime;
         float x;
         float y;
         float velocityX;
         float velocityY;
+        float positionVariance;
+        float velocityVariance;
+        float positionVelocityCovariance;
         bool visible;
 		bool inFOV;
 		bool resurrectable;
@@ -35,19 +43,66 @@ public:
 
 	};
 
-	typedef std::vector<Ball*> BallList;
-	typedef std::vector<Ball*>::iterator BallListIt;
+	// balls are stored by value so the storage can be reused between frames
+	typedef std::vector<Ball> BallList;
+	typedef BallList::iterator BallListIt;
+	typedef BallList::const_iterator BallListItc;
+
+	// uniform grid spatial index over ball positions, cells are hashed into a fixed number of buckets
+	class Grid {
+
+	public:
+		Grid(float cellSize, int bucketCount);
+
+		void build(const BallList& items);
+		void findNear(float x, float y, float radius, const BallList& items, std::vector<int>& result) const;
+
+	private:
+		int getCell(float value) const;
+		int getBucket(int cellX, int cellY) const;
+
+		float cellSize;
+		int bucketCount;
+		std::vector<int> heads;
+		std::vector<int> next;
+
+	};
+
+	struct Association {
+		Association(int visibleIndex, int ballIndex, float distance) : visibleIndex(visibleIndex), ballIndex(ballIndex), distance(distance) {}
+
+		bool operator<(const Association& other) const { return distance < other.distance; }
+
+		int visibleIndex;
+		int ballIndex;
+		float distance;
+	};
+
+	typedef std::vector<Association> Associations;
+	typedef Associations::const_iterator AssociationsIt;
 
     BallLocalizer();
     ~BallLocalizer();
 
-	BallList extractBalls(const ObjectList& sourceBalls, float robotX, float robotY, float robotOrientation);
-    void update(const BallList& visibleBalls, const Math::Polygon& cameraFOV, float dt);
+	void extractBalls(const ObjectList& sourceBalls, float robotX, float robotY, float robotOrientation, double timestamp, BallList& result);
+    void update(const BallList& visibleBalls, const Math::Polygon& cameraFOV, double timestamp);
     Ball* getBallAround(float x, float y);
+	Ball* getTrackedBall(int visibleIndex);
     void purge(const BallList& visibleBalls, const Math::Polygon& cameraFOV);
     //bool isValid(Ball* ball, const BallList& visibleBalls, const Math::Polygon& cameraFOV);
 
-	BallList balls; 
+	BallList balls;
+
+private:
+	void associate(const BallList& visibleBalls);
+
+	Grid ballGrid;
+	Grid visibleGrid;
+	Associations associations;
+	std::vector<int> visibleAssignments;
+	std::vector<bool> ballAssigned;
+	std::vector<int> ballRemap;
+	std::vector<int> candidates;
 
 };
 
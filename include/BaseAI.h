@@ -36,6 +36,7 @@ public:
 	virtual void setState(std::string state);
 	virtual void setState(std::string state, Parameters parameters);
 	virtual void handleCommunicationMessage(std::string message);
+	const std::string& getCurrentStateName() const { return currentStateName; }
 
 protected:
 	States states;
@@ -13,7 +13,7 @@ public:
         int height;
         int number;
 		bool fresh;
-        double timestamp;
+        double timestamp; // exposure time in the Util::millitime() time base
     };
 
 	virtual Frame* getFrame() = 0;
@@ -0,0 +1,82 @@
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+#include <string>
+
+// framed protocol: start byte, message type, payload length, little-endian payload and a CRC-16 over type, length and payload
+class BinaryProtocol {
+
+public:
+	enum {
+		FRAME_START = 0xA5,
+		HEADER_SIZE = 3,
+		CRC_SIZE = 2,
+		MAX_PAYLOAD_SIZE = 250,
+		MAX_FRAME_SIZE = HEADER_SIZE + MAX_PAYLOAD_SIZE + CRC_SIZE,
+		MAX_TEXT_SIZE = MAX_PAYLOAD_SIZE + 3
+	};
+
+	enum Type {
+		// any other command as text without the angle brackets
+		TYPE_TEXT = 1,
+
+		// five signed 16-bit speeds in the order FL, FR, RL, RR, dribbler
+		TYPE_SPEEDS = 2,
+
+		// one byte, non-zero when the ball is in the dribbler
+		TYPE_BALL = 3
+	};
+
+	enum { SPEEDS_PAYLOAD_SIZE = 10, BALL_PAYLOAD_SIZE = 1 };
+
+	struct Frame {
+		Frame() : type(0), length(0) {}
+
+		unsigned char type;
+		unsigned char length;
+		unsigned char payload[MAX_PAYLOAD_SIZE];
+	};
+
+	// incremental decoder for byte streams, frames with unexpected length or invalid CRC are dropped
+	class Decoder {
+
+	public:
+		Decoder();
+
+		bool push(unsigned char byte, Frame& frame);
+		void reset() { state = STATE_IDLE; }
+		bool isReceiving() const { return state != STATE_IDLE; }
+		int getErrorCount() const { return errorCount; }
+
+	private:
+		enum State {
+			STATE_IDLE,
+			STATE_TYPE,
+			STATE_LENGTH,
+			STATE_PAYLOAD,
+			STATE_CRC_HIGH,
+			STATE_CRC_LOW
+		};
+
+		State state;
+		Frame current;
+		int received;
+		unsigned short crc;
+		int errorCount;
+
+	};
+
+	static int encodeSpeeds(unsigned char* buffer, int FL, int FR, int RL, int RR, int dribbler);
+	static int encodeBall(unsigned char* buffer, bool detected);
+	static int encodeText(unsigned char* buffer, const std::string& message);
+	static std::string toText(const Frame& frame);
+	static int toText(const Frame& frame, char* buffer);
+	static bool isValidLength(int type, int length);
+	static unsigned short crc16(const unsigned char* data, int length, unsigned short crc = 0xFFFF);
+
+private:
+	static int encode(unsigned char* buffer, int type, const unsigned char* payload, int length);
+
+};
+
+#endif // BINARYPROTOCOL_H
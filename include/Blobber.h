@@ -267,6 +267,26 @@ class Blobber {
         int getBlobCount(int colorId);
         Blob* getBlobs(int colorId);
 
+        // run-length encoded classification of the last processed frame,
+        // the runs of each row add up to the width and the rows follow each other
+        const ColorRun* getRuns() const {
+            return runMap;
+        }
+
+        int getRunCount() const {
+            return runCount;
+        }
+
+        // color bits of a pixel value like classifyFrame sets in the map without the dual threshold
+        unsigned getClass(unsigned char y, unsigned char u, unsigned char v) const {
+            return yClass[y] & uClass[u] & vClass[v];
+        }
+
+        // index of the color a run or map value is classified as, -1 for unclassified
+        static int getColorIndex(unsigned color) {
+            return bottomBit(color) - 1;
+        }
+
         int getBlobCount(std::string colorName) {
             return getBlobCount(getColorId(colorName));
         }
@@ -285,6 +305,7 @@ class Blobber {
         int blobCount[BLOBBER_MAX_COLORS];
 
         ColorRun runMap[BLOBBER_MAX_RUNS];
+        int runCount;
 
         Color colors[BLOBBER_MAX_COLORS];
         int colorCount;
@@ -69,13 +69,18 @@ public:
 	bool loadUndistortionMapping(std::string xFilename, std::string yFilename);
 	bool loadDistortionMapping(std::string xFilename, std::string yFilename);
 	CameraMapSet generateInverseMap(CameraMap& mapX, CameraMap& mapY);
+
+	// loads the distortion mapping and generates the undistortion mapping from it, without the files both stay identity mappings
+	bool loadMappings(std::string distortXFilename, std::string distortYFilename);
+	void setIdentityMappings();
+
 	WorldPosition getWorldPosition(int cameraX, int cameraY);
 	CameraPosition getCameraPosition(float dx, float dy);
 	CameraPosition undistort(int x, int y);
 	CameraPosition distort(int x, int y);
 	CameraPosition getMappingPosition(int x, int y, CameraMap& mapX, CameraMap& mapY);
 	//CameraPosition getAvgMappingPosition(int x, int y, CameraMap& mapX, CameraMap& mapY);
-	CameraPositionSet CameraTranslator::getSpiral(int width, int height);
+	CameraPositionSet getSpiral(int width, int height);
 	Math::PointList getPointsBetween(float x1, float y1, float x2, float y2, float distanceStepMeters);
 	std::string getJSON();
 
@@ -100,4 +105,6 @@ private:
 	int cameraHeight;
 };
 
+std::istream& operator >> (std::istream& inputStream, CameraTranslator::CameraMap& map);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef CAPTURETHREAD_H
+#define CAPTURETHREAD_H
+
+#include "Thread.h"
+#include "BaseCamera.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <vector>
+
+// fetches the frames of a camera on its own thread so the processing never waits on the camera driver
+//
+// every fresh frame is copied out of the driver buffer into a free slot of a small ring, the slots are buffers from the
+// frame buffer pool, the processing takes the newest complete frame and the ones it never got to are counted as stale
+//
+// a slot is reference counted and not written while anyone holds it, so the processing, the screenshots and the debug
+// views can keep using a frame without copying it, a camera frame is dropped as an overrun when every slot is held
+class CaptureThread : public Thread {
+
+public:
+	struct Slot {
+		Slot() : references(0) {}
+
+		BaseCamera::Frame frame;
+		int references;
+	};
+
+	struct Stats {
+		Stats() : captured(0), stale(0), overruns(0) {}
+
+		int captured;
+		int stale;
+		int overruns;
+	};
+
+	CaptureThread(BaseCamera* camera, int width, int height);
+	~CaptureThread();
+
+	void close();
+
+	BaseCamera* getCamera() { return camera; }
+
+	// waits up to the timeout in seconds for a frame newer than the last one taken, returns it held or NULL
+	Slot* takeFrame(double timeout);
+
+	// holding NULL or releasing NULL does nothing
+	void hold(Slot* slot);
+	void release(Slot* slot);
+
+	Stats getStats();
+
+private:
+	void* run();
+	Slot* getFreeSlot();
+
+	BaseCamera* camera;
+	int width;
+	int height;
+	bool running;
+	std::vector<Slot> slots;
+	Slot* newest;
+	bool newestTaken;
+	Stats stats;
+	boost::mutex mutex;
+	boost::condition_variable condition;
+
+};
+
+#endif // CAPTURETHREAD_H
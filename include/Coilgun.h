@@ -2,16 +2,22 @@
 #define COILGUN_H
 
 #include "Config.h"
+#include "AbstractCommunication.h"
+
+#include <atomic>
 
-class AbstractCommunication;
 class Command;
+class Dribbler;
 
-class Coilgun {
+class Coilgun : public AbstractCommunication::ReceiveListener {
 
 public:
 	Coilgun(AbstractCommunication* com);
 	~Coilgun();
 
+	// the ball may already be in the dribbler when a kick once got ball is requested
+	void setDribbler(Dribbler* dribbler) { this->dribbler = dribbler; }
+
 	struct KickParameters {
 		KickParameters() : mainDuration(0), mainDelay(0), chipDistance(0), chipDelay(0) {}
 		KickParameters(int mainDuration, int mainDelay, float chipDistance, int chipDelay) : mainDuration(mainDuration), mainDelay(mainDelay), chipDistance(chipDistance), chipDelay(chipDelay) {}
@@ -42,21 +48,30 @@ public:
 	float getVoltage() { return voltage; }
 	float getTimeSinceLastKicked();
 	bool handleCommand(const Command& cmd);
+	void onCommunicationReceive(const StringView& message);
 	void step(float dt);
 
 private:
+	enum { KICK_ARMED = 1 };
+
 	void requestVoltageReading();
+	void sendArmedKick();
+	static unsigned long long packKick(int mainDuration, int mainDelay, int chipDuration, int chipDelay);
 
 	AbstractCommunication* com;
+	Dribbler* dribbler;
 	double lastKickTime;
 	double lastChargeRequestTime;
-	double lastBdkickRequestTime;
 	float timeSinceLastVoltageReading;
 	float voltage;
 	bool isKickingOnceGotBall;
 	int kickOnceGotBallMissedFrames;
 	KickParameters kickOnceGotBallParameters;
 
+	// kick once got ball durations packed with the armed flag, fired and disarmed by the communication thread
+	std::atomic<unsigned long long> armedKick;
+	std::atomic<bool> gotBallKickSent;
+
 };
 
 #endif //COILGUN_H
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define COMPORT_COMMUNICATION_H
 
 #include "AbstractCommunication.h"
+#include "CommandScheduler.h"
+#include "LineFramer.h"
 #include "Serial.h"
 
 #include <string>
@@ -20,24 +22,20 @@ public:
 
 	static PortList getPortList();
 	void send(std::string message);
-	bool gotMessages();
-	std::string dequeueMessage();
 	void close();
 	void sync();
+	SendStats getSendStats() const;
 
 private:
 	void* run();
+	void sendFrame(const unsigned char* data, int length);
 
 	std::string portName;
 	int baud;
-	std::string partialMessage;
-	Messages messages;
-	Messages queuedMessages;
-	Messages sendQueue;
+	LineFramer framer;
+	CommandScheduler scheduler;
 	char readBuffer[MAX_SIZE];
-	char requestBuffer[MAX_SIZE];
-	mutable boost::mutex messagesMutex;
-	bool receivingMessage;
+	unsigned char requestBuffer[MAX_SIZE];
 	bool opened;
 	HANDLE commHandle;
 };
@@ -0,0 +1,58 @@
+#ifndef COMMBENCHMARK_H
+#define COMMBENCHMARK_H
+
+#include "AbstractCommunication.h"
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+class FirmwareStub;
+
+// sends target speeds at a fixed rate through a communication link to the local firmware stub, together with the
+// usual adc, charge and kick traffic, and measures the time from sending until the echoed wheel feedback arrives
+class CommBenchmark : public AbstractCommunication::ReceiveListener {
+
+public:
+	enum Transport {
+		ETHERNET,
+		SERIAL
+	};
+
+	CommBenchmark(Transport transport, int delay, float loss);
+	~CommBenchmark();
+
+	// the stub opens one end of a virtual null-modem port pair and the link the other,
+	// without ports a pseudo terminal is used where available
+	void setSerialPorts(const std::string& stubDevice, const std::string& device);
+
+	bool setup();
+	void run(double duration, int rate);
+
+	void onCommunicationReceive(const StringView& message);
+
+private:
+	// speeds are tagged with a sequence number in place of the front left wheel speed
+	enum { SEQUENCE_COUNT = 16384 };
+
+	void tick(int sequence, int tickIndex);
+	void drain();
+	void report(int sentCount, double duration, int rate);
+	static double percentile(const std::vector<double>& sorted, double fraction);
+
+	Transport transport;
+	int delay;
+	float loss;
+	std::string stubDevice;
+	std::string device;
+	FirmwareStub* stub;
+	AbstractCommunication* com;
+	double sendTimes[SEQUENCE_COUNT];
+	std::vector<double> latencies;
+	std::vector<std::string> messages;
+	int otherReplyCount;
+	boost::mutex mutex;
+
+};
+
+#endif // COMMBENCHMARK_H
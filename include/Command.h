@@ -1,6 +1,8 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
+#include "StringView.h"
+
 #include <string>
 #include <vector>
 
@@ -14,13 +16,30 @@ public:
 
 	};
 
+	enum { MAX_PARAMETERS = 32 };
+
+	// command tokenized in place, the name and parameters refer to the parsed input
+	struct View {
+		View() : parameterCount(0) {}
+		View(const Command& command);
+
+		StringView name;
+		StringView parameters[MAX_PARAMETERS];
+		int parameterCount;
+	};
+
 	typedef std::vector<std::string> Parameters;
 
     Command(std::string name, Parameters parameters) : name(name), parameters(parameters) {};
+	Command(const View& view);
 
     static bool isValid(std::string input);
+    static bool isValid(const char* input, int length) { return length > 0 && input[0] == '<'; }
     static Command parse(std::string input);
 
+	// returns false if the command has more than MAX_PARAMETERS parameters, the rest are ignored
+    static bool tokenize(const char* input, int length, View& view);
+
     std::string name;
     Parameters parameters;
 
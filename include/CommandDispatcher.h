@@ -0,0 +1,75 @@
+#ifndef COMMANDDISPATCHER_H
+#define COMMANDDISPATCHER_H
+
+#include "Command.h"
+#include "StringView.h"
+
+#include <boost/function.hpp>
+#include <string>
+#include <vector>
+
+// routes commands to handlers registered by name and parameter signature through a hash table
+// the signature has a character per parameter: 'i' integer, 'f' float, 's' string
+// a trailing '*' accepts any number of further string parameters
+class CommandDispatcher {
+
+public:
+	// parameters converted according to the signature of the handler
+	class Arguments {
+
+	public:
+		Arguments() : count(0) {}
+
+		int getCount() const { return count; }
+		int getInt(int index) const { return (int)numbers[index]; }
+		float getFloat(int index) const { return (float)numbers[index]; }
+		const StringView& getView(int index) const { return views[index]; }
+		std::string getString(int index) const { return views[index].toString(); }
+
+	private:
+		friend class CommandDispatcher;
+
+		int count;
+		double numbers[Command::MAX_PARAMETERS];
+		StringView views[Command::MAX_PARAMETERS];
+
+	};
+
+	typedef boost::function<void(const Arguments&)> Handler;
+
+	CommandDispatcher(int capacity = 64);
+
+	// several handlers can share a name if their parameter counts differ
+	void add(const std::string& name, const std::string& signature, Handler handler);
+
+	// returns false if no handler matches the name and parameters
+	bool dispatch(const Command::View& command);
+	bool dispatch(const Command& command) { return dispatch(Command::View(command)); }
+
+	int getCount() const { return count; }
+
+private:
+	enum { VARIADIC = -1 };
+
+	struct Entry {
+		Entry() : used(false), parameterCount(0), hash(0) {}
+
+		bool used;
+		std::string name;
+		std::string signature;
+		int parameterCount;
+		unsigned int hash;
+		Handler handler;
+	};
+
+	static unsigned int getHash(unsigned int nameHash, int parameterCount);
+	const Entry* find(const StringView& name, unsigned int nameHash, int parameterCount) const;
+	bool convert(const Entry& entry, const Command::View& command, Arguments& arguments) const;
+
+	std::vector<Entry> entries;
+	unsigned int mask;
+	int count;
+
+};
+
+#endif // COMMANDDISPATCHER_H
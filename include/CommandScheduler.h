@@ -0,0 +1,57 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include "BinaryProtocol.h"
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+// collects outgoing commands between communication ticks and packs them into a single datagram
+// idempotent commands such as speeds only keep their newest value, the rest are sent in order
+class CommandScheduler {
+
+public:
+	CommandScheduler(int capacity);
+
+	// thread-safe, returns false and counts a drop when the pending list is full
+	bool add(const std::string& message);
+	bool addFrame(const unsigned char* data, int length);
+
+	// called by the sending thread, writes the pending commands to the buffer and returns the datagram length, 0 if nothing was due
+	// text commands are sent as newline terminated lines or, if any binary frames are pending or binary is requested, as text frames
+	int flush(unsigned char* buffer, int maxLength, bool binary);
+
+	int getPendingCount() const;
+	int getCoalescedCount() const { return coalescedCount; }
+	int getDroppedCount() const { return droppedCount; }
+	int getDatagramCount() const { return datagramCount; }
+	int getSentCount() const { return sentCount; }
+
+	static bool isIdempotent(const std::string& name);
+
+private:
+	struct Entry {
+		Entry() : frame(false) {}
+
+		std::string name;
+		std::string data;
+		bool frame;
+	};
+
+	Entry* reserve(const std::string& name);
+	int encode(const Entry& entry, unsigned char* buffer, int maxLength, bool binary);
+
+	// entries are reused between ticks so their string buffers are kept
+	std::vector<Entry> entries;
+	int entryCount;
+	int capacity;
+	int coalescedCount;
+	int droppedCount;
+	int datagramCount;
+	int sentCount;
+	mutable boost::mutex mutex;
+
+};
+
+#endif // COMMANDSCHEDULER_H
@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include <string>
+#include <cmath>
 
 namespace Config {
 	enum CommunicationMode {
@@ -14,6 +15,15 @@ namespace Config {
 	//const CommunicationMode communicationMode = SERIAL;
 	//const CommunicationMode communicationMode = COM;
 
+	enum CommunicationProtocol {
+		TEXT_PROTOCOL,
+		BINARY_PROTOCOL
+	};
+
+	// binary protocol is requested from the firmware, text is used until it acknowledges
+	const CommunicationProtocol communicationProtocol = BINARY_PROTOCOL;
+	//const CommunicationProtocol communicationProtocol = TEXT_PROTOCOL;
+
 	// camera serials
 	const int frontCameraSerial = 857769553;
 	const int rearCameraSerial = 857735761;
@@ -31,6 +41,26 @@ namespace Config {
 	const std::string communicationHost = "192.168.4.1";
 	const int communicationPort = 8042;
 
+	// how many received messages can wait for the main loop before new ones are dropped
+	const int communicationQueueSize = 256;
+	const int serverQueueSize = 64;
+
+	// outgoing commands not flushed by the motion control are sent at least this often (ms)
+	const int communicationFlushInterval = 20;
+
+	// how many datagrams can be in flight before outgoing commands are held back
+	const int communicationSendBufferCount = 8;
+
+	// how many queued messages are dequeued at once
+	const int messageBatchSize = 32;
+
+	// port of the local firmware stand-in started with the 'firmware-stub' command line option
+	const int firmwareStubPort = 8043;
+
+	// reply delay in milliseconds and the probability of a reply getting lost of the local firmware stand-in
+	const int firmwareStubDelay = 0;
+	const float firmwareStubLoss = 0.0f;
+
 	// serial device and baud
 	//const std::string serialDeviceContains = "mbed";
 	const std::string serialDeviceContains = "Mbed Virtual";
@@ -38,6 +68,9 @@ namespace Config {
 	const int serialBaud = 115200;
 	//const int serialBaud = 57600;
 
+	// serial receive ring size, longer messages are dropped
+	const int serialReceiveBufferSize = 4096;
+
 	// camera resolution
 	const int cameraWidth = 1280;
 	const int cameraHeight = 1024;
@@ -49,22 +82,98 @@ namespace Config {
 	//const int cameraGain = 6;
 	const int cameraExposure = 10000;
 
+	// a camera that has no new frame in this time in seconds is considered faulty
+	const double cameraFrameTimeout = 0.03;
+
+	// frame slots of a capture thread, the processing and the screenshots hold one each while the next one is written
+	const int captureSlotCount = 4;
+
+	// whether the frame buffer pool backs the image planes with huge pages when the system allows it
+	const bool frameBufferHugePages = true;
+
 	// default startup controller name
 	const std::string defaultController = "test";
 
 	// how big of a buffer to allocate for generating jpeg images
 	const int jpegBufferSize = 5000 * 1024;
 
+	// dash frame streams, frames are dropped for clients that still have more than the given bytes waiting in the socket
+	const int frameStreamFps = 10;
+	const int frameStreamMaxBuffered = 1024 * 1024;
+
+	// how many encoded frames are kept for clients that want the same frame
+	const int frameCacheSize = 4;
+
+	// dash state topics, updates are held back for clients that still have more than the given bytes waiting in the socket
+	const int stateRate = 20;
+	const int stateMaxRate = 60;
+	const int stateMaxBuffered = 256 * 1024;
+
+	// zone trace written by the profile-trace command, open it in chrome://tracing
+	const float profileTraceDuration = 5.0f;
+	const std::string profileTraceFilename = "profile-trace.json";
+
+	// steps of a recording waiting to be written before frames are left out of it, a step takes about two frames
+	const int recordMaxPendingSteps = 30;
+
+	// a real time replay falling behind the recording by more than this continues from where it is (seconds)
+	const double replayMaxLag = 0.1;
+
 	// constants for camera correction
 	//const float cameraCorrectionK = 0.00000049f;
 	//const float cameraCorrectionZoom = 0.969f;
 	//const float cameraCorrectionK = -0.00000013f;
 	//const float cameraCorrectionZoom = 1.100f;
 
+	// camera translator distance model, world y = B + A / (pixel y - horizon), world x = C * pixel x from center / (pixel y - horizon)
+	const float frontCameraA = 120.11218157847301f;
+	const float frontCameraB = -0.037205566171594123f;
+	const float frontCameraC = 0.2124259596292023f;
+	const float frontCameraHorizon = 119.40878f;
+	const float rearCameraA = 116.87509670118826f;
+	const float rearCameraB = -0.024224799830663904f;
+	const float rearCameraC = 0.20843106680747164f;
+	const float rearCameraHorizon = 123.73853f;
+
+	// lens distortion model, not used any more as the distortion mappings replaced it
+	const float cameraDistortionK1 = -0.28f;
+	const float cameraDistortionK2 = 0.07f;
+	const float cameraDistortionK3 = -0.0075f;
+	const float cameraDistortionFocus = 6.904681785333543758e+02f;
+
+	// stage timings slower than the baseline by more than this fraction are reported as regressions by the vision benchmark
+	const float visionBenchmarkTolerance = 0.05f;
+
+	// synthetic frames, scenes are generated from the seed so runs can be compared, sensor noise is the standard
+	// deviation of the raw values and blur the box radius in pixels
+	const unsigned int syntheticSeed = 42;
+	const float syntheticNoise = 4.0f;
+	const int syntheticBlur = 1;
+
+	// a detected ball matches a rendered one within this angle (radians) and relative distance error
+	const float syntheticMatchAngle = 0.1f;
+	const float syntheticMatchDistance = 0.25f;
+
+	// simulated matches, the controller is stepped at the frame rate and the motion control and the physics at its own
+	// frequency, a match ends once all the balls are scored or after the duration (seconds)
+	const float simulatedFrameRate = 60.0f;
+	const float simulatedMatchDuration = 120.0f;
+
+	// ball speed given by the coilgun per microsecond of kick (m/s) and the width of the dribbler catching the ball (meters)
+	const float simulatedKickSpeed = 0.003f;
+	const float simulatedDribblerWidth = 0.08f;
+
 	// field dimensions
 	const float fieldWidth = 4.5f;
 	const float fieldHeight = 3.0f;
 
+	// sizes of the ball, goals and field markings (meters), the black border is outside the white lines
+	const float ballRadius = 0.0215f;
+	const float goalWidth = 0.7f;
+	const float goalHeight = 0.2f;
+	const float fieldLineWidth = 0.05f;
+	const float fieldBorderWidth = 0.2f;
+
 	// confinement factor in meters for confining objects on the field
 	const float confineMargin = 0.0f;
 
@@ -80,6 +189,9 @@ namespace Config {
 	const int ballMinArea = 4;
 	const int goalMinArea = 64;
 
+	// how many balls and goals including the merged ones a frame can have before the rest are dropped
+	const int visionObjectArenaSize = 1024;
+
 	// maximum width/height ratio for objects to be considered valid
 	const float maxBallSizeRatio = 5.0f;
 
@@ -152,6 +264,9 @@ namespace Config {
 	// robot radius
 	const float robotRadius = 0.12425f;
 
+	// robot height
+	const float robotHeight = 0.25f;
+
 	// radius of a wheel
 	const float robotWheelRadius = 0.035f;
 
@@ -192,8 +307,15 @@ namespace Config {
 	// maximum look-at omega is achived is object is at this angle or more
 	const float lookAtMaxSpeedAngle = 45.0f;
 
-	// for how many frames must the real wheel speed vary considerably from target speed to be considered stalled
-	const int robotWheelStalledThreshold = 60;
+	// for how many motion control steps must the real wheel speed vary considerably from target speed to be considered stalled,
+	// about a second like the 60 frames it was counted in when the wheels were stepped at the camera frame rate
+	const int robotWheelStalledThreshold = 200;
+
+	// how often the robot motion control (look-at controller, wheel speeds and the speeds command) is stepped (Hz)
+	const float motionControlFrequency = 200.0f;
+
+	// a single wheel feedback report is never integrated over a longer interval than this (seconds)
+	const float odometryMaxSampleInterval = 0.05f;
 
 	// how long the ball needs to be in the dribbler to be considered stable (seconds)
 	const float ballInDribblerThreshold = 0.0f;
@@ -238,8 +360,17 @@ namespace Config {
 	// minimum kick interval
 	const double minKickInterval = 1.0;
 
-	// maximum time object can be lost and still considered for updating its velocity
-	const double velocityUpdateMaxTime = 0.025;
+	// standard deviation of the observed ball position (meters)
+	const float ballMeasurementNoise = 0.05f;
+
+	// standard deviation of the unmodelled ball acceleration used by the ball filter (m/s^2)
+	const float ballAccelerationNoise = 3.0f;
+
+	// how long it takes from sending the wheel speeds until the motors act on them (seconds)
+	const float robotCommandLatency = 0.02f;
+
+	// tracked balls are never predicted further ahead than this (seconds)
+	const float ballMaxPredictionTime = 0.2f;
 
 	// drag to apply to a rolling object
 	const float rollingDrag = 0.2f;
@@ -259,6 +390,12 @@ namespace Config {
 	// how close to the field-of-view must the object be to be considered in view
 	const float objectFovCloseEnough = 0.5f;
 
+	// how many localized balls to preallocate storage for
+	const int ballLocalizerPoolSize = 64;
+
+	// number of hash buckets in the ball localizer spatial grid
+	const int ballLocalizerGridBuckets = 64;
+
 	// configuration filenames
 	const std::string blobberConfigFilename = "config/blobber.cfg";
 	const std::string frontDistanceLookupFilename = "config/distance-front.cfg";
@@ -20,6 +20,9 @@ public:
 	virtual void onExit() {}
 	virtual bool handleRequest(std::string request) { return false; }
 	virtual bool handleCommand(const Command& cmd) { return false; }
+
+	// in place parsed command, controllers with a dispatch table override this to avoid building a Command
+	virtual bool handleCommand(const Command::View& cmd) { return handleCommand(Command(cmd)); }
 	virtual void handleCommunicationMessage(std::string message) {}
 	virtual Side getTargetSide() { return Side::UNKNOWN; }
 	virtual bool isPlaying() { return false; }
@@ -0,0 +1,34 @@
+#ifndef DISPATCHBENCHMARK_H
+#define DISPATCHBENCHMARK_H
+
+#include "CommandDispatcher.h"
+
+#include <string>
+#include <vector>
+
+// measures how many typical dashboard messages per second get through tokenizing, table lookup, conversion and the handler
+class DispatchBenchmark {
+
+public:
+	DispatchBenchmark();
+
+	void run(int iterations);
+
+private:
+	void handleTargetVector(const CommandDispatcher::Arguments& args);
+	void handleKick(const CommandDispatcher::Arguments& args);
+	void handleParameter(const CommandDispatcher::Arguments& args);
+	void handleBlobberThreshold(const CommandDispatcher::Arguments& args);
+	void handleRequest();
+
+	double measureViews(int iterations);
+	double measureCommands(int iterations);
+
+	CommandDispatcher commands;
+	std::vector<std::string> messages;
+	double sink;
+	int handledCount;
+
+};
+
+#endif // DISPATCHBENCHMARK_H
@@ -15,18 +15,16 @@ public:
 		//std::cout << "SEND: " << message << std::endl;
 	};
 
-	bool gotMessages() {
-		return false;
-	};
-
-	std::string dequeueMessage() {
-		return "";
-	};
-
 	void close() {};
 
+	// plays a message back as if it was received from the robot
+	void receive(const std::string& message) {
+		receiveMessage(StringView(message));
+	}
+
 private:
 	void* run() { return NULL; }
+	void sendFrame(const unsigned char* data, int length) {}
 
 };
 
@@ -2,6 +2,7 @@
 #define ETHERNET_COMMUNICATION_H
 
 #include "AbstractCommunication.h"
+#include "CommandScheduler.h"
 
 #include <boost/thread/mutex.hpp>
 #include <boost/asio.hpp>
@@ -10,6 +11,7 @@
 #include <vector>
 #include <stack>
 #include <queue>
+#include <atomic>
 
 using boost::asio::ip::udp;
 
@@ -17,34 +19,51 @@ class EthernetCommunication : public AbstractCommunication {
 
 public:
 	
-	EthernetCommunication(std::string host = "127.0.0.1", int port = 8042);
+	EthernetCommunication(std::string host = "127.0.0.1", int port = 8042, int localPort = -1);
 	~EthernetCommunication();
 
 	void send(std::string message);
-	bool gotMessages();
-	std::string dequeueMessage();
+	void flush();
 	void close();
+	SendStats getSendStats() const;
 
 private:
+	struct SendBuffer {
+		unsigned char data[MAX_SIZE];
+	};
+
 	void* run();
 	void onReceive(const boost::system::error_code& error, size_t bytesReceived);
-	void onSend(const boost::system::error_code& error, size_t bytesSent);
+	void onSend(const boost::system::error_code& error, size_t bytesSent, SendBuffer* buffer);
 	void receiveNext();
+	void sendFrame(const unsigned char* data, int length);
+	void sendPending();
+	void scheduleFlush();
+	void onFlushTimer(const boost::system::error_code& error);
 
 	std::string host;
 	int port;
+	int localPort;
 	char receiveBuffer[MAX_SIZE];
 	boost::asio::mutable_buffers_1 receiveBuffer2;
 	//boost::array<char, 1024> receiveBuffer;
-	char requestBuffer[MAX_SIZE];
+	unsigned char requestBuffer[MAX_SIZE];
+	std::vector<SendBuffer*> sendBuffers;
+	std::stack<SendBuffer*> freeSendBuffers;
+	// written on the io thread and read with the send stats
+	std::atomic<int> sendsInFlight;
+	std::atomic<int> maxSendsInFlight;
+	std::atomic<int> backPressureCount;
+	std::atomic<int> sendErrorCount;
 	boost::asio::io_service ioService;
 	udp::socket* socket;
 	udp::endpoint endpoint;
 	boost::asio::ip::udp::endpoint remoteEndpoint;
-	Messages messages;
-	Messages queuedMessages;
-	bool running;
-	mutable boost::mutex messagesMutex;
+	boost::asio::deadline_timer flushTimer;
+	CommandScheduler scheduler;
+	std::atomic<bool> flushPosted;
+	std::atomic<bool> running;
+	boost::mutex closeMutex;
 };
 
 #endif // ETHERNET_COMMUNICATION_H
\ No newline at end of file
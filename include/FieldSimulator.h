@@ -0,0 +1,134 @@
+#ifndef FIELDSIMULATOR_H
+#define FIELDSIMULATOR_H
+
+#include "Config.h"
+#include "Maths.h"
+#include "Vision.h"
+#include "Histogram.h"
+#include "Odometer.h"
+#include "FrameGenerator.h"
+#include "AbstractCommunication.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+class Robot;
+class TestController;
+class CameraTranslator;
+
+// plays the field, the cameras and the firmware for the test controller so whole matches run headless and faster than
+// real time on a simulated clock
+//
+// the wheel speeds sent by the robot act after the command latency and move it with the odometer kinematics, the balls
+// roll with the drag the ball localizer assumes, are caught by the running dribbler, pushed by the robot and kicked by
+// the coilgun, the vision results are objects projected from the field geometry with the camera translators, without
+// rendering frames or occlusions
+//
+// every match starts from the reset of the controller with random balls and ends once they are all scored or after
+// Config::simulatedMatchDuration, the controller step cost, the time to score and the time spent in and the
+// transitions between the controller states are reported over all the matches
+class FieldSimulator : public AbstractCommunication {
+
+public:
+	FieldSimulator();
+	~FieldSimulator();
+
+	void simulate(int matchCount, int ballCount);
+
+	// writes the results to the file or to the standard output without a filename
+	bool save(const std::string& filename);
+	std::string getJSON();
+
+	void send(std::string message);
+	void close() {}
+
+private:
+	struct Ball {
+		Ball(float x, float y) : x(x), y(y), velocityX(0.0f), velocityY(0.0f), held(false) {}
+
+		float x;
+		float y;
+		float velocityX;
+		float velocityY;
+		bool held;
+	};
+
+	struct Speeds {
+		Speeds() : time(0.0) { for (int i = 0; i < 5; i++) values[i] = 0; }
+
+		double time;
+		int values[5];
+	};
+
+	struct StateStats {
+		StateStats() : entries(0), duration(0.0f) {}
+
+		int entries;
+		float duration;
+	};
+
+	typedef std::vector<Ball> BallList;
+	typedef std::map<std::string, StateStats> StateMap;
+	typedef std::map<std::string, int> TransitionMap;
+
+	void setup();
+	void runMatch(int ballCount);
+	void stepFrame(float dt);
+	void stepPhysics(float dt);
+	void stepBall(Ball& ball, float dt);
+	void kick(int microseconds);
+	int getDribblerBall();
+	void updateResult(Vision::Result& result, Dir dir);
+	Object* createObject(Vision::Result& result, Dir dir, float x1, float y1, float x2, float y2, int type, bool round);
+	Vision::ColorDistance getColorDistance(Vision::Result& result, Dir dir, FrameGenerator::Surface surface);
+	float getColorDistance(Vision::Result& result, Dir dir, FrameGenerator::Surface surface, int x2, int y2);
+	void handleCommand(const std::string& message);
+	void reply(const std::string& message, bool binary = false);
+	void* run() { return NULL; }
+	void sendFrame(const unsigned char* data, int length);
+
+	int width;
+	int height;
+	double time;
+	int frameNumber;
+	Robot* robot;
+	TestController* controller;
+	Odometer* odometer;
+	CameraTranslator* frontCameraTranslator;
+	CameraTranslator* rearCameraTranslator;
+	Vision* frontVision;
+	Vision* rearVision;
+	Vision::Result frontResult;
+	Vision::Result rearResult;
+	Vision::Results visionResults;
+	FrameGenerator::GoalEdgeList goalEdges;
+
+	Math::Position position;
+	BallList balls;
+	std::deque<Speeds> pendingSpeeds;
+	Speeds speeds;
+	Odometer::Movement movement;
+	bool charging;
+	bool firmwareBinary;
+
+	double matchStartTime;
+	double lastGoalTime;
+	std::string lastStateName;
+	int matchCount;
+	int ballCount;
+	int goalCount;
+	int ownGoalCount;
+	int kickCount;
+	float simulatedDuration;
+	double realDuration;
+	Histogram controllerDurations;
+	Histogram robotDurations;
+	Histogram scoreTimes;
+	StateMap states;
+	TransitionMap transitions;
+
+};
+
+#endif // FIELDSIMULATOR_H
@@ -0,0 +1,80 @@
+#ifndef FIRMWARESTUB_H
+#define FIRMWARESTUB_H
+
+#include "Thread.h"
+#include "BinaryProtocol.h"
+
+#include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <atomic>
+
+// local stand-in for the robot firmware, echoes target speeds as measured speeds and acknowledges the binary protocol
+// listens on UDP loopback or on a serial device, replies can be delayed and lost to emulate a real link
+class FirmwareStub : public Thread {
+
+public:
+	// UDP on 127.0.0.1:port
+	FirmwareStub(int port);
+
+	// serial device, on POSIX systems the device "pty" creates a pseudo terminal that is opened with getDeviceName()
+	FirmwareStub(const std::string& device, int baud);
+
+	~FirmwareStub();
+
+	// must be set before the stub is started
+	void setDelay(int milliseconds) { delay = milliseconds; }
+	void setLoss(float probability) { loss = probability; }
+
+	// opened by the stub thread unless done before, opening early makes the pseudo terminal name available
+	bool open();
+	void close();
+
+	std::string getDeviceName() const { return deviceName; }
+	// commands received, replies sent and replies lost on purpose
+	int getReceivedCount() const { return receivedCount; }
+	int getRepliedCount() const { return repliedCount; }
+	int getLostCount() const { return lostCount; }
+
+private:
+	enum { MAX_SIZE = 4098 };
+
+	void* run();
+	void receiveNext();
+	void onReceive(const boost::system::error_code& error, size_t bytesReceived);
+	void handleDatagram(const unsigned char* data, int length);
+	void handleStream(const unsigned char* data, int length);
+	void handleCommand(const std::string& message);
+	void reply(const std::string& message);
+	void reply(const unsigned char* data, int length);
+	void replySpeeds();
+	void transmit(boost::shared_ptr<std::string> data, boost::asio::ip::udp::endpoint endpoint);
+	void onDelayed(const boost::system::error_code& error, boost::shared_ptr<boost::asio::deadline_timer> timer, boost::shared_ptr<std::string> data, boost::asio::ip::udp::endpoint endpoint);
+
+	int port;
+	std::string device;
+	std::string deviceName;
+	int baud;
+	int delay;
+	float loss;
+	bool running;
+	bool binaryProtocol;
+	bool charging;
+	int speeds[5];
+	std::atomic<int> receivedCount;
+	std::atomic<int> repliedCount;
+	std::atomic<int> lostCount;
+	unsigned char receiveBuffer[MAX_SIZE];
+	std::string line;
+	boost::asio::io_service ioService;
+	boost::asio::ip::udp::socket* socket;
+	boost::asio::ip::udp::endpoint senderEndpoint;
+	boost::asio::serial_port* serialPort;
+#ifndef _WIN32
+	boost::asio::posix::stream_descriptor* pty;
+#endif
+	BinaryProtocol::Decoder decoder;
+
+};
+
+#endif // FIRMWARESTUB_H
@@ -0,0 +1,55 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <boost/thread/mutex.hpp>
+#include <stddef.h>
+#include <vector>
+
+// shared pool of the image planes of the frame processing
+//
+// every buffer starts at a multiple of ALIGNMENT bytes and its size is rounded up to one, so the simd conversion and
+// classification kernels can use their aligned loads and read a vector past the last pixel, the large buffers are
+// backed by huge pages when Config::frameBufferHugePages is set and the system allows it
+//
+// a buffer belongs to whoever acquired it until it is released back to the pool, released buffers are kept and handed
+// out again for the same format and resolution, so planes that are only needed while debugging can be borrowed and
+// released as often as the debug consumers come and go without touching the system allocator
+class FrameBufferPool {
+
+public:
+	enum Format {
+		BAYER_FORMAT, // 8 bit raw rggb as the cameras give it
+		Y_PLANE, // 8 bit luma
+		CHROMA_PLANE, // 8 bit u or v at half the resolution in both directions
+		YUYV_FORMAT, // packed 4:2:2, 2 bytes per pixel
+		RGB_FORMAT, // 3 bytes per pixel, also the classification images
+		ARGB_FORMAT, // 4 bytes per pixel
+		FORMAT_COUNT
+	};
+
+	static const int ALIGNMENT = 64;
+
+	static size_t getSize(Format format, int width, int height);
+	static const char* getFormatName(Format format);
+
+	// returns NULL when out of memory
+	static unsigned char* acquire(Format format, int width, int height);
+
+	// releasing NULL does nothing
+	static void release(unsigned char* data);
+
+private:
+	struct Buffer {
+		unsigned char* data;
+		size_t size;
+		bool acquired;
+	};
+
+	typedef std::vector<Buffer> BufferList;
+
+	static BufferList buffers;
+	static boost::mutex mutex;
+
+};
+
+#endif // FRAMEBUFFERPOOL_H
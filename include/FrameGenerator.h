@@ -0,0 +1,129 @@
+#ifndef FRAMEGENERATOR_H
+#define FRAMEGENERATOR_H
+
+#include "Config.h"
+#include "Maths.h"
+#include "Blobber.h"
+
+#include <string>
+#include <vector>
+
+class CameraTranslator;
+
+// renders raw RGGB bayer frames of a world scene as the front or rear camera would see it
+//
+// the field, its lines and border, the goals, balls and other robots are projected with the camera translator distance
+// model and the distortion mapping, the colors are picked so that the thresholds of the blobber classify them as the
+// colors they stand for, optionally blurred and with sensor noise
+class FrameGenerator {
+
+public:
+	enum Surface {
+		BALL_SURFACE,
+		YELLOW_GOAL_SURFACE,
+		BLUE_GOAL_SURFACE,
+		WHITE_SURFACE,
+		GREEN_SURFACE,
+		BLACK_SURFACE,
+		NONE_SURFACE,
+		SURFACE_COUNT
+	};
+
+	struct Scene {
+		Math::Position robot;
+		Math::PointList balls;
+		Math::PointList robots;
+	};
+
+	// ball the camera should see, in the same terms as the vision objects
+	struct VisibleBall {
+		VisibleBall(float distance, float angle) : distance(distance), angle(angle) {}
+
+		float distance;
+		float angle;
+	};
+
+	typedef std::vector<VisibleBall> VisibleBallList;
+
+	// vertical goal edge at a strip boundary in undistorted camera coordinates
+	struct GoalEdge {
+		GoalEdge() : visible(false), forward(0.0f), topX(0.0f), topY(0.0f), bottomX(0.0f), bottomY(0.0f) {}
+
+		bool visible;
+		float forward;
+		float topX, topY, bottomX, bottomY;
+	};
+
+	typedef std::vector<GoalEdge> GoalEdgeList;
+
+	FrameGenerator(Blobber* blobber, CameraTranslator* frontCameraTranslator, CameraTranslator* rearCameraTranslator, int width, int height);
+	~FrameGenerator();
+
+	void setScene(const Scene& scene) { this->scene = scene; }
+	const Scene& getScene() const { return scene; }
+	void setNoise(float noise) { this->noise = noise; }
+	void setBlur(int blur) { this->blur = blur; }
+	int getFrameSize() const { return width * height; }
+
+	// returns the rendered frame, valid until the next render
+	unsigned char* render(Dir dir);
+
+	// balls in front of the camera and inside its frame, hidden ones included
+	VisibleBallList getVisibleBalls(Dir dir);
+
+	static Scene getRandomScene(int ballCount, int robotCount);
+
+	// what covers the ground at the field coordinates, the lines, the border and the surroundings
+	static Surface getGroundSurface(float x, float y);
+
+	// distance of a field point in front of and to the right of the camera of the robot
+	static void getCameraCoordinates(const Math::Position& robot, Dir dir, float x, float y, float& forward, float& right);
+
+	// undistorted camera coordinates of a point at a height above the ground, false when it is too close or behind
+	static bool project(CameraTranslator* translator, int width, float forward, float right, float height, float& cameraX, float& cameraY);
+
+	// goals are projected as vertical strips so the partly visible ones are seen, the edges between them are listed in order
+	static void projectGoalEdges(const Math::Position& robot, Dir dir, CameraTranslator* translator, int width, float goalX, GoalEdgeList& edges);
+
+private:
+	// object outline in undistorted camera coordinates, the closest one covers the others
+	struct Shape {
+		Shape(float depth, Surface surface, float x1, float y1, float x2, float y2, bool round) : depth(depth), surface(surface), x1(x1), y1(y1), x2(x2), y2(y2), round(round) {}
+
+		bool operator < (const Shape& other) const { return depth > other.depth; }
+
+		float depth;
+		Surface surface;
+		float x1, y1, x2, y2;
+		bool round;
+	};
+
+	void pickColors(Blobber* blobber);
+	Blobber::Rgb pickColor(Blobber* blobber, const std::string& name);
+	void addShapes(Dir dir, CameraTranslator* translator);
+	void addGoalShapes(Dir dir, CameraTranslator* translator, float goalX, Surface surface);
+	void drawGround(Dir dir, CameraTranslator* translator);
+	void drawShape(const Shape& shape);
+	void applyDistortion(CameraTranslator* translator);
+	void applyBlur();
+	void applyMosaic();
+
+	int width;
+	int height;
+	float noise;
+	int blur;
+	Scene scene;
+	CameraTranslator* frontCameraTranslator;
+	CameraTranslator* rearCameraTranslator;
+	Blobber::Rgb colors[SURFACE_COUNT];
+	std::vector<Shape> shapes;
+	GoalEdgeList goalEdges;
+
+	unsigned char* surfaces;
+	unsigned char* dataRGB;
+	unsigned char* dataBlur;
+	unsigned char* dataBayer;
+
+};
+
+#endif // FRAMEGENERATOR_H
@@ -0,0 +1,137 @@
+#ifndef FRAMESTREAMER_H
+#define FRAMESTREAMER_H
+
+#include "Thread.h"
+#include "Server.h"
+#include "Config.h"
+#include "Blobber.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+
+// encodes debug frames for the dash on its own thread and sends them as binary web socket messages
+//
+// every client has a subscription with its own frame rate, an encoded frame is shared by all clients that get it
+// and clients whose socket is still busy with a previous frame skip frames instead of queueing them
+//
+// message layout, little endian:
+//   uint8 type, uint8 camera, uint32 frame number, uint16 width, uint16 height,
+//   uint32 rgb jpeg length, uint32 classification length, uint8 stream name length,
+//   stream name, rgb jpeg, classification
+//
+// the classification is a jpeg image or, for run messages, the blobber runs:
+//   uint8 color count, rgb of each color, then every run as uint8 color index + 1 (0 for none)
+//   and the run length as a base 128 varint, the runs of each row add up to the width
+class FrameStreamer : public Thread {
+
+public:
+	enum MessageType {
+		FRAME_MESSAGE = 1,
+		RUNS_FRAME_MESSAGE = 2
+	};
+
+	enum ClassificationFormat {
+		JPEG_CLASSIFICATION,
+		RUN_CLASSIFICATION
+	};
+
+	enum { HEADER_SIZE = 19 };
+
+	// decided once per frame before it is processed, so the frame gets rendered and encoded for the same clients
+	struct Request {
+		Request() : wanted(false) {
+			formats[JPEG_CLASSIFICATION] = formats[RUN_CLASSIFICATION] = false;
+		}
+
+		bool wanted; // some client is due a frame and the encoder is free, debug output needs to be rendered only then
+		bool formats[2]; // the classification formats to encode, the classification image is only needed for jpeg
+	};
+
+	struct Stats {
+		Stats() : encoded(0), cacheHits(0), sent(0), dropped(0), skipped(0) {}
+
+		int encoded;
+		int cacheHits;
+		int sent;
+		int dropped;
+		int skipped;
+	};
+
+	FrameStreamer(Server* server, int width, int height);
+	~FrameStreamer();
+
+	// a frame rate of 0 cancels the subscription, a single frame can be requested with or without one
+	void subscribe(Server::Client* client, int fps, ClassificationFormat format = JPEG_CLASSIFICATION);
+	void requestFrame(Server::Client* client);
+
+	Request getRequest();
+
+	// copies the images and the blobber runs the request asked for to the encoder thread, returns false when the
+	// previous frame is still being encoded
+	bool submit(const Request& request, unsigned char* rgb, unsigned char* classification, Blobber* blobber, int frameNumber, Dir camera, const std::string& streamName);
+
+	void close();
+	Stats getStats();
+
+private:
+	struct Subscription {
+		Subscription() : clientId(-1), format(JPEG_CLASSIFICATION), interval(0.0), lastSendTime(0.0), lastFrameNumber(-1), once(false) {}
+
+		int clientId;
+		websocketpp::connection_hdl connection;
+		ClassificationFormat format;
+		double interval;
+		double lastSendTime;
+		int lastFrameNumber;
+		bool once;
+	};
+
+	struct EncodedFrame {
+		int frameNumber;
+		boost::shared_ptr<std::string> messages[2];
+		int sendCount;
+	};
+
+	typedef std::vector<Subscription> Subscriptions;
+
+	void* run();
+	Subscription* getSubscription(Server::Client* client);
+	bool isDue(const Subscription& subscription, double time) const;
+	bool isFormatDue(ClassificationFormat format, double time) const;
+	bool encode(EncodedFrame& encoded);
+	void encodeHeader(std::string& message, MessageType type, int rgbSize, int classificationSize);
+	void encodeRuns(std::string& message);
+	void deliver(boost::mutex::scoped_lock& lock);
+
+	Server* server;
+	int width;
+	int height;
+	bool running;
+	bool pending;
+	bool encoding;
+	bool requested;
+	Subscriptions subscriptions;
+	std::deque<EncodedFrame> cache;
+	Stats stats;
+
+	// written by the main loop while pending is false, read by the encoder while it is true
+	std::vector<unsigned char> rgb;
+	std::vector<unsigned char> classification;
+	std::vector<Blobber::ColorRun> runs;
+	std::vector<Blobber::Rgb> colors;
+	bool formats[2];
+	int frameNumber;
+	Dir camera;
+	std::string streamName;
+
+	std::vector<unsigned char> jpegBuffer;
+	boost::mutex mutex;
+	boost::condition_variable condition;
+
+};
+
+#endif // FRAMESTREAMER_H
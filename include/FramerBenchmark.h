@@ -0,0 +1,27 @@
+#ifndef FRAMERBENCHMARK_H
+#define FRAMERBENCHMARK_H
+
+#include <string>
+#include <vector>
+
+// replays a captured serial byte stream through the line framer in irregular chunks as fast as possible
+// and checks that the same frames come out as when the whole stream is framed at once
+class FramerBenchmark {
+
+public:
+	FramerBenchmark();
+
+	// without a capture file a stream of typical firmware output with some noise is generated
+	bool load(const std::string& filename);
+	void generate(int messageCount);
+	void run(int passes);
+
+private:
+	// a chunk size of 0 writes as much of the stream at once as the framer accepts
+	int frame(int maxChunkSize, std::vector<std::string>* frames);
+
+	std::vector<char> stream;
+
+};
+
+#endif // FRAMERBENCHMARK_H
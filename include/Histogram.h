@@ -0,0 +1,40 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "Platform.h"
+
+#include <string>
+
+// counts values into buckets that are a quarter of a power of two wide, so it has a fixed size and cost however
+// many values are added and the percentiles are within about 12% of the real value, the extremes are exact
+class Histogram {
+
+public:
+	Histogram() { clear(); }
+
+	void clear();
+	void add(__int64 value);
+	int getCount() const { return count; }
+	double getMean() const { return count > 0 ? (double)sum / count : 0.0; }
+	__int64 getMin() const { return min; }
+	__int64 getMax() const { return max; }
+	double getPercentile(double fraction) const;
+
+	// count, mean, min, p50, p90, p99 and max with the values divided by the unit
+	std::string toJSON(double unit) const;
+
+private:
+	enum { BUCKET_COUNT = 160 };
+
+	static int getBucket(__int64 value);
+	static __int64 getBucketStart(int bucket);
+
+	int buckets[BUCKET_COUNT];
+	int count;
+	__int64 sum;
+	__int64 min;
+	__int64 max;
+
+};
+
+#endif // HISTOGRAM_H
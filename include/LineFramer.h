@@ -0,0 +1,51 @@
+#ifndef LINEFRAMER_H
+#define LINEFRAMER_H
+
+#include "BinaryProtocol.h"
+#include "StringView.h"
+
+#include <vector>
+
+// reassembles '<...>' messages and binary frames from a byte stream kept in a fixed-size ring buffer
+// bytes between messages such as line feeds are skipped, a message restarts at an unexpected '<'
+class LineFramer {
+
+public:
+	LineFramer(int minCapacity);
+
+	// returns how many bytes fit, the caller should take the complete frames and write the rest
+	int write(const char* data, int length);
+
+	// binary frames are converted to their text form, the view is valid until the next call to write() or next()
+	bool next(StringView& frame);
+
+	// whether the last frame returned by next() was a binary one
+	bool isBinary() const { return binary; }
+
+	void clear() { head = tail; }
+	int getCapacity() const { return capacity; }
+	int getFrameCount() const { return frameCount; }
+	int getErrorCount() const { return errorCount; }
+	int getDroppedByteCount() const { return droppedByteCount; }
+
+private:
+	char at(int offset) const { return buffer[(head + offset) & mask]; }
+	int find(char character, int from, int available) const;
+	StringView view(int length);
+
+	std::vector<char> buffer;
+	int capacity;
+	unsigned int mask;
+	unsigned int head;
+	unsigned int tail;
+	char scratch[BinaryProtocol::MAX_TEXT_SIZE];
+	std::vector<char> wrapped;
+	BinaryProtocol::Decoder decoder;
+	bool binary;
+	int frameCount;
+	int errorCount;
+	int droppedByteCount;
+
+};
+
+#endif // LINEFRAMER_H
@@ -2,6 +2,7 @@
 #define MANUALCONTROLLER_H
 
 #include "Controller.h"
+#include "CommandDispatcher.h"
 #include "Vision.h"
 #include "DebouncedButton.h"
 #include "Config.h"
@@ -13,17 +14,20 @@ public:
 
 	void onEnter() { reset(); }
 	void onExit() { reset(); }
-    bool handleCommand(const Command& cmd);
-    void handleTargetVectorCommand(const Command& cmd);
-    void handleTargetDirCommand(const Command& cmd);
-    void handleSetDribblerCommand(const Command& cmd);
-    void handleKickCommand(const Command& cmd);
+    bool handleCommand(const Command& cmd) { return commands.dispatch(cmd); }
+    bool handleCommand(const Command::View& cmd) { return commands.dispatch(cmd); }
+    void handleTargetVectorCommand(const CommandDispatcher::Arguments& args);
+    void handleTargetDirCommand(const CommandDispatcher::Arguments& args);
+    void handleSetDribblerCommand(const CommandDispatcher::Arguments& args);
+    void handleKickCommand(const CommandDispatcher::Arguments& args);
+    void handleResetPositionCommand(const CommandDispatcher::Arguments& args);
 	void handleCommunicationMessage(std::string message);
     void step(float dt, Vision::Results* visionResults);
 	void reset();
 	std::string getJSON();
 
 private:
+	CommandDispatcher commands;
 	double lastCommandTime;
 
 };
@@ -0,0 +1,48 @@
+#ifndef MOTIONTHREAD_H
+#define MOTIONTHREAD_H
+
+#include "Thread.h"
+
+#include <boost/thread/mutex.hpp>
+
+class Robot;
+
+// steps robot motion control at a fixed rate independent of the camera frame rate
+class MotionThread : public Thread {
+
+public:
+	struct Stats {
+		Stats() : rate(0.0f), jitter(0.0f), maxJitter(0.0f), overrunCount(0) {}
+
+		float rate;
+		float jitter;
+		float maxJitter;
+		int overrunCount;
+	};
+
+	MotionThread(Robot* robot, float frequency);
+
+	void stop();
+
+	Stats getStats();
+
+private:
+	void* run();
+	bool isRunning();
+	void updateStats(float dt, bool overrun);
+
+	Robot* robot;
+	float period;
+	bool running;
+	boost::mutex mutex;
+
+	double windowStartTime;
+	int windowTicks;
+	float windowSquaredError;
+	float windowMaxError;
+
+	Stats stats;
+
+};
+
+#endif // MOTIONTHREAD_H
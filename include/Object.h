@@ -6,6 +6,8 @@
 
 #include <vector>
 
+class ObjectArena;
+
 class Object {
 
 public:
@@ -14,9 +16,10 @@ public:
 	bool intersects(Object* other, int margin = 0) const;
 	float getDribblerDistance() { return Math::max(distance - Config::robotDribblerDistance, 0.0f); };
 	bool contains(Object* other) const;
-	Object* mergeWith(Object* other) const;
+	Object* mergeWith(Object* other, ObjectArena& arena) const;
 
-	static std::vector<Object*> mergeOverlapping(const std::vector<Object*>& set, int margin = 0, bool requireSameType = false);
+	// merges the objects taken from the stack into the individuals, the merged ones are created in the arena
+	static void mergeOverlapping(std::vector<Object*>& stack, std::vector<Object*>& individuals, ObjectArena& arena, int margin = 0, bool requireSameType = false);
 
     int x;
     int y;
@@ -0,0 +1,54 @@
+#ifndef OBJECTARENA_H
+#define OBJECTARENA_H
+
+#include "Config.h"
+#include "Object.h"
+
+#include <vector>
+
+// fixed pool of the objects detected in a frame, stored by value next to each other and reset all at once
+// before the next frame instead of allocating and deleting every object, the objects are stamped with the frame time
+class ObjectArena {
+
+public:
+	ObjectArena(int capacity = Config::visionObjectArenaSize) : objects(capacity), count(0), overflowCount(0), timestamp(0.0) {}
+
+	void reset(double frameTimestamp) {
+		count = 0;
+		overflowCount = 0;
+		timestamp = frameTimestamp;
+	}
+
+	// returns a copy of the object living until the next reset or NULL and counts an overflow when full
+	Object* create(const Object& object) {
+		if (count >= (int)objects.size()) {
+			overflowCount++;
+
+			return NULL;
+		}
+
+		Object* created = &objects[count++];
+
+		created->copyFrom(&object);
+		created->lastSeenTime = timestamp;
+
+		return created;
+	}
+
+	int getCount() const { return count; }
+	int getCapacity() const { return (int)objects.size(); }
+	int getOverflowCount() const { return overflowCount; }
+
+private:
+	// the lists of the results point into the pool
+	ObjectArena(const ObjectArena&);
+	ObjectArena& operator=(const ObjectArena&);
+
+	std::vector<Object> objects;
+	int count;
+	int overflowCount;
+	double timestamp;
+
+};
+
+#endif // OBJECTARENA_H
@@ -0,0 +1,60 @@
+#ifndef ODOMETRYACCUMULATOR_H
+#define ODOMETRYACCUMULATOR_H
+
+#include "AbstractCommunication.h"
+#include "TripleBuffer.h"
+
+#include <string>
+
+class Odometer;
+
+// integrates wheel feedback as it arrives on the communication thread, motion control consumes the pose delta since its last step
+class OdometryAccumulator : public AbstractCommunication::ReceiveListener {
+
+public:
+	struct Delta {
+		Delta() : dx(0.0f), dy(0.0f), dOrientation(0.0f), duration(0.0f), sampleCount(0) {}
+
+		// extends the interval by a delta that follows it
+		void append(const Delta& next);
+
+		// translation expressed in the robot frame at the end of the interval
+		float dx;
+		float dy;
+		float dOrientation;
+		float duration;
+		int sampleCount;
+	};
+
+	OdometryAccumulator();
+	~OdometryAccumulator();
+
+	void onCommunicationReceive(const StringView& message);
+	Delta consume();
+
+private:
+	struct Pose {
+		Pose() : x(0.0), y(0.0), orientation(0.0), time(0.0), sampleCount(0) {}
+
+		double x;
+		double y;
+		double orientation;
+		double time;
+		int sampleCount;
+	};
+
+	bool parseSpeeds(const StringView& message, int speeds[4]);
+
+	// owned by the communication thread
+	Odometer* odometer;
+	Pose pose;
+	double lastSampleTime;
+
+	// owned by the consumer
+	Pose consumed;
+
+	TripleBuffer<Pose> poses;
+
+};
+
+#endif // ODOMETRYACCUMULATOR_H
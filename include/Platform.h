@@ -0,0 +1,43 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <string.h>
+
+typedef long long __int64;
+
+#define _strdup strdup
+#endif
+
+#include <string>
+#include <vector>
+
+// the operating system specific clocks, sleeping, memory and directory listing
+//
+// everything else goes through these, Util and the pthread based Thread, so the vision, localization and control core
+// builds on other systems than Windows too
+class Platform {
+
+public:
+	// coarse monotonic clock in milliseconds, wraps around like timeGetTime
+	static unsigned int getMilliseconds();
+
+	// high resolution monotonic counter and its ticks per second
+	static __int64 getCounter();
+	static __int64 getCounterFrequency();
+
+	// a sleep of 0 gives the rest of the time slice to other threads
+	static void sleep(int milliseconds);
+
+	// memory aligned to at least the given power of two, backed by huge pages if asked and the system allows it
+	static void* allocateAligned(size_t size, size_t alignment, bool hugePages);
+	static void freeAligned(void* data);
+
+	// names of the regular files in a directory
+	static std::vector<std::string> getFilesInDir(const std::string& path);
+
+};
+
+#endif // PLATFORM_H
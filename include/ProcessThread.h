@@ -4,6 +4,7 @@
 #include "Thread.h"
 #include "Config.h"
 #include "Vision.h"
+#include "CaptureThread.h"
 
 class BaseCamera;
 class Blobber;
@@ -11,7 +12,8 @@ class Blobber;
 class ProcessThread : public Thread {
 
 public:
-	ProcessThread(BaseCamera* camera, Blobber* blobber, Vision* vision);
+	// without a capture thread the frames are fetched from the camera at the start of every run, as the replay needs
+	ProcessThread(BaseCamera* camera, Blobber* blobber, Vision* vision, CaptureThread* capture = NULL);
 	~ProcessThread();
 
 	//void setFrame(unsigned char* data) { frame = data; };
@@ -23,14 +25,25 @@ public:
 
 	bool debug;
 
+	// renders the classification image in debug mode, not needed when only the blobber runs are shown
+	bool classify;
+
 	BaseCamera* camera;
+	CaptureThread* capture;
 	Blobber* blobber;
 	Vision* vision;
 	Vision::Result* visionResult;
 
 	bool gotFrame;
 	bool faulty;
+
+	// the frame stays valid until the next run, with a capture thread its slot is held until then
 	unsigned char* frame;
+	CaptureThread::Slot* frameSlot;
+	double frameTimestamp;
+	int frameNumber;
+
+	// planes from the frame buffer pool, the debug images are NULL unless debug is set
 	unsigned char* dataYUYV;
 	unsigned char* dataY;
     unsigned char* dataU;
@@ -42,6 +55,7 @@ public:
 private:
 	void* run();
 	bool fetchFrame();
+	void updateDebugBuffers();
 
 	bool done;
 };
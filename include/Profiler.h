@@ -0,0 +1,131 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Util.h"
+#include "Histogram.h"
+
+#include <boost/thread/mutex.hpp>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+
+// measures how long the stages of the frame processing take
+//
+// a scope records the start and end of a zone from the nanosecond clock into a ring buffer of the calling thread,
+// writing a record takes no locks, the main loop collects the rings once a frame into a histogram per zone and
+// optionally writes the records to a chrome trace file (load it in chrome://tracing)
+//
+// rings are reused by threads started later, so the thread ids of the trace follow the ring and not the thread
+class Profiler {
+
+public:
+	enum Zone {
+		FRAME_ZONE,
+		FETCH_ZONE,
+		BAYER_ZONE,
+		YUYV_ZONE,
+		BLOBBER_ZONE,
+		CLASSIFY_ZONE,
+		DEBUG_IMAGE_ZONE,
+		VISION_ZONE,
+		SERVER_ZONE,
+		COMMUNICATION_ZONE,
+		CONTROLLER_ZONE,
+		ROBOT_ZONE,
+		MOTION_ZONE,
+		STATE_ZONE,
+		PROFILER_ZONE,
+		ZONE_COUNT
+	};
+
+	class Scope {
+
+	public:
+		Scope(Zone zone) : zone(zone), start(Util::nanotime()) {}
+		~Scope() { end(); }
+
+		// ends the current zone and starts the next one at the same time
+		void next(Zone nextZone) {
+			__int64 time = Util::nanotime();
+
+			if (zone != ZONE_COUNT) {
+				Profiler::record(zone, start, time);
+			}
+
+			zone = nextZone;
+			start = time;
+		}
+
+		void end() {
+			if (zone != ZONE_COUNT) {
+				Profiler::record(zone, start, Util::nanotime());
+
+				zone = ZONE_COUNT;
+			}
+		}
+
+	private:
+		Zone zone;
+		__int64 start;
+
+	};
+
+	static const char* getZoneName(Zone zone);
+
+	static void record(Zone zone, __int64 start, __int64 end);
+
+	// moves the records of all rings into the histograms and the trace, called by a single thread
+	static void collect();
+
+	// times empty scopes on the calling thread, the records are left out of the histograms
+	static double measureOverhead(int iterations = 10000);
+
+	static void reset();
+	static bool startTrace(const std::string& filename, double duration);
+	static void stopTrace();
+
+	// durations are in milliseconds, the overhead of a scope in nanoseconds
+	static std::string getJSON();
+
+private:
+	enum { RING_SIZE = 4096 };
+
+	struct Entry {
+		__int64 start;
+		__int64 end;
+		int zone;
+	};
+
+	struct Ring {
+		Ring() : head(0), read(0), id(0), used(false) {}
+
+		Entry entries[RING_SIZE];
+		std::atomic<unsigned int> head;
+		unsigned int read;
+		int id;
+		bool used;
+	};
+
+	static pthread_key_t createRingKey();
+	static Ring* getRing();
+	static void releaseRing(void* ring);
+	static void collectRing(Ring* ring);
+	static void traceEntry(const Entry& entry, int threadId);
+
+	static std::vector<Ring*> rings;
+	static Histogram histograms[ZONE_COUNT];
+	static pthread_key_t ringKey;
+	static boost::mutex mutex;
+	static double overhead;
+	static int lostCount;
+	static std::ofstream* trace;
+	static std::string traceFilename;
+	static __int64 traceStartTime;
+	static __int64 traceEndTime;
+	static int traceEventCount;
+
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,89 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "Thread.h"
+#include "Config.h"
+#include "Platform.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <string>
+#include <deque>
+#include <vector>
+#include <fstream>
+
+// logs the inputs of the main loop so that a run can be played back through the vision, controllers and robot by the Replayer
+//
+// every step of the loop starts with its dt and time, followed by the fresh raw bayer frames of the cameras and the
+// messages received from the communication, the main loop only appends to a buffer of the step and a writer thread
+// writes the finished steps to the file, frames are left out while the writer is falling behind
+//
+// file format, all values little endian:
+//   header:  "SBLG", int version, int width, int height
+//   step:    'S', float dt, double time
+//   frame:   'F', unsigned char camera (Dir), int number, double timestamp, width * height bytes of bayer data
+//   message: 'M', int length, length bytes
+class Recorder : public Thread {
+
+public:
+	enum RecordType {
+		STEP_RECORD = 'S',
+		FRAME_RECORD = 'F',
+		MESSAGE_RECORD = 'M'
+	};
+
+	enum { VERSION = 1 };
+
+	struct Stats {
+		Stats() : steps(0), frames(0), droppedFrames(0), messages(0), bytes(0) {}
+
+		int steps;
+		int frames;
+		int droppedFrames;
+		int messages;
+		__int64 bytes;
+	};
+
+	Recorder(int width, int height);
+	~Recorder();
+
+	bool open(const std::string& filename);
+
+	// called by the main loop, a step collects the frames and messages recorded until the next step
+	void recordStep(float dt, double time);
+	void recordFrame(Dir camera, const unsigned char* data, int number, double timestamp);
+	void recordMessage(const std::string& message);
+
+	// writes the last step and waits for the writer to finish
+	void close();
+	Stats getStats();
+
+private:
+	void* run();
+	void commitStep();
+	void append(const void* data, int length);
+
+	template<typename T> void append(T value) {
+		append(&value, sizeof(T));
+	}
+
+	int width;
+	int height;
+	bool running;
+	std::ofstream file;
+	std::string filename;
+	Stats stats;
+
+	// filled by the main loop
+	std::string step;
+
+	// finished steps waiting for the writer and buffers of the written ones to reuse
+	std::deque<std::string> pendingSteps;
+	std::vector<std::string> freeSteps;
+
+	boost::mutex mutex;
+	boost::condition_variable condition;
+
+};
+
+#endif // RECORDER_H
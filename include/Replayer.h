@@ -0,0 +1,70 @@
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include "Recorder.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+class VirtualCamera;
+class DummyCommunication;
+
+// plays back a log written by the Recorder one main loop step at a time
+//
+// the frames of a step are handed to the virtual cameras and the messages are received by the dummy communication so
+// they go through the same processing threads, vision, controllers and robot as they did while recording
+class Replayer {
+
+public:
+	struct Step {
+		Step() : dt(0.0f), time(0.0), frames(0), messages(0) {}
+
+		float dt;
+		double time;
+		int frames;
+		int messages;
+	};
+
+	Replayer();
+
+	bool open(const std::string& filename);
+
+	// waits for the recorded time between steps instead of playing them back as fast as the loop goes
+	void setRealtime(bool realtime) { this->realtime = realtime; }
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getStepCount() const { return stepCount; }
+
+	// reads the next step into the cameras and communication, returns false at the end of the log
+	//
+	// the clock is set to the recorded time of the step so the frame timestamps and the timers keep their recorded ages
+	bool next(Step& step, VirtualCamera* frontCamera, VirtualCamera* rearCamera, DummyCommunication* com);
+
+	// reports how fast the log was played back and gives the clock back
+	void close();
+
+private:
+	bool read(void* data, int length);
+
+	template<typename T> bool read(T& value) {
+		return read(&value, sizeof(T));
+	}
+
+	std::ifstream file;
+	std::string filename;
+	int width;
+	int height;
+	int stepCount;
+	bool realtime;
+	double firstStepTime;
+	double lastStepTime;
+	double startTime;
+	double timeOffset;
+	std::vector<unsigned char> frameBuffer;
+	std::string message;
+
+};
+
+#endif // REPLAYER_H
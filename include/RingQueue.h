@@ -0,0 +1,86 @@
+#ifndef RINGQUEUE_H
+#define RINGQUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+// bounded lock-free single producer single consumer queue over preallocated slots
+// items are swapped in and out of the slots so buffers such as string capacity are reused
+template <class T>
+class RingQueue {
+
+public:
+	RingQueue(int minCapacity) : head(0), tail(0), dropCount(0), maxDepth(0) {
+		capacity = 1;
+
+		while (capacity < minCapacity) {
+			capacity <<= 1;
+		}
+
+		mask = capacity - 1;
+		slots.resize(capacity);
+	}
+
+	// producer side, the item is left in an unspecified state, returns false and counts a drop when full
+	bool push(T& item) {
+		unsigned int currentTail = tail.load(std::memory_order_relaxed);
+		unsigned int depth = currentTail - head.load(std::memory_order_acquire);
+
+		if (depth >= (unsigned int)capacity) {
+			dropCount.fetch_add(1, std::memory_order_relaxed);
+
+			return false;
+		}
+
+		std::swap(slots[currentTail & mask], item);
+		tail.store(currentTail + 1, std::memory_order_release);
+
+		if ((int)depth + 1 > maxDepth.load(std::memory_order_relaxed)) {
+			maxDepth.store(depth + 1, std::memory_order_relaxed);
+		}
+
+		return true;
+	}
+
+	// consumer side
+	bool pop(T& item) {
+		return popBatch(&item, 1) == 1;
+	}
+
+	// consumer side, moves up to maxCount items into the caller supplied buffer and returns how many were moved
+	int popBatch(T* buffer, int maxCount) {
+		unsigned int currentHead = head.load(std::memory_order_relaxed);
+		int count = (int)(tail.load(std::memory_order_acquire) - currentHead);
+
+		if (count > maxCount) {
+			count = maxCount;
+		}
+
+		for (int i = 0; i < count; i++) {
+			std::swap(buffer[i], slots[(currentHead + i) & mask]);
+		}
+
+		head.store(currentHead + count, std::memory_order_release);
+
+		return count;
+	}
+
+	bool isEmpty() const { return getDepth() == 0; }
+	int getDepth() const { return (int)(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire)); }
+	int getCapacity() const { return capacity; }
+	int getMaxDepth() const { return maxDepth.load(std::memory_order_relaxed); }
+	int getDropCount() const { return dropCount.load(std::memory_order_relaxed); }
+
+private:
+	std::vector<T> slots;
+	int capacity;
+	unsigned int mask;
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+	std::atomic<int> dropCount;
+	std::atomic<int> maxDepth;
+
+};
+
+#endif // RINGQUEUE_H
@@ -11,8 +11,11 @@
 #include "AbstractCommunication.h"
 #include "Command.h"
 #include "PID.h"
+#include "OdometryAccumulator.h"
+#include "Histogram.h"
 
 #include <string>
+#include <boost/thread/mutex.hpp>
 
 class Wheel;
 class Dribbler;
@@ -20,6 +23,7 @@ class Coilgun;
 class Task;
 class AbstractCommunication;
 class OdometerLocalizer;
+class MotionThread;
 
 class Robot : public AbstractCommunication::Listener, public Command::Listener {
 
@@ -30,6 +34,15 @@ public:
     void setup();
 
 	void step(float dt, Vision::Results* visionResults);
+	void stepMotion(float dt);
+	void startMotionThread();
+	void stopMotionThread();
+	void receiveMotion();
+	void resetLatency();
+
+	// returns the results the controllers and the robot step act on, a copy with the balls predicted to when the resulting
+	// commands take effect, the given results keep what vision measured, valid until the next update
+	Vision::Results* updateBallLocalizer(Vision::Results* visionResults);
 
     const Math::Position getPosition() const { return Math::Position(x, y, orientation);  }
     float getOrientation() const { return orientation; }
@@ -45,7 +58,7 @@ public:
 
     void setTargetDir(float x, float y, float omega = 0.0f);
     void setTargetDir(const Math::Angle& dir, float speed = 1.0f, float omega = 0.0f);
-	void setTargetOmega(float omega) { targetOmega = omega; }
+	void setTargetOmega(float omega) { targetOmega = omega; lookAtActive = false; }
 	void spinAroundDribbler(bool reverse = false, float period = Config::robotSpinAroundDribblerPeriod, float radius = Config::robotSpinAroundDribblerRadius, float forwardSpeed = Config::robotSpinAroundDribblerForwardSpeed);
     void setPosition(float x, float y, float orientation);
 	void stop();
@@ -89,6 +102,54 @@ public:
 	OdometerLocalizer* odometerLocalizer;
 	
 private:
+	// time from the exposure of a camera frame until the robot is stepped with it and until the resulting speeds are sent
+	struct FrameLatency {
+		FrameLatency() : lastFrameNumber(-1), pendingExposure(0.0) {}
+
+		Histogram command;
+		Histogram send;
+		int lastFrameNumber;
+		double pendingExposure;
+	};
+
+	// wheel state as last reported by the motion control
+	struct WheelState {
+		WheelState() : stalled(false), targetOmega(0.0f), filteredTargetOmega(0.0f), realOmega(0.0f) {}
+
+		bool stalled;
+		float targetOmega;
+		float filteredTargetOmega;
+		float realOmega;
+	};
+
+	// targets handed from the frame step to the motion control
+	struct MotionCommand {
+		MotionCommand() : targetDir(0.0f, 0.0f), targetOmega(0.0f), dribblerSpeed(0.0f), lookAtActive(false), lookAtAngle(0.0f), lookAtRotation(0.0f), sent(true) {}
+
+		Math::Vector targetDir;
+		float targetOmega;
+		float dribblerSpeed;
+		bool lookAtActive;
+		float lookAtAngle;
+		float lookAtRotation;
+		bool sent;
+	};
+
+	// measured by the motion control since the frame step last received it
+	struct MotionFeedback {
+		MotionFeedback() : travelledDistance(0.0f), totalRotation(0.0f), sendTime(0.0) {}
+
+		OdometryAccumulator::Delta odometry;
+		Odometer::Movement movement;
+		float travelledDistance;
+		float totalRotation; // never reset, the look-at targets are relative to it
+		double sendTime; // first speeds sent for the last published targets
+		WheelState wheelFL;
+		WheelState wheelFR;
+		WheelState wheelRL;
+		WheelState wheelRR;
+	};
+
 	void setupWheels();
 	void setupDribbler();
 	void setupCoilgun();
@@ -97,11 +158,18 @@ private:
 	void setupOdometerLocalizer();
 	void setupBallLocalizer();
 	void setupCameraFOV();
-    void updateWheelSpeeds();
+    void updateWheelSpeeds(const Math::Vector& dir, float omega);
+	float updateLookAt(const MotionCommand& command);
+	void updateOdometry(const OdometryAccumulator::Delta& delta);
+	void updateWheelState(WheelState& state, Wheel* wheel);
+	void publishMotion();
 	void updateMeasurements();
-	void updateBallLocalizer(Vision::Results* visionResults, float dt);
-	void debugBallList(std::string name, std::stringstream& stream, BallLocalizer::BallList balls);
+	Vision::Result* compensateBallLatency(const Vision::Result* result, Vision::Result& compensated, double commandTime, int& trackedIndex);
+	void debugBallList(std::string name, std::stringstream& stream, const BallLocalizer::BallList& balls);
 	void handleQueuedChipKickRequest();
+	void updateCommandLatency(FrameLatency& latency, const Vision::Result* result, double time);
+	void updateSendLatency(FrameLatency& latency, double time);
+	void debugLatency(std::string name, std::stringstream& stream, const FrameLatency& latency);
 
     float x;
     float y;
@@ -113,6 +181,7 @@ private:
 	float travelledRotation;
 
 	double lastCommandTime;
+	double lastProtocolRequestTime;
 	double lastDriveBehindBallTime;
     float lastDt;
     float totalTime;
@@ -131,13 +200,34 @@ private:
 	AbstractCommunication* com;
 	Vision::Results* visionResults;
 	Odometer* odometer;
+	OdometryAccumulator* odometryAccumulator;
+	OdometryAccumulator::Delta frameOdometry;
 	Odometer::Movement movement;
 	ParticleFilterLocalizer::Measurements measurements;
 	BallLocalizer::BallList visibleBalls;
+	Vision::Result compensatedFront;
+	Vision::Result compensatedRear;
+	Vision::Results compensatedResults;
 	Math::Polygon currentCameraFOV;
 
+	bool lookAtActive;
+	float lookAtAngle;
+	float lookAtRotation;
+
+	FrameLatency frontLatency;
+	FrameLatency rearLatency;
+
+	// the frame step and the motion control only share these, each side copies them under the mutex
+	MotionCommand motionCommand;
+	MotionFeedback motionFeedback;
+	boost::mutex motionMutex;
+
+	// owned by the motion control
 	PID lookAtPid;
 
+	MotionFeedback receivedMotion;
+	MotionThread* motionThread;
+
 	std::string json;
 };
 
@@ -2,6 +2,8 @@
 #define SERIAL_COMMUNICATION_H
 
 #include "AbstractCommunication.h"
+#include "CommandScheduler.h"
+#include "LineFramer.h"
 #include "Serial.h"
 
 class SerialCommunication : public AbstractCommunication {
@@ -17,25 +19,21 @@ public:
 
 	static PortList getPortList();
 	void send(std::string message);
-	bool gotMessages();
-	std::string dequeueMessage();
 	void close();
 	void sync();
+	SendStats getSendStats() const;
 
 private:
 	void* run();
+	void sendFrame(const unsigned char* data, int length);
 	void received(const char *data, unsigned int len);
 
 	CallbackSerial serial;
 	std::string portName;
 	int baud;
-	std::string partialMessage;
-	Messages messages;
-	Messages queuedMessages;
-	Messages sendQueue;
-	char requestBuffer[MAX_SIZE];
-	mutable boost::mutex messagesMutex;
-	bool receivingMessage;
+	LineFramer framer;
+	CommandScheduler scheduler;
+	unsigned char requestBuffer[MAX_SIZE];
 };
 
 #endif // SERIAL_COMMUNICATION_H
\ No newline at end of file
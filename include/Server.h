@@ -3,10 +3,9 @@
 
 #include "Thread.h"
 #include "WebSocketServer.h"
+#include "RingQueue.h"
 
-#include <boost/thread/mutex.hpp>
 #include <string>
-#include <queue>
 #include <map>
 
 class Server : public Thread, WebSocketServer::Listener {
@@ -21,6 +20,7 @@ public:
 
 	struct Message {
 		Message(Client* client, Server* server, std::string content) : client(client), server(server), content(content) {}
+		Message() : client(NULL), server(NULL) {}
 		void respond(std::string response);
 
 		Client* client;
@@ -28,7 +28,7 @@ public:
 		std::string content;
 	};
 
-	typedef std::queue<Message*> Messages;
+	typedef RingQueue<Message> Messages;
 	typedef std::map<int, Client*> Clients;
 	typedef Clients::iterator ClientsIt;
 
@@ -38,9 +38,14 @@ public:
 	void setPort(int port);
 	void broadcast(std::string message);
 	void send(websocketpp::connection_hdl connection, std::string message) { ws->send(connection, message); }
+	void sendBinary(websocketpp::connection_hdl connection, const std::string& data) { ws->sendBinary(connection, data); }
+	size_t getBufferedAmount(websocketpp::connection_hdl connection) { return ws->getBufferedAmount(connection); }
 	void close();
-	bool gotMessages();
-	Message* dequeueMessage();
+	bool gotMessages() const { return !messages.isEmpty(); }
+	int dequeueMessages(Message* buffer, int maxCount) { return messages.popBatch(buffer, maxCount); }
+	int getQueueDepth() const { return messages.getDepth(); }
+	int getMaxQueueDepth() const { return messages.getMaxDepth(); }
+	int getDroppedMessageCount() const { return messages.getDropCount(); }
 	Client* getClientByConnection(websocketpp::connection_hdl connection);
 
 private:
@@ -54,7 +59,7 @@ private:
 	int clientCounter;
 	Clients clients;
 	Messages messages;
-	mutable boost::mutex messagesMutex;
+	Message receivedMessage;
 };
 
 #endif
\ No newline at end of file
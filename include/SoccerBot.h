@@ -5,18 +5,27 @@
 #include "Controller.h"
 #include "Server.h"
 #include "Command.h"
+#include "CommandDispatcher.h"
 #include <string>
+#include <sstream>
 
 class BaseCamera;
 class XimeaCamera;
 class VirtualCamera;
 class Blobber;
 class ProcessThread;
+class CaptureThread;
 class Gui;
 class FpsCounter;
 class Robot;
 class AbstractCommunication;
 class CameraTranslator;
+class FirmwareStub;
+class FrameStreamer;
+class StatePublisher;
+class Recorder;
+class Replayer;
+class DummyCommunication;
 
 class SoccerBot {
 
@@ -37,6 +46,7 @@ public:
 	void setupGui();
 	void setupServer();
 	void setupCommunication();
+	void setupRecording();
 
 	void addController(std::string name, Controller* controller);
     Controller* getController(std::string name);
@@ -45,18 +55,23 @@ public:
 
 	void handleServerMessages();
 	void handleServerMessage(Server::Message* message);
-	void handleGetControllerCommand(Server::Message* message);
-	void handleSetControllerCommand(Command::Parameters parameters, Server::Message* message);
+	void handleGetControllerCommand();
+	void handleSetControllerCommand(const CommandDispatcher::Arguments& args);
 	void handleGetStateCommand();
+	void handleSubscribeCommand(const CommandDispatcher::Arguments& args);
+	void handleGetProfileCommand(const CommandDispatcher::Arguments& args);
+	void handleProfileTraceCommand(const CommandDispatcher::Arguments& args);
+	void handleResetLatencyCommand();
 	void handleGetFrameCommand();
-	void handleStreamChoiceCommand(Command::Parameters parameters);
-	void handleCameraChoiceCommand(Command::Parameters parameters);
-	void handleCameraAdjustCommand(Command::Parameters parameters);
-	void handleBlobberThresholdCommand(Command::Parameters parameters);
-	void handleBlobberClearCommand(Command::Parameters parameters);
-	void handleScreenshotCommand(Command::Parameters parameters);
-	void handleListScreenshotsCommand(Server::Message* message);
-	void handleCameraTranslatorCommand(Command::Parameters parameters);
+	void handleStreamFramesCommand(const CommandDispatcher::Arguments& args);
+	void handleStreamChoiceCommand(const CommandDispatcher::Arguments& args);
+	void handleCameraChoiceCommand(const CommandDispatcher::Arguments& args);
+	void handleCameraAdjustCommand(const CommandDispatcher::Arguments& args);
+	void handleBlobberThresholdCommand(const CommandDispatcher::Arguments& args);
+	void handleBlobberClearCommand(const CommandDispatcher::Arguments& args);
+	void handleScreenshotCommand(const CommandDispatcher::Arguments& args);
+	void handleListScreenshotsCommand();
+	void handleCameraTranslatorCommand(const CommandDispatcher::Arguments& args);
 
 	void handleCommunicationMessages();
 	void handleCommunicationMessage(std::string message);
@@ -65,12 +80,19 @@ public:
 
 	bool debugVision;
 	bool showGui;
+	bool useFirmwareStub;
+
+	// logs the camera frames and communication of the run to a file or plays back such a file instead of using the robot
+	std::string recordFilename;
+	std::string replayFilename;
+	bool replayRealtime;
 
 private:
 	void setupXimeaCamera(std::string name, XimeaCamera* camera);
+	void setupCommands();
 	//bool fetchFrame(BaseCamera* camera, ProcessThread* processor);
-	void broadcastFrame(unsigned char* rgb, unsigned char* classification);
 	void broadcastScreenshots();
+	void debugObjectList(std::string name, std::stringstream& stream, const ObjectList& objects);
 
 	BaseCamera* frontCamera;
 	BaseCamera* rearCamera;
@@ -78,6 +100,8 @@ private:
 	XimeaCamera* ximeaRearCamera;
 	VirtualCamera* virtualFrontCamera;
 	VirtualCamera* virtualRearCamera;
+	VirtualCamera* replayFrontCamera;
+	VirtualCamera* replayRearCamera;
 	Blobber* frontBlobber;
 	Blobber* rearBlobber;
 	Vision* frontVision;
@@ -86,28 +110,39 @@ private:
 	CameraTranslator* rearCameraTranslator;
 	ProcessThread* frontProcessor;
 	ProcessThread* rearProcessor;
+	CaptureThread* frontCapture;
+	CaptureThread* rearCapture;
 	Gui* gui;
 	FpsCounter* fpsCounter;
 	Vision::Results* visionResults;
 	Server* server;
+	FrameStreamer* frameStreamer;
+	StatePublisher* statePublisher;
 	Robot* robot;
 	Controller* activeController;
 	AbstractCommunication* com;
+	FirmwareStub* firmwareStub;
+	Recorder* recorder;
+	Replayer* replayer;
+	DummyCommunication* replayCommunication;
 	ControllerMap controllers;
+	CommandDispatcher commands;
+	Server::Message* activeMessage;
 	std::string activeControllerName;
 	std::string activeStreamName;
+	std::string stateJson;
 
 	bool controllerRequested;
 	bool running;
 	bool stateRequested;
-	bool frameRequested;
 	bool useScreenshot;
 	float dt;
 	double lastStepTime;
 	float totalTime;
 	Dir debugCameraDir;
 
-	unsigned char* jpegBuffer;
+	std::string* communicationMessages;
+	Server::Message* serverMessages;
 	unsigned char* screenshotBufferFront;
 	unsigned char* screenshotBufferRear;
 };
@@ -0,0 +1,115 @@
+#ifndef STATEPUBLISHER_H
+#define STATEPUBLISHER_H
+
+#include "Thread.h"
+#include "Server.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <string>
+#include <vector>
+#include <map>
+
+// pushes the robot state to dash clients that subscribe to topics of it, each at its own rate
+//
+// the main loop hands over the state json only when some client is due an update, the publisher thread splits it into
+// values by their dot separated path, assigns the paths to topics and sends every client only the values that changed
+// since what it was sent last, so a client whose socket is busy just gets a larger update later
+//
+// update message payload:
+//   {"topic":"robot","full":false,"remove":["path",..],"set":{"path":value,..}}
+// objects are flattened into paths while arrays and other values are replaced whole, removals come before the new values
+class StatePublisher : public Thread {
+
+public:
+	enum Topic {
+		ROBOT_TOPIC,
+		VISION_TOPIC,
+		CONTROLLER_TOPIC,
+		WHEELS_TOPIC,
+		LOCALIZER_TOPIC,
+		STATUS_TOPIC,
+		TOPIC_COUNT
+	};
+
+	struct Stats {
+		Stats() : published(0), updates(0), values(0), busy(0), invalid(0) {}
+
+		int published;
+		int updates;
+		int values;
+		int busy;
+		int invalid;
+	};
+
+	StatePublisher(Server* server);
+	~StatePublisher();
+
+	// returns TOPIC_COUNT for unknown names
+	static Topic getTopic(const std::string& name);
+	static const char* getTopicName(Topic topic);
+
+	// a rate of 0 cancels the subscription, subscribing again sends all values of the topic
+	void subscribe(Server::Client* client, Topic topic, int rate);
+
+	// whether some client gets the topic at all, sections of the state only needed by a topic can be left out otherwise
+	bool isSubscribed(Topic topic);
+
+	// true when some client not busy sending is due an update and the previous state has been processed, the state needs to be built only then
+	bool isWanted();
+
+	// takes over the contents of the state json, never waits for the publisher thread and returns false when it is busy
+	bool publish(std::string& json);
+
+	void close();
+	Stats getStats();
+
+private:
+	typedef std::map<std::string, std::string> Values;
+
+	struct Subscription {
+		Subscription() : clientId(-1), topic(STATUS_TOPIC), interval(0.0), lastSendTime(0.0), lastVersion(-1), full(true) {}
+
+		int clientId;
+		websocketpp::connection_hdl connection;
+		Topic topic;
+		double interval;
+		double lastSendTime;
+		int lastVersion;
+		bool full;
+		Values sent;
+	};
+
+	typedef std::vector<Subscription> Subscriptions;
+
+	void* run();
+	bool isDue(const Subscription& subscription, double time) const;
+	bool flatten(const std::string& json);
+	bool flattenObject(const char*& pos, const char* end, const std::string& prefix);
+	void addValue(const std::string& path, const char* start, const char* end);
+	bool encode(const Subscription& subscription, std::string& message, int& valueCount);
+	void deliver(boost::mutex::scoped_lock& lock);
+
+	static Topic getPathTopic(const std::string& path);
+
+	Server* server;
+	bool running;
+	bool pending;
+	bool processing;
+	int version;
+	Subscriptions subscriptions;
+	Stats stats;
+
+	// written by the main loop while pending is false, read by the publisher while it is true
+	std::string json;
+
+	// owned by the publisher thread
+	std::string processedJson;
+	Values values[TOPIC_COUNT];
+
+	boost::mutex mutex;
+	boost::condition_variable condition;
+
+};
+
+#endif // STATEPUBLISHER_H
@@ -0,0 +1,78 @@
+#ifndef STRINGVIEW_H
+#define STRINGVIEW_H
+
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+
+// non-owning reference to a part of a string, valid only as long as the referenced characters are
+class StringView {
+
+public:
+	StringView() : data(NULL), length(0) {}
+	StringView(const char* data, int length) : data(data), length(length) {}
+	StringView(const std::string& str) : data(str.c_str()), length((int)str.size()) {}
+
+	const char* getData() const { return data; }
+	int getLength() const { return length; }
+	bool isEmpty() const { return length == 0; }
+	std::string toString() const { return std::string(data, length); }
+
+	bool operator==(const StringView& other) const {
+		return length == other.length && (length == 0 || memcmp(data, other.data, length) == 0);
+	}
+
+	bool operator==(const char* other) const {
+		return strncmp(data != NULL ? data : "", other, length) == 0 && other[length] == 0;
+	}
+
+	bool operator!=(const StringView& other) const { return !(*this == other); }
+	bool operator!=(const char* other) const { return !(*this == other); }
+
+	bool startsWith(const char* prefix) const {
+		int prefixLength = (int)strlen(prefix);
+
+		return prefixLength <= length && memcmp(data, prefix, prefixLength) == 0;
+	}
+
+	StringView substr(int start) const {
+		return start >= length ? StringView(data + length, 0) : StringView(data + start, length - start);
+	}
+
+	// FNV-1a
+	unsigned int hash() const {
+		unsigned int result = 2166136261u;
+
+		for (int i = 0; i < length; i++) {
+			result = (result ^ (unsigned char)data[i]) * 16777619u;
+		}
+
+		return result;
+	}
+
+	// the whole view has to be a number, returns false otherwise
+	bool toDouble(double& value) const {
+		char buffer[32];
+
+		if (length == 0 || length >= (int)sizeof(buffer)) {
+			return false;
+		}
+
+		// copied since the view is not terminated where the number ends
+		memcpy(buffer, data, length);
+		buffer[length] = 0;
+
+		char* end;
+
+		value = strtod(buffer, &end);
+
+		return end == buffer + length;
+	}
+
+private:
+	const char* data;
+	int length;
+
+};
+
+#endif // STRINGVIEW_H
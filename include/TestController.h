@@ -2,6 +2,7 @@
 #define TESTCONTROLLER_H
 
 #include "BaseAI.h"
+#include "CommandDispatcher.h"
 #include "Vision.h"
 #include "DebouncedButton.h"
 #include "Util.h"
@@ -301,21 +302,26 @@ public:
 	virtual void setState(std::string state);
 	virtual void setState(std::string state, Parameters parameters);
 
-    bool handleCommand(const Command& cmd);
-	void handleTargetVectorCommand(const Command& cmd);
-	void handleDribblerCommand(const Command& cmd);
-	void handleAdjustDribblerLimitsCommand(const Command& cmd);
-	void handleKickCommand(const Command& cmd);
-	void handleChipKickCommand(const Command& cmd);
+    bool handleCommand(const Command& cmd) { return handleCommand(Command::View(cmd)); }
+    bool handleCommand(const Command::View& cmd);
+	void handleTargetVectorCommand(const CommandDispatcher::Arguments& args);
+	void handleDribblerCommand(const CommandDispatcher::Arguments& args);
+	void handleAdjustDribblerLimitsCommand(const CommandDispatcher::Arguments& args);
+	void handleDribblerNormalLimitsCommand();
+	void handleDribblerChipKickLimitsCommand();
+	void handleKickCommand(const CommandDispatcher::Arguments& args);
+	void handleChipKickCommand(const CommandDispatcher::Arguments& args);
+	void handleResetPositionCommand();
+	void handleStopCommand();
 	void handleResetCommand();
 	void handleToggleGoCommand();
 	void handleToggleSideCommand();
-	void handleDriveToCommand(const Command& cmd);
-	void handleTurnByCommand(const Command& cmd);
-	void handleParameterCommand(const Command& cmd);
-	void handleRefFieldIdCommand(const Command& cmd);
-	void handleRefRobotIdCommand(const Command& cmd);
-	void handleRefExternalCommand(const Command& cmd);
+	void handleDriveToCommand(const CommandDispatcher::Arguments& args);
+	void handleTurnByCommand(const CommandDispatcher::Arguments& args);
+	void handleParameterCommand(const CommandDispatcher::Arguments& args);
+	void handleRefFieldIdCommand(const CommandDispatcher::Arguments& args);
+	void handleRefRobotIdCommand(const CommandDispatcher::Arguments& args);
+	void handleRefExternalCommand(const CommandDispatcher::Arguments& args);
 
 	float getTargetAngle(float goalX, float goalY, float ballX, float ballY, float D, TargetMode targetMode = TargetMode::INLINE);
 	float getChipKickDistance(Vision::BallInWayMetric ballInWayMetric, float goalDistance);
@@ -334,6 +340,7 @@ public:
 
 private:
 	void setupStates();
+	void setupCommands();
 	void updateVisionInfo(Vision::Results* visionResults);
 	bool isRobotNearLine(Vision::Results* visionResults, bool ignoreCenterSample = false);
 	bool isRobotInCorner(Vision::Results* visionResults);
@@ -353,6 +360,7 @@ private:
 	void handleRefereeStop();
 
 	Vision::Results* visionResults;
+	CommandDispatcher commands;
 
 	DebouncedButton toggleGoBtn;
 	DebouncedButton toggleSideBtn;
@@ -0,0 +1,43 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// lock-free single producer single consumer exchange where the consumer always sees the latest published value
+template <class T>
+class TripleBuffer {
+
+public:
+	TripleBuffer() : backIndex(0), middle(1), frontIndex(2) {}
+
+	// producer side, fill in getBack() and call publish()
+	T& getBack() { return slots[backIndex]; }
+
+	void publish() {
+		backIndex = middle.exchange(backIndex | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// consumer side, returns whether a newer value was swapped into the front
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & DIRTY) == 0) {
+			return false;
+		}
+
+		frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+
+		return true;
+	}
+
+	const T& getFront() const { return slots[frontIndex]; }
+
+private:
+	enum { DIRTY = 4, INDEX_MASK = 3 };
+
+	T slots[3];
+	int backIndex;
+	std::atomic<int> middle;
+	int frontIndex;
+
+};
+
+#endif // TRIPLEBUFFER_H
@@ -1,30 +1,36 @@
 #ifndef UTIL_H
 #define UTIL_H
 
-#include <Windows.h>
+#include "Platform.h"
+
 #include <string>
 #include <sstream>
 #include <cstdlib>
 #include <vector>
 #include <iterator>
+#include <atomic>
 
 class Util {
 
 public:
     static std::string base64Encode(const unsigned char* data, unsigned int len);
     static double millitime();
+	static void setSimulatedTime(double time) { simulatedTime.store(time); }
+	static void clearSimulatedTime() { simulatedTime.store(-1.0); }
+	static double preciseTime();
+	static __int64 nanotime();
     static double duration(double start);
     static float signum(float value);
     static float limit(float num, float min, float max);
     static int strpos(const std::string& haystack, const std::string &needle);
     static bool replace(std::string& str, const std::string& from, const std::string& to);
-	static void sleep(int milliseconds) { Sleep(milliseconds); }
+	static void sleep(int milliseconds) { Platform::sleep(milliseconds); }
 	static __int64 timerStart();
 	static double timerEnd(__int64 startTime = -1);
 	//static void correctCameraPoint(int& x, int& y);
 	static void confineField(float& x, float& y);
 	static std::string json(std::string id, std::string payload);
-	static std::vector<std::string> Util::getFilesInDir(std::string path);
+	static std::vector<std::string> getFilesInDir(std::string path);
 
     static inline int rgbToInt(int red, int green, int blue) {
         int rgb = red;
@@ -82,6 +88,8 @@ private:
     static const std::string base64Chars;
 	static double queryPerformanceFrequency;
 	static __int64 timerStartCount;
+	static __int64 performanceCounterFrequency;
+	static std::atomic<double> simulatedTime;
 	
 };
 
@@ -2,23 +2,36 @@
 #define VIRTUALCAMERA_H
 
 #include "BaseCamera.h"
+#include "Config.h"
 
 #include <string>
 
+class FrameGenerator;
+
 class VirtualCamera : public BaseCamera {
 
 public:
 	VirtualCamera();
 
 	Frame* getFrame();
-	bool isAcquisitioning() { return data != NULL; }
+	bool isAcquisitioning() { return data != NULL || generator != NULL; }
 	bool loadImage(std::string filename, int size);
 
+	// serves a recorded frame once, getFrame returns stale frames until the next one is set
+	void setFrame(const unsigned char* frameData, int size, int number, double timestamp);
+
+	// renders a fresh frame of the generator scene as the given camera on every request, NULL stops it
+	void setGenerator(FrameGenerator* generator, Dir dir);
+
 private:
 	Frame frame;
 	unsigned char* data;
 	int bufferSize;
 	int frameNr;
+	bool replaying;
+	bool fresh;
+	FrameGenerator* generator;
+	Dir generatorDir;
 
 };
 
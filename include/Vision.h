@@ -4,6 +4,7 @@
 #include "Blobber.h"
 #include "Canvas.h"
 #include "Object.h"
+#include "ObjectArena.h"
 #include "LookupTable.h"
 #include "Config.h"
 #include "Maths.h"
@@ -76,14 +77,29 @@ public:
 	};
 
 	struct Result {
-		Result() : vision(NULL) {}
+		Result() : vision(NULL), timestamp(0.0), frameNumber(-1) {}
+
+		// empties the result for the next frame keeping the allocated memory, the objects of the last one are gone
+		void reset(double frameTimestamp, int frameNumber) {
+			objects.reset(frameTimestamp);
+			balls.clear();
+			goals.clear();
+			colorOrder.clear();
+			whiteDistance = ColorDistance();
+			blackDistance = ColorDistance();
+			timestamp = frameTimestamp;
+			this->frameNumber = frameNumber;
+		}
 
+		ObjectArena objects; // owns the balls and goals
 		ObjectList balls;
 		ObjectList goals;
 		ColorList colorOrder;
 		ColorDistance whiteDistance;
 		ColorDistance blackDistance;
 		Vision* vision;
+		double timestamp; // exposure time of the frame in the Util::millitime() time base
+		int frameNumber; // -1 for the blank results of a faulty camera
 	};
 
 	class Results {
@@ -137,7 +153,7 @@ public:
     ~Vision();
 
 	void setDebugImage(unsigned char* image, int width, int height);
-    Result* process();
+    void process(Result* result);
     Blobber::Color* getColorAt(int x, int y);
 	CameraTranslator* getCameraTranslator() { return cameraTranslator; }
 	Dir getDir() { return dir; }
@@ -150,8 +166,8 @@ public:
 	Obstruction getGoalPathObstruction(float goalDistance);
 
 private:
-    ObjectList processGoals(Dir dir);
-	ObjectList processBalls(Dir dir, ObjectList& goals);
+    void processGoals(Dir dir, Result* result);
+	void processBalls(Dir dir, Result* result);
 	float getSurroundMetric(int x, int y, int radius, std::vector<std::string> validColors, std::string requiredColor = "", int side = 0, bool allowNone = false);
     PathMetric getPathMetric(int x1, int y1, int x2, int y2, std::vector<std::string> validColors, std::string requiredColor = "");
 	EdgeDistanceMetric getEdgeDistanceMetric(int x, int y, int width, int height, std::string color1, std::string color2);
@@ -161,7 +177,7 @@ private:
 	float getColorDistance(std::string colorName, int x1, int y1, int x2, int y2);
 	ColorDistance getColorDistance(std::string colorName);
 	ColorList getViewColorOrder();
-	Object* Vision::mergeGoals(Object* goal1, Object* goal2);
+	Object* mergeGoals(Object* goal1, Object* goal2);
 	bool isValidBall(Object* ball, Dir dir, ObjectList& goals);
     bool isValidGoal(Object* goal, Side side);
 	bool isNotOpponentMarker(Object* goal, Side side, ObjectList& goals);
@@ -190,6 +206,8 @@ private:
 	ColorList colorOrder;
 	ColorDistance whiteDistance;
 	ColorDistance blackDistance;
+	ObjectList allObjects;
+	ObjectList mergedObjects;
 
 };
 
@@ -0,0 +1,108 @@
+#ifndef VISIONBENCHMARK_H
+#define VISIONBENCHMARK_H
+
+#include "Config.h"
+#include "Platform.h"
+#include "Object.h"
+#include "Vision.h"
+#include "FrameGenerator.h"
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <map>
+
+class Blobber;
+class CameraTranslator;
+
+// times the frame processing stages over a directory of screenshots saved by the screenshot command
+//
+// every capture goes through the bayer and yuyv conversion, the blobber and the vision of its camera, *-rear.scr files
+// are processed as the rear camera and the rest as the front one, the results are written as json with the median and
+// 99th percentile time of every stage in milliseconds, the run and blob counts and the detected objects per capture
+//
+// instead of screenshots the captures can be rendered by the frame generator from random scenes, then the detected balls
+// are also matched against the rendered ones
+//
+// two result files can be compared, stages that got slower than Config::visionBenchmarkTolerance and captures whose
+// detections changed are reported
+class VisionBenchmark {
+
+public:
+	VisionBenchmark();
+	~VisionBenchmark();
+
+	bool load(const std::string& directory);
+
+	// renders the front and rear camera frames of random scenes, the same ones for every run
+	bool generate(int sceneCount, int ballCount, int robotCount);
+	void run(int iterations);
+
+	// writes the results to the file or to the standard output without a filename
+	bool save(const std::string& filename);
+	std::string getJSON();
+
+	// returns false when the result is slower than the baseline or detects different objects
+	static bool compare(const std::string& baselineFilename, const std::string& resultFilename);
+
+private:
+	enum Stage {
+		BAYER_STAGE,
+		YUYV_STAGE,
+		BLOBBER_STAGE,
+		VISION_STAGE,
+		TOTAL_STAGE,
+		STAGE_COUNT
+	};
+
+	struct Capture {
+		std::string name;
+		Dir dir;
+		std::vector<unsigned char> data;
+		std::vector<__int64> durations[STAGE_COUNT];
+		int runCount;
+		int blobCount;
+		std::string balls;
+		std::string goals;
+		bool synthetic;
+		FrameGenerator::VisibleBallList visibleBalls;
+		int foundCount;
+		int extraCount;
+		float distanceError;
+		float angleError;
+	};
+
+	typedef std::map<std::string, std::string> Values;
+
+	void setup();
+	void process(Capture& capture, bool record);
+	void debugStages(std::stringstream& stream, std::vector<__int64>* durations);
+	void matchBalls(Capture& capture, const ObjectList& balls);
+
+	static double getPercentile(std::vector<__int64>& durations, float percentile);
+	static std::string getObjectsJSON(const ObjectList& objects);
+	static bool loadValues(const std::string& filename, Values& values);
+	static bool parseValue(const char*& pos, const char* end, const std::string& path, Values& values);
+	static double getNumber(const Values& values, const std::string& path);
+
+	int width;
+	int height;
+	int iterations;
+	std::vector<Capture> captures;
+
+	Blobber* frontBlobber;
+	Blobber* rearBlobber;
+	CameraTranslator* frontCameraTranslator;
+	CameraTranslator* rearCameraTranslator;
+	Vision* frontVision;
+	Vision* rearVision;
+	Vision::Result result;
+
+	unsigned char* dataY;
+	unsigned char* dataU;
+	unsigned char* dataV;
+	unsigned char* dataYUYV;
+
+};
+
+#endif // VISIONBENCHMARK_H
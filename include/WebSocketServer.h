@@ -35,6 +35,10 @@ public:
 	void addListener(Listener* listener);
 	void broadcast(std::string message);
 	void send(websocketpp::connection_hdl connection, std::string message);
+	void sendBinary(websocketpp::connection_hdl connection, const std::string& data);
+
+	// bytes queued for the connection but not yet written to the socket, 0 for closed connections
+	size_t getBufferedAmount(websocketpp::connection_hdl connection);
 	
 private:
 	void onOpen(websocketpp::connection_hdl connection);
@@ -59,6 +59,8 @@ public:
     void setFloatParam(const char* name, float value);
 
 private:
+	double toHostTime(double cameraTime);
+
     XI_IMG image;
 	Frame frame;
     HANDLE device;
@@ -66,6 +68,8 @@ private:
 	bool acquisitioning;
 	int serialNumber;
     int lastFrameNumber;
+	double timestampOffset;
+	bool timestampOffsetKnown;
 
 };
 
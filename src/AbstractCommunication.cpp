@@ -0,0 +1,44 @@
+#include "AbstractCommunication.h"
+#include "LineFramer.h"
+
+#include <stdio.h>
+
+std::string AbstractCommunication::dequeueMessage() {
+	std::string message;
+
+	receivedMessages.pop(message);
+
+	return message;
+}
+
+void AbstractCommunication::sendSpeeds(int FL, int FR, int RL, int RR, int dribbler) {
+	setSpeeds(FL, FR, RL, RR, dribbler);
+
+	if (binaryProtocol) {
+		unsigned char frame[BinaryProtocol::MAX_FRAME_SIZE];
+		int length = BinaryProtocol::encodeSpeeds(frame, FL, FR, RL, RR, dribbler);
+
+		sendFrame(frame, length);
+	} else {
+		char message[64];
+
+		sprintf(message, "speeds:%d:%d:%d:%d:%d", FL, FR, RL, RR, dribbler);
+
+		send(message);
+	}
+}
+
+void AbstractCommunication::receiveBytes(LineFramer& framer, const char* data, int length) {
+	StringView message;
+
+	while (length > 0) {
+		int written = framer.write(data, length);
+
+		data += written;
+		length -= written;
+
+		while (framer.next(message)) {
+			receiveMessage(message, framer.isBinary());
+		}
+	}
+}
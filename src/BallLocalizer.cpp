@@ -5,9 +5,18 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-
-BallLocalizer::BallLocalizer() {
-
+#include <cmath>
+
+BallLocalizer::BallLocalizer() :
+	ballGrid(Config::objectIdentityDistanceThreshold, Config::ballLocalizerGridBuckets),
+	visibleGrid(Config::objectFovCloseEnough, Config::ballLocalizerGridBuckets)
+{
+	balls.reserve(Config::ballLocalizerPoolSize);
+	associations.reserve(Config::ballLocalizerPoolSize * 4);
+	visibleAssignments.reserve(Config::ballLocalizerPoolSize);
+	ballAssigned.reserve(Config::ballLocalizerPoolSize);
+	ballRemap.reserve(Config::ballLocalizerPoolSize);
+	candidates.reserve(Config::ballLocalizerPoolSize);
 }
 
 BallLocalizer::~BallLocalizer() {
@@ -16,41 +25,66 @@ BallLocalizer::~BallLocalizer() {
 
 int BallLocalizer::Ball::instances = 0;
 
-BallLocalizer::Ball::Ball(float px, float py) {
+BallLocalizer::Ball::Ball(float px, float py, double time) {
     id = instances++;
-    createdTime = Util::millitime();
+    createdTime = time;
     updatedTime = createdTime;
+    stateTime = createdTime;
     removeTime = -1.0,
 	x = px;
 	y = py;
 	velocityX = 0.0f;
 	velocityY = 0.0f;
+	positionVariance = Config::ballMeasurementNoise * Config::ballMeasurementNoise;
+	velocityVariance = Config::objectMaxVelocity * Config::objectMaxVelocity / 4.0f;
+	positionVelocityCovariance = 0.0f;
 	visible = true;
 	inFOV = true;
 	resurrectable = true;
 }
 
-void BallLocalizer::Ball::updateVisible(float newX, float newY, float dt) {
-    double currentTime = Util::millitime();
-    double timeSinceLastUpdate = currentTime - updatedTime;
+void BallLocalizer::Ball::predict(double time) {
+	float dt = (float)(time - stateTime);
 
-    if (timeSinceLastUpdate <= Config::velocityUpdateMaxTime) {
-		float newVelocityX = (newX - x) / dt;
-		float newVelocityY = (newY - y) / dt;
+	if (dt <= 0.0f) {
+		return;
+	}
 
-		if (Math::abs(newVelocityX) <= Config::objectMaxVelocity && Math::abs(newVelocityY) <= Config::objectMaxVelocity) {
-			velocityX = newVelocityX;
-			velocityY = newVelocityY;
-		} else {
-			applyDrag(dt);
-		}
-    } else {
-        applyDrag(dt);
-    }
+	// constant velocity model, the x and y axes share the same covariance
+	x += velocityX * dt;
+	y += velocityY * dt;
+
+	applyDrag(dt);
 
-    x = newX;
-    y = newY;
-    updatedTime = currentTime;
+	float q = Config::ballAccelerationNoise * Config::ballAccelerationNoise;
+
+	positionVariance += 2.0f * dt * positionVelocityCovariance + dt * dt * velocityVariance + q * dt * dt * dt / 3.0f;
+	positionVelocityCovariance += dt * velocityVariance + q * dt * dt / 2.0f;
+	velocityVariance += q * dt;
+
+	stateTime = time;
+}
+
+void BallLocalizer::Ball::updateVisible(float newX, float newY, double time) {
+	predict(time);
+
+	float r = Config::ballMeasurementNoise * Config::ballMeasurementNoise;
+	float innovationVariance = positionVariance + r;
+	float positionGain = positionVariance / innovationVariance;
+	float velocityGain = positionVelocityCovariance / innovationVariance;
+	float innovationX = newX - x;
+	float innovationY = newY - y;
+
+	x += positionGain * innovationX;
+	y += positionGain * innovationY;
+	velocityX += velocityGain * innovationX;
+	velocityY += velocityGain * innovationY;
+
+	velocityVariance -= velocityGain * positionVelocityCovariance;
+	positionVelocityCovariance *= 1.0f - positionGain;
+	positionVariance *= 1.0f - positionGain;
+
+    updatedTime = time;
     
     visible = true;
 
@@ -59,13 +93,14 @@ void BallLocalizer::Ball::updateVisible(float newX, float newY, float dt) {
 	}
 }
 
-void BallLocalizer::Ball::updateInvisible(float dt) {
-    x += velocityX * dt;
-    y += velocityY * dt;
+void BallLocalizer::Ball::updateInvisible() {
+    visible = false;
+}
 
-    applyDrag(dt);
+Math::Point BallLocalizer::Ball::getPredictedPosition(double time) const {
+	float predictionTime = Math::limit((float)(time - stateTime), 0.0f, Config::ballMaxPredictionTime);
 
-    visible = false;
+	return Math::Point(x + velocityX * predictionTime, y + velocityY * predictionTime);
 }
 
 void BallLocalizer::Ball::markForRemoval(double afterSeconds) {
@@ -76,7 +111,7 @@ void BallLocalizer::Ball::markForRemoval(double afterSeconds) {
     removeTime = Util::millitime() + afterSeconds;
 }
 
-bool BallLocalizer::Ball::shouldBeRemoved() {
+bool BallLocalizer::Ball::shouldBeRemoved() const {
     return removeTime != -1 && removeTime < Util::millitime();
 }
 
@@ -98,10 +133,8 @@ void BallLocalizer::Ball::applyDrag(float dt) {
     }
 }
 
-BallLocalizer::BallList BallLocalizer::extractBalls(const ObjectList& sourceBalls, float robotX, float robotY, float robotOrientation) {
-	BallList balls;
+void BallLocalizer::extractBalls(const ObjectList& sourceBalls, float robotX, float robotY, float robotOrientation, double timestamp, BallList& result) {
 	Object* screenBall;
-	Ball* worldBall;
 
 	for (ObjectListItc it = sourceBalls.begin(); it != sourceBalls.end(); it++) {
 		screenBall = *it;
@@ -110,51 +143,76 @@ BallLocalizer::BallList BallLocalizer::extractBalls(const ObjectList& sourceBall
         float ballX = robotX + Math::cos(globalAngle) * screenBall->distance;
         float ballY = robotY + Math::sin(globalAngle) * screenBall->distance;
 
-		worldBall = new Ball(ballX, ballY);
-
-		balls.push_back(worldBall);
+		result.push_back(Ball(ballX, ballY, timestamp));
 	}
-
-	return balls;
 }
 
-void BallLocalizer::update(const BallList& visibleBalls, const Math::Polygon& cameraFOV, float dt) {
-    Ball* closestBall;
-    std::vector<int> handledBalls;
-    //float globalAngle;
-
-    for (unsigned int i = 0; i < visibleBalls.size(); i++) {
-        /*globalAngle = Math::floatModulus(robotPosition.orientation + visibleBalls[i]->angle, Math::TWO_PI);
+void BallLocalizer::update(const BallList& visibleBalls, const Math::Polygon& cameraFOV, double timestamp) {
+	int existingBallCount = balls.size();
 
-        visibleBalls[i]->x = robotPosition.x + Math::cos(globalAngle) * visibleBalls[i]->distance;
-        visibleBalls[i]->y = robotPosition.y + Math::sin(globalAngle) * visibleBalls[i]->distance;*/
+	// bring all the tracked balls to the time of the frame before matching
+	for (int i = 0; i < existingBallCount; i++) {
+		balls[i].predict(timestamp);
+	}
 
-        closestBall = getBallAround(visibleBalls[i]->x, visibleBalls[i]->y);
+	associate(visibleBalls);
 
-        if (closestBall != NULL) {
-            closestBall->updateVisible(visibleBalls[i]->x, visibleBalls[i]->y, dt);
+    for (unsigned int i = 0; i < visibleBalls.size(); i++) {
+		int ballIndex = visibleAssignments[i];
 
-            handledBalls.push_back(closestBall->id);
+        if (ballIndex != -1) {
+            balls[ballIndex].updateVisible(visibleBalls[i].x, visibleBalls[i].y, timestamp);
         } else {
-            Ball* newBall = new Ball(visibleBalls[i]->x, visibleBalls[i]->y);
+			visibleAssignments[i] = balls.size();
 
-            balls.push_back(newBall);
-
-            handledBalls.push_back(newBall->id);
+            balls.push_back(Ball(visibleBalls[i].x, visibleBalls[i].y, timestamp));
         }
     }
 
-    for (unsigned int i = 0; i < balls.size(); i++) {
-        if (std::find(handledBalls.begin(), handledBalls.end(), balls[i]->id) != handledBalls.end()) {
+    for (int i = 0; i < existingBallCount; i++) {
+        if (ballAssigned[i]) {
             continue;
         }
 
-        balls[i]->updateInvisible(dt);
+        balls[i].updateInvisible();
     }
 
     purge(visibleBalls, cameraFOV);
 }
 
+void BallLocalizer::associate(const BallList& visibleBalls) {
+	float distance;
+
+	associations.clear();
+	visibleAssignments.assign(visibleBalls.size(), -1);
+	ballAssigned.assign(balls.size(), false);
+
+	ballGrid.build(balls);
+
+	// gather all the observation-ball pairs that fall within the identity gate
+	for (unsigned int i = 0; i < visibleBalls.size(); i++) {
+		ballGrid.findNear(visibleBalls[i].x, visibleBalls[i].y, Config::objectIdentityDistanceThreshold, balls, candidates);
+
+		for (unsigned int j = 0; j < candidates.size(); j++) {
+			distance = Math::distanceBetween(balls[candidates[j]].x, balls[candidates[j]].y, visibleBalls[i].x, visibleBalls[i].y);
+
+			associations.push_back(Association(i, candidates[j], distance));
+		}
+	}
+
+	// greedy assignment, closest pairs first so each ball is matched to at most one observation
+	std::sort(associations.begin(), associations.end());
+
+	for (AssociationsIt it = associations.begin(); it != associations.end(); it++) {
+		if (visibleAssignments[it->visibleIndex] != -1 || ballAssigned[it->ballIndex]) {
+			continue;
+		}
+
+		visibleAssignments[it->visibleIndex] = it->ballIndex;
+		ballAssigned[it->ballIndex] = true;
+	}
+}
+
 BallLocalizer::Ball* BallLocalizer::getBallAround(float x, float y) {
     float distance;
     float minDistance = -1;
@@ -162,7 +220,7 @@ BallLocalizer::Ball* BallLocalizer::getBallAround(float x, float y) {
     Ball* closestBall = NULL;
 
     for (unsigned int i = 0; i < balls.size(); i++) {
-        ball = balls[i];
+        ball = &balls[i];
 
         distance = Math::distanceBetween(ball->x, ball->y, x, y);
 
@@ -181,23 +239,33 @@ BallLocalizer::Ball* BallLocalizer::getBallAround(float x, float y) {
     return closestBall;
 }
 
+BallLocalizer::Ball* BallLocalizer::getTrackedBall(int visibleIndex) {
+	if (visibleIndex < 0 || visibleIndex >= (int)visibleAssignments.size() || visibleAssignments[visibleIndex] == -1) {
+		return NULL;
+	}
+
+	return &balls[visibleAssignments[visibleIndex]];
+}
+
 void BallLocalizer::purge(const BallList& visibleBalls, const Math::Polygon& cameraFOV) {
 	double currentTime = Util::millitime();
-    BallList remainingBalls;
-    Ball* ball;
+	int keptCount = 0;
 	bool keep;
 
+	visibleGrid.build(visibleBalls);
+	ballRemap.assign(balls.size(), -1);
+
     for (unsigned int i = 0; i < balls.size(); i++) {
-        ball = balls[i];
+        Ball& ball = balls[i];
 		keep = true;
 
-		if (currentTime - ball->updatedTime > Config::objectPurgeLifetime) {
+		if (currentTime - ball.updatedTime > Config::objectPurgeLifetime) {
 			//std::cout << "@ LIFETIME" << std::endl;
 
 			keep = false;
 		}
 
-		Math::Vector velocity(ball->velocityX, ball->velocityY);
+		Math::Vector velocity(ball.velocityX, ball.velocityY);
 
 		if (velocity.getLength() > Config::objectMaxVelocity) {
 			//std::cout << "@ VELOCITY" << std::endl;
@@ -205,50 +273,107 @@ void BallLocalizer::purge(const BallList& visibleBalls, const Math::Polygon& cam
 			keep = false;
 		}
 
-		if (cameraFOV.containsPoint(ball->x, ball->y)) {
-			ball->inFOV = true;
-
-			bool ballNear = false;
+		if (cameraFOV.containsPoint(ball.x, ball.y)) {
+			ball.inFOV = true;
 
-			for (unsigned int i = 0; i < visibleBalls.size(); i++) {
-				float distance = Math::distanceBetween(ball->x, ball->y, visibleBalls[i]->x, visibleBalls[i]->y);
-
-				if (distance <= Config::objectFovCloseEnough) {
-					ballNear = true;
-
-					break;
-				}
-			}
+			visibleGrid.findNear(ball.x, ball.y, Config::objectFovCloseEnough, visibleBalls, candidates);
 
-			if (!ballNear)  {
+			if (candidates.size() == 0)  {
 				//std::cout << "@ NO BALL NEAR" << std::endl;
 
 				keep = false;
 			}
 		} else {
-			ball->inFOV = false;	
+			ball.inFOV = false;	
 		}
 
+		// compact the kept balls to the front of the storage
 		if (keep) {
-			remainingBalls.push_back(ball);
-		} else {
-			delete ball;
-            ball = NULL;
+			if ((int)i != keptCount) {
+				balls[keptCount] = ball;
+			}
+
+			ballRemap[i] = keptCount;
+			keptCount++;
 		}
+    }
 
-        /*if (!ball->shouldBeRemoved()) {
-            remainingBalls.push_back(ball);
+    balls.erase(balls.begin() + keptCount, balls.end());
 
-            if (!isValid(ball, visibleBalls, cameraFOV)) {
-                ball->markForRemoval(Config::objectMarkForRemovalThreshold);
-            }
-        } else {
-            delete ball;
-            ball = NULL;
-        }*/
-    }
+	// keep the observation to ball mapping valid after compacting
+	for (unsigned int i = 0; i < visibleAssignments.size(); i++) {
+		if (visibleAssignments[i] != -1 && visibleAssignments[i] < (int)ballRemap.size()) {
+			visibleAssignments[i] = ballRemap[visibleAssignments[i]];
+		}
+	}
+}
+
+BallLocalizer::Grid::Grid(float cellSize, int bucketCount) : cellSize(cellSize), bucketCount(bucketCount) {
+	heads.resize(bucketCount, -1);
+}
+
+void BallLocalizer::Grid::build(const BallList& items) {
+	int bucket;
+
+	heads.assign(bucketCount, -1);
+	next.resize(items.size());
+
+	for (unsigned int i = 0; i < items.size(); i++) {
+		bucket = getBucket(getCell(items[i].x), getCell(items[i].y));
+
+		next[i] = heads[bucket];
+		heads[bucket] = i;
+	}
+}
+
+void BallLocalizer::Grid::findNear(float x, float y, float radius, const BallList& items, std::vector<int>& result) const {
+	int cellX = getCell(x);
+	int cellY = getCell(y);
+	int visitedBuckets[9];
+	int visitedCount = 0;
+	int bucket;
+	bool visited;
+
+	result.clear();
+
+	// the cell size is at least the search radius so the neighbouring cells cover it
+	for (int offsetY = -1; offsetY <= 1; offsetY++) {
+		for (int offsetX = -1; offsetX <= 1; offsetX++) {
+			bucket = getBucket(cellX + offsetX, cellY + offsetY);
+			visited = false;
+
+			// several cells may hash into the same bucket
+			for (int i = 0; i < visitedCount; i++) {
+				if (visitedBuckets[i] == bucket) {
+					visited = true;
+
+					break;
+				}
+			}
+
+			if (visited) {
+				continue;
+			}
+
+			visitedBuckets[visitedCount++] = bucket;
+
+			for (int index = heads[bucket]; index != -1; index = next[index]) {
+				if (Math::distanceBetween(items[index].x, items[index].y, x, y) <= radius) {
+					result.push_back(index);
+				}
+			}
+		}
+	}
+}
+
+int BallLocalizer::Grid::getCell(float value) const {
+	return (int)std::floor(value / cellSize);
+}
+
+int BallLocalizer::Grid::getBucket(int cellX, int cellY) const {
+	unsigned int hash = ((unsigned int)cellX * 73856093u) ^ ((unsigned int)cellY * 19349663u);
 
-    balls = remainingBalls;
+	return (int)(hash % (unsigned int)bucketCount);
 }
 
 /*bool BallLocalizer::isValid(Ball* ball, const BallList& visibleBalls, const Math::Polygon& cameraFOV) {
@@ -0,0 +1,177 @@
+#include "BinaryProtocol.h"
+
+#include <stdio.h>
+#include <string.h>
+
+BinaryProtocol::Decoder::Decoder() : state(STATE_IDLE), received(0), crc(0), errorCount(0) {
+
+}
+
+bool BinaryProtocol::Decoder::push(unsigned char byte, Frame& frame) {
+	switch (state) {
+		case STATE_IDLE:
+			if (byte == FRAME_START) {
+				state = STATE_TYPE;
+			}
+		break;
+
+		case STATE_TYPE:
+			current.type = byte;
+			state = STATE_LENGTH;
+		break;
+
+		case STATE_LENGTH:
+			current.length = byte;
+			received = 0;
+
+			if (!isValidLength(current.type, current.length)) {
+				errorCount++;
+				state = STATE_IDLE;
+			} else {
+				state = current.length > 0 ? STATE_PAYLOAD : STATE_CRC_HIGH;
+			}
+		break;
+
+		case STATE_PAYLOAD:
+			current.payload[received++] = byte;
+
+			if (received == current.length) {
+				state = STATE_CRC_HIGH;
+			}
+		break;
+
+		case STATE_CRC_HIGH:
+			crc = (unsigned short)(byte << 8);
+			state = STATE_CRC_LOW;
+		break;
+
+		case STATE_CRC_LOW: {
+			crc |= byte;
+			state = STATE_IDLE;
+
+			unsigned char header[2] = { current.type, current.length };
+			unsigned short expected = crc16(current.payload, current.length, crc16(header, 2));
+
+			if (crc != expected) {
+				errorCount++;
+
+				return false;
+			}
+
+			frame = current;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int BinaryProtocol::encodeSpeeds(unsigned char* buffer, int FL, int FR, int RL, int RR, int dribbler) {
+	int speeds[5] = { FL, FR, RL, RR, dribbler };
+	unsigned char payload[SPEEDS_PAYLOAD_SIZE];
+
+	for (int i = 0; i < 5; i++) {
+		int speed = speeds[i] < -32768 ? -32768 : speeds[i] > 32767 ? 32767 : speeds[i];
+		unsigned short value = (unsigned short)(short)speed;
+
+		payload[i * 2] = (unsigned char)(value & 0xFF);
+		payload[i * 2 + 1] = (unsigned char)(value >> 8);
+	}
+
+	return encode(buffer, TYPE_SPEEDS, payload, SPEEDS_PAYLOAD_SIZE);
+}
+
+int BinaryProtocol::encodeBall(unsigned char* buffer, bool detected) {
+	unsigned char payload[BALL_PAYLOAD_SIZE] = { (unsigned char)(detected ? 1 : 0) };
+
+	return encode(buffer, TYPE_BALL, payload, BALL_PAYLOAD_SIZE);
+}
+
+int BinaryProtocol::encodeText(unsigned char* buffer, const std::string& message) {
+	if (message.size() > MAX_PAYLOAD_SIZE) {
+		return 0;
+	}
+
+	return encode(buffer, TYPE_TEXT, (const unsigned char*)message.c_str(), (int)message.size());
+}
+
+std::string BinaryProtocol::toText(const Frame& frame) {
+	char text[MAX_TEXT_SIZE];
+	int length = toText(frame, text);
+
+	return std::string(text, length);
+}
+
+// the buffer has to fit MAX_TEXT_SIZE characters, returns the length without the terminating zero
+int BinaryProtocol::toText(const Frame& frame, char* buffer) {
+	switch (frame.type) {
+		case TYPE_SPEEDS: {
+			short speeds[5];
+
+			for (int i = 0; i < 5; i++) {
+				speeds[i] = (short)(frame.payload[i * 2] | (frame.payload[i * 2 + 1] << 8));
+			}
+
+			return sprintf(buffer, "<speeds:%d:%d:%d:%d:%d>", speeds[0], speeds[1], speeds[2], speeds[3], speeds[4]);
+		}
+
+		case TYPE_BALL:
+			return sprintf(buffer, "<ball:%d>", frame.payload[0] != 0 ? 1 : 0);
+
+		case TYPE_TEXT:
+			buffer[0] = '<';
+			memcpy(buffer + 1, frame.payload, frame.length);
+			buffer[frame.length + 1] = '>';
+			buffer[frame.length + 2] = 0;
+
+			return frame.length + 2;
+	}
+
+	buffer[0] = 0;
+
+	return 0;
+}
+
+bool BinaryProtocol::isValidLength(int type, int length) {
+	switch (type) {
+		case TYPE_SPEEDS:
+			return length == SPEEDS_PAYLOAD_SIZE;
+
+		case TYPE_BALL:
+			return length == BALL_PAYLOAD_SIZE;
+
+		case TYPE_TEXT:
+			return length <= MAX_PAYLOAD_SIZE;
+	}
+
+	return false;
+}
+
+// CRC-16/CCITT-FALSE
+unsigned short BinaryProtocol::crc16(const unsigned char* data, int length, unsigned short crc) {
+	for (int i = 0; i < length; i++) {
+		crc ^= (unsigned short)(data[i] << 8);
+
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) != 0 ? (unsigned short)((crc << 1) ^ 0x1021) : (unsigned short)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+int BinaryProtocol::encode(unsigned char* buffer, int type, const unsigned char* payload, int length) {
+	buffer[0] = FRAME_START;
+	buffer[1] = (unsigned char)type;
+	buffer[2] = (unsigned char)length;
+
+	memcpy(buffer + HEADER_SIZE, payload, length);
+
+	unsigned short crc = crc16(buffer + 1, HEADER_SIZE - 1 + length);
+
+	buffer[HEADER_SIZE + length] = (unsigned char)(crc >> 8);
+	buffer[HEADER_SIZE + length + 1] = (unsigned char)(crc & 0xFF);
+
+	return HEADER_SIZE + length + CRC_SIZE;
+}
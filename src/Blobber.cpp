@@ -1,4 +1,5 @@
 #include "Blobber.h"
+#include "Platform.h"
 
 #include <string>
 
@@ -634,6 +635,7 @@ void Blobber::clear() {
     ZERO(colors);
 
     map = NULL;
+    runCount = 0;
 }
 
 bool Blobber::initialize(int width, int height) {
@@ -1150,7 +1152,7 @@ bool Blobber::processFrame(Pixel* image) {
 
         classifyFrame(image,map);
 
-        runs = encodeRuns(runMap,map);
+        runs = runCount = encodeRuns(runMap,map);
         connectComponents(runMap,runs);
 
         blobs = extractBlobs(blobTable,runMap,runs);
@@ -1177,7 +1179,7 @@ bool Blobber::processFrame(unsigned int* map) {
 
     if(!map) return(false);
 
-    runs = encodeRuns(runMap,map);
+    runs = runCount = encodeRuns(runMap,map);
     connectComponents(runMap,runs);
 
     blobs = extractBlobs(blobTable,runMap,runs);
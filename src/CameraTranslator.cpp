@@ -2,6 +2,7 @@
 #include "Maths.h"
 
 #include <iostream>
+#include <climits>
 
 CameraTranslator::WorldPosition CameraTranslator::getWorldPosition(int cameraX, int cameraY) {
 	CameraPosition undistorted = undistort(cameraX, cameraY);
@@ -197,6 +198,45 @@ std::istream& operator >> (std::istream& inputStream, CameraTranslator::CameraMa
 	return inputStream;  
 }
 
+bool CameraTranslator::loadMappings(std::string distortXFilename, std::string distortYFilename) {
+	if (
+		!loadDistortionMapping(distortXFilename, distortYFilename)
+		|| distortMapX.size() != (unsigned int)cameraHeight || distortMapY.size() != (unsigned int)cameraHeight
+		|| distortMapX[0].size() != (unsigned int)cameraWidth || distortMapY[0].size() != (unsigned int)cameraWidth
+	) {
+		std::cout << "using identity mappings.. ";
+
+		setIdentityMappings();
+
+		return false;
+	}
+
+	CameraMapSet mapSet = generateInverseMap(distortMapX, distortMapY);
+
+	undistortMapX = mapSet.x;
+	undistortMapY = mapSet.y;
+
+	return true;
+}
+
+void CameraTranslator::setIdentityMappings() {
+	CameraMapRow rowX(cameraWidth);
+
+	for (int x = 0; x < cameraWidth; x++) {
+		rowX[x] = x;
+	}
+
+	distortMapX.assign(cameraHeight, rowX);
+	distortMapY.clear();
+
+	for (int y = 0; y < cameraHeight; y++) {
+		distortMapY.push_back(CameraMapRow(cameraWidth, y));
+	}
+
+	undistortMapX = distortMapX;
+	undistortMapY = distortMapY;
+}
+
 CameraTranslator::CameraMapSet CameraTranslator::generateInverseMap(CameraMap& mapX, CameraMap& mapY) {
 	CameraMap inverseMapX;
 	CameraMap inverseMapY;
@@ -0,0 +1,151 @@
+#include "CaptureThread.h"
+#include "FrameBufferPool.h"
+#include "Config.h"
+#include "Util.h"
+
+#include <boost/thread/thread_time.hpp>
+#include <string.h>
+
+CaptureThread::CaptureThread(BaseCamera* camera, int width, int height) :
+	camera(camera), width(width), height(height), running(true), slots(Config::captureSlotCount), newest(NULL), newestTaken(false)
+{
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		slots[i].frame.data = FrameBufferPool::acquire(FrameBufferPool::BAYER_FORMAT, width, height);
+		slots[i].frame.size = 0;
+		slots[i].frame.width = width;
+		slots[i].frame.height = height;
+		slots[i].frame.number = -1;
+		slots[i].frame.fresh = false;
+		slots[i].frame.timestamp = 0.0;
+	}
+}
+
+CaptureThread::~CaptureThread() {
+	close();
+	join();
+
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		FrameBufferPool::release(slots[i].frame.data);
+	}
+}
+
+void CaptureThread::close() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	running = false;
+
+	condition.notify_all();
+}
+
+CaptureThread::Slot* CaptureThread::takeFrame(double timeout) {
+	boost::mutex::scoped_lock lock(mutex);
+	boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds((long)(timeout * 1000000.0));
+
+	while (newest == NULL || newestTaken) {
+		if (!running || !condition.timed_wait(lock, deadline)) {
+			if (newest == NULL || newestTaken) {
+				return NULL;
+			}
+		}
+	}
+
+	newestTaken = true;
+	newest->references++;
+
+	return newest;
+}
+
+void CaptureThread::hold(Slot* slot) {
+	if (slot == NULL) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	slot->references++;
+}
+
+void CaptureThread::release(Slot* slot) {
+	if (slot == NULL) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	slot->references--;
+}
+
+CaptureThread::Stats CaptureThread::getStats() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return stats;
+}
+
+void* CaptureThread::run() {
+	int size = width * height;
+
+	while (true) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+
+			if (!running) {
+				break;
+			}
+		}
+
+		if (!camera->isAcquisitioning()) {
+			Util::sleep(10);
+
+			continue;
+		}
+
+		// blocks until the camera has the next frame
+		const BaseCamera::Frame* cameraFrame = camera->getFrame();
+
+		if (cameraFrame == NULL || !cameraFrame->fresh || cameraFrame->data == NULL) {
+			continue;
+		}
+
+		Slot* slot = getFreeSlot();
+
+		if (slot == NULL) {
+			continue;
+		}
+
+		memcpy(slot->frame.data, cameraFrame->data, cameraFrame->size < size ? cameraFrame->size : size);
+
+		slot->frame.size = cameraFrame->size < size ? cameraFrame->size : size;
+		slot->frame.number = cameraFrame->number;
+		slot->frame.timestamp = cameraFrame->timestamp;
+		slot->frame.fresh = true;
+
+		boost::mutex::scoped_lock lock(mutex);
+
+		if (newest != NULL && !newestTaken) {
+			stats.stale++;
+		}
+
+		newest = slot;
+		newestTaken = false;
+		stats.captured++;
+
+		condition.notify_all();
+	}
+
+	return NULL;
+}
+
+CaptureThread::Slot* CaptureThread::getFreeSlot() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	// the newest frame stays until a newer one is complete
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		if (&slots[i] != newest && slots[i].references == 0) {
+			return &slots[i];
+		}
+	}
+
+	stats.overruns++;
+
+	return NULL;
+}
@@ -1,13 +1,16 @@
 #include "Coilgun.h"
 #include "AbstractCommunication.h"
+#include "Dribbler.h"
 #include "Util.h"
 #include "Maths.h"
 #include "Config.h"
 #include "Command.h"
 
 #include <iostream>
+#include <algorithm>
+#include <stdio.h>
 
-Coilgun::Coilgun(AbstractCommunication* com) : com(com), lastKickTime(0.0), lastChargeRequestTime(0.0), lastBdkickRequestTime(0.0), timeSinceLastVoltageReading(0.0f), voltage(0.0f), isKickingOnceGotBall(false), kickOnceGotBallMissedFrames(0) {
+Coilgun::Coilgun(AbstractCommunication* com) : com(com), dribbler(NULL), lastKickTime(0.0), lastChargeRequestTime(0.0), timeSinceLastVoltageReading(0.0f), voltage(0.0f), isKickingOnceGotBall(false), kickOnceGotBallMissedFrames(0), armedKick(0), gotBallKickSent(false) {
 
 };
 
@@ -99,20 +102,26 @@ void Coilgun::kickOnceGotBall(int mainDuration, int mainDelay, float chipDistanc
 	float kickDistance = Math::min(kickOnceGotBallParameters.chipDistance, maxChipKickDistance);
 	int chipDuration = kickDistance > 0 ? getChipKickDurationByDistance(kickDistance) : 0;
 
-	std::string parametersStr = Util::toString(kickOnceGotBallParameters.mainDuration) + ":" + Util::toString(kickOnceGotBallParameters.mainDelay) + ":" + Util::toString(chipDuration) + ":" + Util::toString(kickOnceGotBallParameters.chipDelay);
-
 	/*if (chipDistance > 0) {
 		std::cout << "! Chip-kicking once got the ball to " << chipDistance << " meters" << std::endl;
 	} else {
-		std::cout << "! Kicking once got the ball: " << parametersStr << std::endl;
+		std::cout << "! Kicking once got the ball: " << mainDuration << ", chip: " << chipDuration << std::endl;
 	}*/
 
-	com->send("bdkick:" + parametersStr);
+	// the kick is sent by the communication thread as soon as the ball is detected
+	armedKick.store(packKick(kickOnceGotBallParameters.mainDuration, kickOnceGotBallParameters.mainDelay, chipDuration, kickOnceGotBallParameters.chipDelay), std::memory_order_release);
 
 	isKickingOnceGotBall = true;
+
+	// the firmware only reports the ball when it changes
+	if (dribbler != NULL && dribbler->gotBall(true)) {
+		sendArmedKick();
+	}
 }
 
 void Coilgun::cancelKickOnceGotBall(bool force) {
+	armedKick.store(0, std::memory_order_release);
+
 	if (!isKickingOnceGotBall && force != true) {
 		return;
 	}
@@ -130,18 +139,10 @@ void Coilgun::step(float dt) {
 		charge();
 	}
 
-	if (Util::duration(lastBdkickRequestTime) >= 1.0) {
-		if (isKickingOnceGotBall) {
-			int chipDuration = kickOnceGotBallParameters.chipDistance > 0 ? getChipKickDurationByDistance(kickOnceGotBallParameters.chipDistance) : 0;
-
-			std::string parametersStr = Util::toString(kickOnceGotBallParameters.mainDuration) + ":" + Util::toString(kickOnceGotBallParameters.mainDelay) + ":" + Util::toString(chipDuration) + ":" + Util::toString(kickOnceGotBallParameters.chipDelay);
-
-			com->send("bdkick:" + parametersStr);	
-		} else {
-			com->send("nokick");
-		}
-
-		lastBdkickRequestTime = Util::millitime();
+	if (gotBallKickSent.exchange(false, std::memory_order_acquire)) {
+		isKickingOnceGotBall = false;
+		kickOnceGotBallParameters = KickParameters();
+		lastKickTime = Util::millitime();
 	}
 
 	timeSinceLastVoltageReading += dt;
@@ -160,6 +161,46 @@ void Coilgun::step(float dt) {
 	}
 }
 
+void Coilgun::onCommunicationReceive(const StringView& message) {
+	if (!message.startsWith("<ball:1")) {
+		return;
+	}
+
+	sendArmedKick();
+}
+
+void Coilgun::sendArmedKick() {
+	unsigned long long kick = armedKick.exchange(0, std::memory_order_acq_rel);
+
+	if ((kick & KICK_ARMED) == 0) {
+		return;
+	}
+
+	char command[64];
+
+	sprintf(
+		command,
+		"dkick:%d:%d:%d:%d",
+		(int)((kick >> 1) & 0xFFFF),
+		(int)((kick >> 17) & 0xFFFF),
+		(int)((kick >> 33) & 0xFFFF),
+		(int)((kick >> 49) & 0x7FFF)
+	);
+
+	com->send(command);
+	com->flush();
+
+	gotBallKickSent.store(true, std::memory_order_release);
+}
+
+unsigned long long Coilgun::packKick(int mainDuration, int mainDelay, int chipDuration, int chipDelay) {
+	return KICK_ARMED
+		| ((unsigned long long)std::max(0, std::min(mainDuration, 0xFFFF)) << 1)
+		| ((unsigned long long)std::max(0, std::min(mainDelay, 0xFFFF)) << 17)
+		| ((unsigned long long)std::max(0, std::min(chipDuration, 0xFFFF)) << 33)
+		| ((unsigned long long)std::max(0, std::min(chipDelay, 0x7FFF)) << 49);
+}
+
 void Coilgun::requestVoltageReading() {
 	com->send("adc");
 }
@@ -4,7 +4,8 @@
 ComPortCommunication::ComPortCommunication(std::string portName, int baud) :
 portName(portName),
 baud(baud),
-receivingMessage(false),
+framer(Config::serialReceiveBufferSize),
+scheduler(Config::communicationQueueSize),
 opened(false)
 {
 	// http://support.microsoft.com/kb/115831
@@ -76,111 +77,51 @@ ComPortCommunication::PortList ComPortCommunication::getPortList() {
 }
 
 void ComPortCommunication::send(std::string message) {
-	boost::mutex::scoped_lock lock(messagesMutex);
+	// messages added while the port is closed wait in the scheduler, drops are counted in the send stats
+	scheduler.add(message);
+}
 
-	sendQueue.push(message);
+void ComPortCommunication::sendFrame(const unsigned char* data, int length) {
+	scheduler.addFrame(data, length);
 }
 
 void ComPortCommunication::sync() {
-
-	//return;
-
-	boost::mutex::scoped_lock lock(messagesMutex);
-
-	if (sendQueue.size() == 0) {
-		return;
-	}
-
-	std::string message = "";
-	std::string queuedMessage;
-	int messageCount = sendQueue.size();
-
-	while (sendQueue.size() > 0) {
-		queuedMessage = sendQueue.front();
-
-		sendQueue.pop();
-
-		message += queuedMessage + "\n";
-
-		//if (queuedMessage.substr(0, 6) != "speeds" && queuedMessage.substr(0, 3) != "adc") {
-			std::cout << "SEND: " << queuedMessage << " [" << sendQueue.size() << "]" << std::endl;
-		//}
-	}
-
-	if (message.size() >= MAX_SIZE) {
-		std::cout << "- Too big socket message" << std::endl;
-
-		return;
-	}
-
 	if (!opened) {
-		std::cout << "QUEUE " << message << std::endl;
-
-		queuedMessages.push(message);
-
 		return;
 	}
 
-	while (!queuedMessages.empty()) {
-		std::cout << "! Socket queue size: " << queuedMessages.size() << std::endl;
-
-		std::string queuedMessage = queuedMessages.front();
-		queuedMessages.pop();
+	// whatever does not fit in the buffer stays pending for the next sync
+	int length = scheduler.flush(requestBuffer, MAX_SIZE, binaryProtocol);
 
-		send(queuedMessage);
+	if (length == 0) {
+		return;
 	}
 
-	/*if (message.substr(0, 6) != "speeds") {
-	std::cout << "SEND > " << message << std::endl;
-	}*/
-
-	//message += "\n";
-
-	//std::cout << "SEND " << messageCount << " MESSAGES: " << message << std::endl;
-
-
-	memcpy(requestBuffer, message.c_str(), message.size());
-	requestBuffer[message.size()] = 0;
-
 	try {
 		DWORD numWritten;
-		WriteFile(commHandle, requestBuffer, message.size(), &numWritten, NULL);
-		//WriteFile(commHandle, message.c_str(), message.size(), &numWritten, NULL);
+		WriteFile(commHandle, requestBuffer, length, &numWritten, NULL);
 	} catch (...) {
-		std::cout << "- ComPortCommunication sending " << message << " failed" << std::endl;
+		std::cout << "- ComPortCommunication sending " << length << " bytes failed" << std::endl;
 	}
 }
 
-bool ComPortCommunication::gotMessages() {
-	boost::mutex::scoped_lock lock(messagesMutex);
-
-	return messages.size() > 0;
-}
-
-std::string ComPortCommunication::dequeueMessage() {
-	boost::mutex::scoped_lock lock(messagesMutex);
-
-	int messageCount = messages.size();
+AbstractCommunication::SendStats ComPortCommunication::getSendStats() const {
+	SendStats stats;
 
-	if (messageCount == 0) {
-		//std::cout << "R [" << messageCount << "]" << std::endl;
+	stats.pending = scheduler.getPendingCount();
+	stats.coalesced = scheduler.getCoalescedCount();
+	stats.dropped = scheduler.getDroppedCount();
+	stats.datagrams = scheduler.getDatagramCount();
 
-		return "";
-	}
-
-	std::string message = messages.front();
-
-	messages.pop();
-
-	//if (message.substr(0, 7) != "<speeds" && message.substr(0, 4) != "<adc") {
-		std::cout << "RECV: '" << message << "' [" << (messageCount - 1) << "]" << std::endl;
-	//}
-
-	return message;
+	return stats;
 }
 
 void ComPortCommunication::close() {
-	CloseHandle(commHandle);
+	if (commHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(commHandle);
+
+		commHandle = INVALID_HANDLE_VALUE;
+	}
 
 	opened = false;
 }
@@ -203,47 +144,7 @@ void* ComPortCommunication::run() {
 
 		//std::cout << "@ READ " << numRead << " BYTES" << std::endl;
 
-		for (unsigned int i = 0; i < numRead; i++) {
-			char c = readBuffer[i];
-
-			if (c == '\n') {
-				//std::cout << "@ GOT LF" << std::endl;
-			} else {
-				if (c == '<') {
-					if (receivingMessage) {
-						std::cout << "@ GOT '<' BUT WAS ALREADY RECEIVING MESSAGE '" << partialMessage << "', BUFFER: '" << readBuffer << "', THIS SHOULD NOT HAPPEN" << std::endl;
-					}
-
-					receivingMessage = true;
-				}
-
-				if (receivingMessage) {
-					partialMessage += c;
-				} else {
-					std::cout << "# '" << c << std::endl;
-				}
-
-				if (c == '>') {
-					if (!receivingMessage) {
-						std::cout << "@ GOT '>' BUT WAS NOT RECEIVING MESSAGE, THIS SHOULD NOT HAPPEN" << std::endl;
-					}
-
-					receivingMessage = false;
-
-					if (partialMessage.size() > 0) {
-						boost::mutex::scoped_lock lock(messagesMutex);
-
-						messages.push(partialMessage);
-
-						//std::cout << "C < " << partialMessage << " [" << messages.size() << "]" << std::endl;
-
-						partialMessage = "";
-					} else {
-						std::cout << "@ GOT'>' BUT PARTIAL MESSAGE WAS EMPTY, THIS SHOULD NOT HAPPEN" << std::endl;
-					}
-				}
-			}
-		}
+		receiveBytes(framer, readBuffer, (int)numRead);
 	}
 
 	return NULL;
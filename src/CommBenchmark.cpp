@@ -0,0 +1,216 @@
+#include "CommBenchmark.h"
+#include "FirmwareStub.h"
+#include "EthernetCommunication.h"
+#include "SerialCommunication.h"
+#include "Config.h"
+#include "Util.h"
+
+#include <iostream>
+#include <algorithm>
+
+CommBenchmark::CommBenchmark(Transport transport, int delay, float loss) :
+	transport(transport), delay(delay), loss(loss), stub(NULL), com(NULL), messages(Config::messageBatchSize), otherReplyCount(0)
+{
+	for (int i = 0; i < SEQUENCE_COUNT; i++) {
+		sendTimes[i] = 0.0;
+	}
+}
+
+CommBenchmark::~CommBenchmark() {
+	if (com != NULL) delete com; com = NULL;
+	if (stub != NULL) delete stub; stub = NULL;
+}
+
+void CommBenchmark::setSerialPorts(const std::string& stubDevice, const std::string& device) {
+	this->stubDevice = stubDevice;
+	this->device = device;
+}
+
+bool CommBenchmark::setup() {
+	if (transport == ETHERNET) {
+		stub = new FirmwareStub(Config::firmwareStubPort);
+	} else {
+		stub = new FirmwareStub(stubDevice.empty() ? "pty" : stubDevice, Config::serialBaud);
+	}
+
+	stub->setDelay(delay);
+	stub->setLoss(loss);
+
+	if (!stub->open()) {
+		return false;
+	}
+
+	stub->start();
+
+	try {
+		if (transport == ETHERNET) {
+			com = new EthernetCommunication("127.0.0.1", Config::firmwareStubPort, Config::communicationPort);
+		} else {
+			com = new SerialCommunication(device.empty() ? stub->getDeviceName() : device, Config::serialBaud);
+		}
+	} catch (std::exception& e) {
+		std::cout << "- Opening communication link failed: " << e.what() << std::endl;
+
+		return false;
+	}
+
+	com->addReceiveListener(this);
+	com->start();
+
+	if (Config::communicationProtocol == Config::BINARY_PROTOCOL) {
+		// the request itself may get lost
+		for (int i = 0; i < 10 && !com->isBinaryProtocol(); i++) {
+			com->requestBinaryProtocol();
+			com->flush();
+			com->sync();
+
+			Util::sleep(100 + delay);
+			drain();
+		}
+
+		if (!com->isBinaryProtocol()) {
+			std::cout << "- Firmware stub did not acknowledge the binary protocol, using text" << std::endl;
+		}
+	}
+
+	return true;
+}
+
+void CommBenchmark::run(double duration, int rate) {
+	std::cout << "! Benchmarking " << (transport == ETHERNET ? "ethernet" : "serial") << " communication at " << rate << " commands/s for " << duration << "s" << std::endl;
+
+	double interval = 1.0 / rate;
+	double startTime = Util::preciseTime();
+	double nextTick = startTime;
+	int sentCount = 0;
+
+	while (nextTick - startTime < duration) {
+		tick(1 + sentCount % (SEQUENCE_COUNT - 1), sentCount);
+		drain();
+
+		sentCount++;
+		nextTick += interval;
+
+		while (Util::preciseTime() < nextTick) {
+			if (nextTick - Util::preciseTime() > 0.002) {
+				Util::sleep(1);
+			}
+		}
+	}
+
+	double sendDuration = Util::preciseTime() - startTime;
+
+	// let the delayed feedback arrive
+	Util::sleep(delay + 250);
+	drain();
+
+	report(sentCount, sendDuration, rate);
+}
+
+void CommBenchmark::tick(int sequence, int tickIndex) {
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		sendTimes[sequence] = Util::preciseTime();
+	}
+
+	com->sendSpeeds(sequence, -100, 100, -100, 50);
+
+	// roughly what the robot sends besides the speeds
+	if (tickIndex % 4 == 0) {
+		com->send("adc");
+	}
+
+	if (tickIndex % 50 == 0) {
+		com->send("charge");
+	}
+
+	if (tickIndex % 200 == 100) {
+		com->send("kick:2000");
+	}
+
+	com->flush();
+	com->sync();
+}
+
+void CommBenchmark::drain() {
+	while (com->dequeueMessages(&messages[0], (int)messages.size()) > 0);
+}
+
+void CommBenchmark::onCommunicationReceive(const StringView& message) {
+	double receiveTime = Util::preciseTime();
+
+	if (!message.startsWith("<speeds:")) {
+		boost::mutex::scoped_lock lock(mutex);
+
+		otherReplyCount++;
+
+		return;
+	}
+
+	StringView parameters = message.substr(8);
+	const char* end = (const char*)memchr(parameters.getData(), ':', parameters.getLength());
+	double value;
+
+	if (end == NULL || !StringView(parameters.getData(), (int)(end - parameters.getData())).toDouble(value)) {
+		return;
+	}
+
+	int sequence = (int)value;
+
+	if (sequence <= 0 || sequence >= SEQUENCE_COUNT) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	// feedback of a sequence number that was already answered or has wrapped around is not counted
+	if (sendTimes[sequence] != 0.0) {
+		latencies.push_back(receiveTime - sendTimes[sequence]);
+		sendTimes[sequence] = 0.0;
+	}
+}
+
+void CommBenchmark::report(int sentCount, double duration, int rate) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	std::vector<double> sorted = latencies;
+	int receivedCount = (int)sorted.size();
+	double sum = 0.0;
+
+	std::sort(sorted.begin(), sorted.end());
+
+	for (int i = 0; i < receivedCount; i++) {
+		sum += sorted[i];
+	}
+
+	AbstractCommunication::SendStats sendStats = com->getSendStats();
+
+	std::cout << "! Sent " << sentCount << " speeds in " << duration << "s, " << (int)(sentCount / duration) << "/s of " << rate << "/s requested" << std::endl;
+	std::cout << "  > feedback: " << receivedCount << " received, " << (int)(receivedCount / duration) << "/s, " << (sentCount > 0 ? 100.0 * (sentCount - receivedCount) / sentCount : 0.0) << "% missing" << std::endl;
+
+	if (receivedCount > 0) {
+		std::cout << "  > latency ms: min " << sorted[0] * 1000.0
+			<< ", avg " << sum / receivedCount * 1000.0
+			<< ", p50 " << percentile(sorted, 0.5) * 1000.0
+			<< ", p99 " << percentile(sorted, 0.99) * 1000.0
+			<< ", max " << sorted[receivedCount - 1] * 1000.0 << std::endl;
+	}
+
+	std::cout << "  > other replies: " << otherReplyCount << ", " << (com->isBinaryProtocol() ? "binary" : "text") << " protocol, " << com->getDroppedMessageCount() << " dropped from the receive queue" << std::endl;
+	std::cout << "  > stub: " << stub->getReceivedCount() << " commands received, " << stub->getRepliedCount() << " replies sent, " << stub->getLostCount() << " lost on purpose" << std::endl;
+
+	if (transport == ETHERNET) {
+		std::cout << "  > send: " << sendStats.datagrams << " datagrams, " << sendStats.coalesced << " coalesced, " << sendStats.dropped << " dropped, " << sendStats.backPressure << " held back, max " << sendStats.maxInFlight << " in flight" << std::endl;
+	}
+}
+
+double CommBenchmark::percentile(const std::vector<double>& sorted, double fraction) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+
+	int index = (int)(fraction * (sorted.size() - 1) + 0.5);
+
+	return sorted[index];
+}
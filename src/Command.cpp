@@ -3,6 +3,7 @@
 #include "Util.h"
 
 #include <iostream>
+#include <string.h>
 
 bool Command::isValid(std::string input) {
     //return input.substr(0, 1) == "<" && input.substr(input.length() - 1, 1) == ">";
@@ -10,55 +11,68 @@ bool Command::isValid(std::string input) {
 }
 
 Command Command::parse(std::string input) {
-    std::string name;
-    std::vector<std::string> params;
-    //std::string body = input.substr(1).substr(0, input.length() - 2);
-    std::string body;
-	char character;
-	bool started = false;
+    View view;
 
-	for (unsigned int i = 0; i < input.size(); i++) {
-		character = input[i];
+    if (!tokenize(input.c_str(), (int)input.size(), view)) {
+        std::cout << "- Command has too many parameters: " << input << std::endl;
+    }
 
-		if (character == '<') {
-			started = true;
+    return Command(view);
+}
 
-			continue;
-		} else if (character == '>') {
-			break;
-		}
+bool Command::tokenize(const char* input, int length, View& view) {
+    const char* start = (const char*)memchr(input, '<', length);
+    const char* end;
 
-		if (started) {
-			body += character;
-		}
-	}
+    view.parameterCount = 0;
 
-    size_t colonPos = Util::strpos(body, ":");
+    if (start == NULL) {
+        view.name = StringView();
 
-    if (colonPos == std::string::npos) {
-        name = body;
-    } else {
-        name = body.substr(0, colonPos);
+        return true;
+    }
 
-        std::string paramsBody = body.substr(colonPos + 1);
+    start++;
+    end = (const char*)memchr(start, '>', input + length - start);
 
-        std::string param;
+    if (end == NULL) {
+        end = input + length;
+    }
 
-        while (true) {
-            colonPos = Util::strpos(paramsBody, ":");
+    const char* colon = (const char*)memchr(start, ':', end - start);
 
-            if (colonPos == std::string::npos) {
-                break;
-            }
+    if (colon == NULL) {
+        view.name = StringView(start, (int)(end - start));
 
-            param = paramsBody.substr(0, colonPos);
-            paramsBody = paramsBody.substr(colonPos + 1);
+        return true;
+    }
+
+    view.name = StringView(start, (int)(colon - start));
 
-            params.push_back(param);
+    while (colon != NULL) {
+        if (view.parameterCount == MAX_PARAMETERS) {
+            return false;
         }
 
-        params.push_back(paramsBody);
+        start = colon + 1;
+        colon = (const char*)memchr(start, ':', end - start);
+
+        view.parameters[view.parameterCount++] = StringView(start, (int)((colon != NULL ? colon : end) - start));
     }
 
-    return Command(name, params);
+    return true;
+}
+
+Command::Command(const View& view) : name(view.name.toString()) {
+    parameters.reserve(view.parameterCount);
+
+    for (int i = 0; i < view.parameterCount; i++) {
+        parameters.push_back(view.parameters[i].toString());
+    }
+}
+
+Command::View::View(const Command& command) : name(command.name), parameterCount(0) {
+    for (int i = 0; i < (int)command.parameters.size() && i < MAX_PARAMETERS; i++) {
+        parameters[parameterCount++] = StringView(command.parameters[i]);
+    }
 }
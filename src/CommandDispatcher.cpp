@@ -0,0 +1,129 @@
+#include "CommandDispatcher.h"
+
+#include <iostream>
+
+CommandDispatcher::CommandDispatcher(int capacity) : count(0) {
+	int size = 1;
+
+	// kept at most half full so probe sequences stay short
+	while (size < capacity * 2) {
+		size <<= 1;
+	}
+
+	entries.resize(size);
+	mask = size - 1;
+}
+
+void CommandDispatcher::add(const std::string& name, const std::string& signature, Handler handler) {
+	if ((count + 1) * 2 > (int)entries.size()) {
+		std::vector<Entry> previous;
+
+		previous.swap(entries);
+		entries.resize(previous.size() * 2);
+		mask = (unsigned int)entries.size() - 1;
+		count = 0;
+
+		for (std::vector<Entry>::iterator it = previous.begin(); it != previous.end(); it++) {
+			if (it->used) {
+				add(it->name, it->signature, it->handler);
+			}
+		}
+	}
+
+	bool variadic = !signature.empty() && signature[signature.size() - 1] == '*';
+	int parameterCount = variadic ? VARIADIC : (int)signature.size();
+	unsigned int hash = getHash(StringView(name).hash(), parameterCount);
+	unsigned int index = hash & mask;
+
+	while (entries[index].used) {
+		if (entries[index].hash == hash && entries[index].name == name && entries[index].parameterCount == parameterCount) {
+			std::cout << "- Command handler for '" << name << "' with signature '" << signature << "' is already registered" << std::endl;
+
+			return;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	Entry& entry = entries[index];
+
+	entry.used = true;
+	entry.name = name;
+	entry.signature = signature;
+	entry.parameterCount = parameterCount;
+	entry.hash = hash;
+	entry.handler = handler;
+
+	count++;
+}
+
+bool CommandDispatcher::dispatch(const Command::View& command) {
+	unsigned int nameHash = command.name.hash();
+	const Entry* entry = find(command.name, nameHash, command.parameterCount);
+
+	if (entry == NULL) {
+		entry = find(command.name, nameHash, VARIADIC);
+	}
+
+	if (entry == NULL) {
+		return false;
+	}
+
+	Arguments arguments;
+
+	if (!convert(*entry, command, arguments)) {
+		return false;
+	}
+
+	entry->handler(arguments);
+
+	return true;
+}
+
+unsigned int CommandDispatcher::getHash(unsigned int nameHash, int parameterCount) {
+	return (nameHash ^ (unsigned int)(parameterCount + 1)) * 16777619u;
+}
+
+const CommandDispatcher::Entry* CommandDispatcher::find(const StringView& name, unsigned int nameHash, int parameterCount) const {
+	unsigned int hash = getHash(nameHash, parameterCount);
+	unsigned int index = hash & mask;
+
+	while (entries[index].used) {
+		const Entry& entry = entries[index];
+
+		if (entry.hash == hash && entry.parameterCount == parameterCount && name == StringView(entry.name)) {
+			return &entry;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	return NULL;
+}
+
+bool CommandDispatcher::convert(const Entry& entry, const Command::View& command, Arguments& arguments) const {
+	const std::string& signature = entry.signature;
+	int typedCount = entry.parameterCount == VARIADIC ? (int)signature.size() - 1 : (int)signature.size();
+
+	if (command.parameterCount < typedCount) {
+		return false;
+	}
+
+	for (int i = 0; i < command.parameterCount; i++) {
+		arguments.views[i] = command.parameters[i];
+		arguments.numbers[i] = 0.0;
+
+		if (i >= typedCount || signature[i] == 's') {
+			continue;
+		}
+
+		// integers are accepted in any numeric format and truncated, as clients may send them as floats
+		if (!command.parameters[i].toDouble(arguments.numbers[i])) {
+			return false;
+		}
+	}
+
+	arguments.count = command.parameterCount;
+
+	return true;
+}
@@ -0,0 +1,163 @@
+#include "CommandScheduler.h"
+
+#include <string.h>
+
+CommandScheduler::CommandScheduler(int capacity) : entryCount(0), capacity(capacity), coalescedCount(0), droppedCount(0), datagramCount(0), sentCount(0) {
+	entries.resize(capacity);
+}
+
+bool CommandScheduler::add(const std::string& message) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	Entry* entry = reserve(message.substr(0, message.find(':')));
+
+	if (entry == NULL) {
+		return false;
+	}
+
+	entry->data = message;
+	entry->frame = false;
+
+	return true;
+}
+
+bool CommandScheduler::addFrame(const unsigned char* data, int length) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	// binary frames share the key of the text command they replace
+	Entry* entry = reserve(length > 1 && data[1] == BinaryProtocol::TYPE_SPEEDS ? "speeds" : "");
+
+	if (entry == NULL) {
+		return false;
+	}
+
+	entry->data.assign((const char*)data, length);
+	entry->frame = true;
+
+	return true;
+}
+
+int CommandScheduler::flush(unsigned char* buffer, int maxLength, bool binary) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (entryCount == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < entryCount && !binary; i++) {
+		if (entries[i].frame) {
+			binary = true;
+		}
+	}
+
+	int length = 0;
+	int sent = 0;
+
+	while (sent < entryCount) {
+		int entryLength = encode(entries[sent], buffer + length, maxLength - length, binary);
+
+		if (entryLength == 0) {
+			break;
+		}
+
+		length += entryLength;
+		sent++;
+	}
+
+	sentCount += sent;
+
+	if (sent == 0) {
+		// never fits in a datagram, drop it so the rest can go out
+		sent = 1;
+		droppedCount++;
+	}
+
+	// whatever did not fit is sent on the next tick
+	for (int i = sent; i < entryCount; i++) {
+		std::swap(entries[i - sent], entries[i]);
+	}
+
+	entryCount -= sent;
+
+	if (length > 0) {
+		datagramCount++;
+	}
+
+	return length;
+}
+
+int CommandScheduler::getPendingCount() const {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return entryCount;
+}
+
+bool CommandScheduler::isIdempotent(const std::string& name) {
+	return name == "speeds"
+		|| name == "servos"
+		|| name == "charge"
+		|| name == "adc"
+		|| name == "target";
+}
+
+CommandScheduler::Entry* CommandScheduler::reserve(const std::string& name) {
+	if (isIdempotent(name)) {
+		for (int i = 0; i < entryCount; i++) {
+			if (entries[i].name != name) {
+				continue;
+			}
+
+			// the newest value moves to the end so it keeps its order relative to commands such as discharge
+			for (int j = i; j < entryCount - 1; j++) {
+				std::swap(entries[j], entries[j + 1]);
+			}
+
+			coalescedCount++;
+
+			return &entries[entryCount - 1];
+		}
+	}
+
+	if (entryCount >= capacity) {
+		droppedCount++;
+
+		return NULL;
+	}
+
+	Entry* entry = &entries[entryCount++];
+
+	entry->name = name;
+
+	return entry;
+}
+
+int CommandScheduler::encode(const Entry& entry, unsigned char* buffer, int maxLength, bool binary) {
+	int length = (int)entry.data.size();
+
+	if (entry.frame) {
+		if (length > maxLength) {
+			return 0;
+		}
+
+		memcpy(buffer, entry.data.c_str(), length);
+
+		return length;
+	}
+
+	if (binary) {
+		if (length > BinaryProtocol::MAX_PAYLOAD_SIZE || BinaryProtocol::HEADER_SIZE + length + BinaryProtocol::CRC_SIZE > maxLength) {
+			return 0;
+		}
+
+		return BinaryProtocol::encodeText(buffer, entry.data);
+	}
+
+	if (length + 1 > maxLength) {
+		return 0;
+	}
+
+	memcpy(buffer, entry.data.c_str(), length);
+	buffer[length] = '\n';
+
+	return length + 1;
+}
@@ -0,0 +1,86 @@
+#include "DispatchBenchmark.h"
+#include "Util.h"
+
+#include <iostream>
+
+#include <boost/bind.hpp>
+
+DispatchBenchmark::DispatchBenchmark() : sink(0.0), handledCount(0) {
+	commands.add("target-vector", "fff", boost::bind(&DispatchBenchmark::handleTargetVector, this, _1));
+	commands.add("kick", "i", boost::bind(&DispatchBenchmark::handleKick, this, _1));
+	commands.add("parameter", "is", boost::bind(&DispatchBenchmark::handleParameter, this, _1));
+	commands.add("blobber-threshold", "siiiif", boost::bind(&DispatchBenchmark::handleBlobberThreshold, this, _1));
+	commands.add("get-state", "*", boost::bind(&DispatchBenchmark::handleRequest, this));
+	commands.add("get-frame", "*", boost::bind(&DispatchBenchmark::handleRequest, this));
+
+	// roughly the mix the dashboard sends while driving manually
+	messages.push_back("<target-vector:0.5:-0.25:1.5>");
+	messages.push_back("<target-vector:1:0:-0.75>");
+	messages.push_back("<get-state>");
+	messages.push_back("<get-frame>");
+	messages.push_back("<kick:2000>");
+	messages.push_back("<parameter:2:fetch-ball-near>");
+	messages.push_back("<blobber-threshold:ball:320:240:1:5:2.5>");
+	messages.push_back("<unknown-command:1:2>");
+}
+
+void DispatchBenchmark::run(int iterations) {
+	std::cout << "! Benchmarking command dispatch with " << iterations << " messages" << std::endl;
+
+	double viewRate = measureViews(iterations);
+	double commandRate = measureCommands(iterations);
+
+	std::cout << "  > in place: " << (int)viewRate << " messages/s" << std::endl;
+	std::cout << "  > through Command: " << (int)commandRate << " messages/s" << std::endl;
+	std::cout << "  > handled " << handledCount << " (" << sink << ")" << std::endl;
+}
+
+double DispatchBenchmark::measureViews(int iterations) {
+	Command::View view;
+	int messageCount = (int)messages.size();
+	double startTime = Util::preciseTime();
+
+	for (int i = 0; i < iterations; i++) {
+		const std::string& message = messages[i % messageCount];
+
+		Command::tokenize(message.c_str(), (int)message.size(), view);
+		commands.dispatch(view);
+	}
+
+	return iterations / (Util::preciseTime() - startTime);
+}
+
+double DispatchBenchmark::measureCommands(int iterations) {
+	int messageCount = (int)messages.size();
+	double startTime = Util::preciseTime();
+
+	for (int i = 0; i < iterations; i++) {
+		commands.dispatch(Command::parse(messages[i % messageCount]));
+	}
+
+	return iterations / (Util::preciseTime() - startTime);
+}
+
+void DispatchBenchmark::handleTargetVector(const CommandDispatcher::Arguments& args) {
+	sink += args.getFloat(0) + args.getFloat(1) + args.getFloat(2);
+	handledCount++;
+}
+
+void DispatchBenchmark::handleKick(const CommandDispatcher::Arguments& args) {
+	sink += args.getInt(0);
+	handledCount++;
+}
+
+void DispatchBenchmark::handleParameter(const CommandDispatcher::Arguments& args) {
+	sink += args.getInt(0) + args.getView(1).getLength();
+	handledCount++;
+}
+
+void DispatchBenchmark::handleBlobberThreshold(const CommandDispatcher::Arguments& args) {
+	sink += args.getInt(1) + args.getInt(2) + args.getFloat(5);
+	handledCount++;
+}
+
+void DispatchBenchmark::handleRequest() {
+	handledCount++;
+}
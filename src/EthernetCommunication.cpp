@@ -3,8 +3,13 @@
 
 #include <boost/bind.hpp>
 
-EthernetCommunication::EthernetCommunication(std::string host, int port) : host(host), port(port), running(false), socket(NULL), receiveBuffer2(boost::asio::buffer(receiveBuffer, MAX_SIZE)) {
+EthernetCommunication::EthernetCommunication(std::string host, int port, int localPort) : host(host), port(port), localPort(localPort != -1 ? localPort : port), running(false), socket(NULL), receiveBuffer2(boost::asio::buffer(receiveBuffer, MAX_SIZE)), flushTimer(ioService), scheduler(Config::communicationQueueSize), flushPosted(false), sendsInFlight(0), maxSendsInFlight(0), backPressureCount(0), sendErrorCount(0) {
+	for (int i = 0; i < Config::communicationSendBufferCount; i++) {
+		SendBuffer* buffer = new SendBuffer();
 
+		sendBuffers.push_back(buffer);
+		freeSendBuffers.push(buffer);
+	}
 }
 
 EthernetCommunication::~EthernetCommunication() {
@@ -16,6 +21,12 @@ EthernetCommunication::~EthernetCommunication() {
 	std::cout << "done!" << std::endl;
 
 	if (socket != NULL) delete socket; socket = NULL;
+
+	for (std::vector<SendBuffer*>::iterator it = sendBuffers.begin(); it != sendBuffers.end(); it++) {
+		delete *it;
+	}
+
+	sendBuffers.clear();
 }
 
 void EthernetCommunication::send(std::string message) {
@@ -25,87 +36,89 @@ void EthernetCommunication::send(std::string message) {
 		return;
 	}
 
-	if (!running) {
-		queuedMessages.push(message);
+	/*if (message.substr(0, 6) != "speeds" && message.substr(0, 6) != "charge" && message.substr(0, 3) != "adc") {
+		// incoming message
+		std::cout << "SEND: " << message << std::endl;
+	}*/
 
+	// messages added before the socket is running wait in the scheduler, drops are counted in the send stats
+	scheduler.add(message);
+}
+
+void EthernetCommunication::sendFrame(const unsigned char* data, int length) {
+	scheduler.addFrame(data, length);
+}
+
+void EthernetCommunication::flush() {
+	if (!running || flushPosted.exchange(true)) {
 		return;
 	}
 
-	while (!queuedMessages.empty()) {
-		std::cout << "! Socket queue size: " << queuedMessages.size() << std::endl;
+	ioService.post(boost::bind(&EthernetCommunication::sendPending, this));
+}
 
-		std::string queuedMessage = queuedMessages.front();
-		queuedMessages.pop();
+void EthernetCommunication::sendPending() {
+	boost::mutex::scoped_lock lock(closeMutex);
 
-		//if (queuedMessage.substr(0, 6) != "speeds" && queuedMessage.substr(0, 3) != "adc") {
-		//	std::cout << "SEND FROM QUEUE: " << queuedMessage << " [" << queuedMessages.size() << "]" << std::endl;
-		//}
+	flushPosted = false;
 
-		send(queuedMessage);
+	if (socket == NULL || !running) {
+		return;
 	}
 
-	/*if (message.substr(0, 6) != "speeds" && message.substr(0, 6) != "charge" && message.substr(0, 3) != "adc") {
-		// incoming message
-		std::cout << "SEND: " << message << std::endl;
-	}*/
+	if (freeSendBuffers.empty()) {
+		// the commands keep coalescing in the scheduler until a send completes
+		backPressureCount++;
 
-	message += "\n";
+		return;
+	}
 
-	memcpy(requestBuffer, message.c_str(), message.size());
-	requestBuffer[message.size()] = 0;
+	SendBuffer* buffer = freeSendBuffers.top();
+	int length = scheduler.flush(buffer->data, MAX_SIZE, binaryProtocol);
 
-	//boost::shared_ptr<std::string> requestBuffer(new std::string(message));
+	if (length == 0) {
+		return;
+	}
 
-	try {
-		/*boost::asio::ip::udp::endpoint remoteEndpoint = boost::asio::ip::udp::endpoint(
-			boost::asio::ip::address::from_string(host),
-			port
-		);*/
-
-		/*socket->async_send_to(
-			boost::asio::buffer(requestBuffer, message.length()),
-			remoteEndpoint,
-			//boost::asio::buffer(*requestBuffer), remoteEndpoint,
-			boost::bind(
-				&EthernetCommunication::onSend,
-				this,
-				boost::asio::placeholders::error,
-				boost::asio::placeholders::bytes_transferred
-			)
-		);*/
+	freeSendBuffers.pop();
+	int inFlight = ++sendsInFlight;
 
-		socket->send_to(
-			boost::asio::buffer(requestBuffer, message.length()),
-			remoteEndpoint
-		);
-	} catch (std::exception& e) {
-		std::cout << "- EthernetCommunication send error: " << e.what() << std::endl;
+	if (inFlight > maxSendsInFlight) {
+		maxSendsInFlight = inFlight;
 	}
-}
 
-bool EthernetCommunication::gotMessages() {
-	boost::mutex::scoped_lock lock(messagesMutex);
+	socket->async_send_to(
+		boost::asio::buffer(buffer->data, length),
+		remoteEndpoint,
+		boost::bind(
+			&EthernetCommunication::onSend,
+			this,
+			boost::asio::placeholders::error,
+			boost::asio::placeholders::bytes_transferred,
+			buffer
+		)
+	);
+}
 
-	return messages.size() > 0;
+void EthernetCommunication::scheduleFlush() {
+	flushTimer.expires_from_now(boost::posix_time::milliseconds(Config::communicationFlushInterval));
+	flushTimer.async_wait(
+		boost::bind(
+			&EthernetCommunication::onFlushTimer,
+			this,
+			boost::asio::placeholders::error
+		)
+	);
 }
 
-std::string EthernetCommunication::dequeueMessage() {
-	boost::mutex::scoped_lock lock(messagesMutex);
-	
-	if (messages.size() == 0) {
-		return "";
+void EthernetCommunication::onFlushTimer(const boost::system::error_code& error) {
+	if (error || !running) {
+		return;
 	}
 
-	std::string message = messages.front();
-
-	messages.pop();
-
-	/*if (message.substr(0, 7) != "<speeds" && message.substr(0, 4) != "<adc") {
-		// incoming message
-		std::cout << "RECV: " << message << std::endl;
-	}*/
-
-	return message;
+	// commands from threads that don't flush themselves still go out regularly
+	sendPending();
+	scheduleFlush();
 }
 
 void* EthernetCommunication::run() {
@@ -113,7 +126,7 @@ void* EthernetCommunication::run() {
 
 	running = true;
 
-	socket = new udp::socket(ioService, udp::endpoint(udp::v4(), port));
+	socket = new udp::socket(ioService, udp::endpoint(udp::v4(), localPort));
 
 	remoteEndpoint = boost::asio::ip::udp::endpoint(
 		boost::asio::ip::address::from_string(host),
@@ -123,6 +136,8 @@ void* EthernetCommunication::run() {
 	//receiveBuffer2 = boost::asio::buffer(receiveBuffer, MAX_SIZE);
 
 	receiveNext();
+	sendPending();
+	scheduleFlush();
 
 	ioService.run();
 
@@ -154,16 +169,28 @@ void EthernetCommunication::onReceive(const boost::system::error_code& error, si
 	}
 
 	if ((!error || error == boost::asio::error::message_size) && bytesReceived > 0) {
-		std::string msg = std::string(receiveBuffer, bytesReceived);
-		//std::string msg = std::string(receiveBuffer.data(), bytesReceived);
-
-		//if (msg.substr(0, 7) != "<speeds") {
-			// outgoing message
-		//	std::cout << "RECV: " << msg << ", bytesReceived: " << bytesReceived << std::endl;
-		//}
-
-		boost::mutex::scoped_lock lock(messagesMutex);
-		messages.push(msg);
+		if ((unsigned char)receiveBuffer[0] == BinaryProtocol::FRAME_START) {
+			// a datagram contains whole binary frames
+			BinaryProtocol::Frame frame;
+			char text[BinaryProtocol::MAX_TEXT_SIZE];
+
+			decoder.reset();
+
+			for (size_t i = 0; i < bytesReceived && i < MAX_SIZE; i++) {
+				if (decoder.push((unsigned char)receiveBuffer[i], frame)) {
+					receiveMessage(StringView(text, BinaryProtocol::toText(frame, text)), true);
+				}
+			}
+		} else {
+			StringView message(receiveBuffer, (int)std::min(bytesReceived, (size_t)MAX_SIZE));
+
+			//if (!message.startsWith("<speeds")) {
+				// outgoing message
+			//	std::cout << "RECV: " << message.toString() << ", bytesReceived: " << bytesReceived << std::endl;
+			//}
+
+			receiveMessage(message);
+		}
 	} else if (error.value() != 995) {
 		std::cout << "- Socket receive error: " << error << ", bytesReceived: " << bytesReceived << std::endl;
 	}
@@ -173,17 +200,51 @@ void EthernetCommunication::onReceive(const boost::system::error_code& error, si
 	}
 }
 
-void EthernetCommunication::onSend(const boost::system::error_code& error, size_t bytesSent) {
-	if (error) {
+void EthernetCommunication::onSend(const boost::system::error_code& error, size_t bytesSent, SendBuffer* buffer) {
+	freeSendBuffers.push(buffer);
+	sendsInFlight--;
+
+	if (error && error != boost::asio::error::operation_aborted) {
+		sendErrorCount++;
+
 		std::cout << "- Socket send error: " << error << ", bytesSent: " << bytesSent << std::endl;
 	}
 
-	if (running) {
-		receiveNext();
+	// commands held back while all the buffers were in use
+	if (running && scheduler.getPendingCount() > 0) {
+		sendPending();
 	}
 }
 
+AbstractCommunication::SendStats EthernetCommunication::getSendStats() const {
+	SendStats stats;
+
+	stats.pending = scheduler.getPendingCount();
+	stats.coalesced = scheduler.getCoalescedCount();
+	stats.dropped = scheduler.getDroppedCount();
+	stats.datagrams = scheduler.getDatagramCount();
+	stats.inFlight = sendsInFlight;
+	stats.maxInFlight = maxSendsInFlight;
+	stats.backPressure = backPressureCount;
+	stats.errors = sendErrorCount;
+
+	return stats;
+}
+
 void EthernetCommunication::close() {
+	boost::mutex::scoped_lock lock(closeMutex);
+
+	if (running && socket != NULL) {
+		// the final commands such as reset are sent synchronously before closing
+		int length = scheduler.flush(requestBuffer, MAX_SIZE, binaryProtocol);
+
+		if (length > 0) {
+			boost::system::error_code ec;
+
+			socket->send_to(boost::asio::buffer(requestBuffer, length), remoteEndpoint, 0, ec);
+		}
+	}
+
 	running = false;
 
 	if (socket != NULL) {
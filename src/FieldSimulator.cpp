@@ -0,0 +1,715 @@
+#include "FieldSimulator.h"
+#include "Robot.h"
+#include "TestController.h"
+#include "CameraTranslator.h"
+#include "Wheel.h"
+#include "Command.h"
+#include "Util.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+	// the simulated clock of every match starts from here so the timers that are compared to zero behave (seconds)
+	const double startTime = 100.0;
+
+	// the dribbler senses a ball this close to its front (meters)
+	const float ballSenseDistance = 0.01f;
+
+	const int ballType = 3;
+}
+
+FieldSimulator::FieldSimulator() :
+	width(Config::cameraWidth), height(Config::cameraHeight), time(0.0), frameNumber(0),
+	robot(NULL), controller(NULL), odometer(NULL),
+	frontCameraTranslator(NULL), rearCameraTranslator(NULL), frontVision(NULL), rearVision(NULL),
+	charging(false), firmwareBinary(false), matchStartTime(0.0), lastGoalTime(0.0),
+	matchCount(0), ballCount(0), goalCount(0), ownGoalCount(0), kickCount(0), simulatedDuration(0.0f), realDuration(0.0)
+{
+	visionResults.front = &frontResult;
+	visionResults.rear = &rearResult;
+}
+
+FieldSimulator::~FieldSimulator() {
+	if (controller != NULL) delete controller; controller = NULL;
+	if (robot != NULL) delete robot; robot = NULL;
+	if (odometer != NULL) delete odometer; odometer = NULL;
+	if (frontVision != NULL) delete frontVision; frontVision = NULL;
+	if (rearVision != NULL) delete rearVision; rearVision = NULL;
+	if (frontCameraTranslator != NULL) delete frontCameraTranslator; frontCameraTranslator = NULL;
+	if (rearCameraTranslator != NULL) delete rearCameraTranslator; rearCameraTranslator = NULL;
+}
+
+void FieldSimulator::setup() {
+	if (frontVision != NULL) {
+		return;
+	}
+
+	frontCameraTranslator = new CameraTranslator();
+	rearCameraTranslator = new CameraTranslator();
+
+	frontCameraTranslator->setConstants(
+		Config::frontCameraA, Config::frontCameraB, Config::frontCameraC,
+		Config::cameraDistortionK1, Config::cameraDistortionK2, Config::cameraDistortionK3,
+		Config::frontCameraHorizon, Config::cameraDistortionFocus,
+		width, height
+	);
+
+	rearCameraTranslator->setConstants(
+		Config::rearCameraA, Config::rearCameraB, Config::rearCameraC,
+		Config::cameraDistortionK1, Config::cameraDistortionK2, Config::cameraDistortionK3,
+		Config::rearCameraHorizon, Config::cameraDistortionFocus,
+		width, height
+	);
+
+	std::cout << "  > loading camera mappings.. ";
+	frontCameraTranslator->loadMappings(Config::distortMappingFilenameFrontX, Config::distortMappingFilenameFrontY);
+	rearCameraTranslator->loadMappings(Config::distortMappingFilenameRearX, Config::distortMappingFilenameRearY);
+	std::cout << "done!" << std::endl;
+
+	// only the distances are asked from the vision, it needs no blobber
+	frontVision = new Vision(NULL, frontCameraTranslator, Dir::FRONT, width, height);
+	rearVision = new Vision(NULL, rearCameraTranslator, Dir::REAR, width, height);
+
+	frontResult.vision = frontVision;
+	rearResult.vision = rearVision;
+
+	odometer = new Odometer(
+		Config::robotWheelAngle1,
+		Config::robotWheelAngle2,
+		Config::robotWheelAngle3,
+		Config::robotWheelAngle4,
+		Config::robotWheelOffset,
+		Config::robotWheelRadius
+	);
+}
+
+void FieldSimulator::simulate(int matchCount, int ballCount) {
+	setup();
+
+	this->matchCount = matchCount;
+	this->ballCount = ballCount;
+	goalCount = 0;
+	ownGoalCount = 0;
+	kickCount = 0;
+	simulatedDuration = 0.0f;
+	controllerDurations.clear();
+	robotDurations.clear();
+	scoreTimes.clear();
+	states.clear();
+	transitions.clear();
+
+	// the same balls for every run so the results can be compared
+	srand(Config::syntheticSeed);
+
+	std::cout << "! Simulating " << matchCount << " matches with " << ballCount << " balls" << std::endl;
+
+	__int64 startNanos = Util::nanotime();
+
+	for (int i = 0; i < matchCount; i++) {
+		int previousGoalCount = goalCount;
+		int previousOwnGoalCount = ownGoalCount;
+
+		runMatch(ballCount);
+
+		std::cout << "  > match " << (i + 1) << ": " << (goalCount - previousGoalCount) << " goals, " << (ownGoalCount - previousOwnGoalCount) << " own goals"
+			<< " in " << (time - matchStartTime) << " seconds" << std::endl;
+	}
+
+	Util::clearSimulatedTime();
+
+	realDuration = (double)(Util::nanotime() - startNanos) / 1000000000.0;
+
+	std::cout << "  > controller step: median " << controllerDurations.getPercentile(0.5) / 1000000.0 << "ms, p99 " << controllerDurations.getPercentile(0.99) / 1000000.0 << "ms, max " << controllerDurations.getMax() / 1000000.0 << "ms" << std::endl;
+	std::cout << "  > robot step: median " << robotDurations.getPercentile(0.5) / 1000000.0 << "ms, p99 " << robotDurations.getPercentile(0.99) / 1000000.0 << "ms, max " << robotDurations.getMax() / 1000000.0 << "ms" << std::endl;
+	std::cout << "  > scored " << goalCount << " of " << (matchCount * ballCount) << " balls, " << ownGoalCount << " own goals, " << kickCount << " kicks"
+		<< ", time to score: median " << scoreTimes.getPercentile(0.5) / 1000.0 << "s, p90 " << scoreTimes.getPercentile(0.9) / 1000.0 << "s" << std::endl;
+	std::cout << "  > simulated " << simulatedDuration << " seconds in " << realDuration << " seconds (" << (realDuration > 0.0 ? simulatedDuration / realDuration : 0.0) << "x real time)" << std::endl;
+
+	for (StateMap::const_iterator it = states.begin(); it != states.end(); it++) {
+		std::cout << "  > " << it->first << ": " << (simulatedDuration > 0.0f ? (int)(it->second.duration / simulatedDuration * 100.0f) : 0) << "% of the time, entered " << it->second.entries << " times" << std::endl;
+	}
+}
+
+void FieldSimulator::runMatch(int ballCount) {
+	time = startTime;
+	frameNumber = 0;
+
+	Util::setSimulatedTime(time);
+
+	// the robot and the controller of the previous match are gone with their listeners and messages
+	receiveListeners.clear();
+
+	while (gotMessages()) {
+		dequeueMessage();
+	}
+
+	binaryProtocol = false;
+	decoder.reset();
+	pendingSpeeds.clear();
+	speeds = Speeds();
+	movement = Odometer::Movement();
+	charging = false;
+	firmwareBinary = false;
+
+	robot = new Robot(this);
+	robot->setup();
+
+	controller = new TestController(robot, this);
+	controller->onEnter();
+
+	// the reset of the controller places the robot in its starting corner
+	position = robot->getPosition();
+	lastStateName = controller->getCurrentStateName();
+
+	balls.clear();
+
+	for (int i = 0; i < ballCount; i++) {
+		float x, y;
+
+		do {
+			x = Math::randomFloat(Config::ballRadius, Config::fieldWidth - Config::ballRadius);
+			y = Math::randomFloat(Config::ballRadius, Config::fieldHeight - Config::ballRadius);
+		} while (Math::distanceBetween(x, y, position.x, position.y) < Config::robotRadius * 2.0f);
+
+		balls.push_back(Ball(x, y));
+	}
+
+	matchStartTime = time;
+	lastGoalTime = time;
+
+	// same as pressing the go button
+	reply("toggle-go");
+
+	float frameDt = 1.0f / Config::simulatedFrameRate;
+	float motionPeriod = 1.0f / Config::motionControlFrequency;
+	double nextFrameTime = time;
+	double endTime = time + Config::simulatedMatchDuration;
+
+	while (time < endTime && !balls.empty()) {
+		if (time >= nextFrameTime) {
+			stepFrame(frameDt);
+
+			nextFrameTime += frameDt;
+		}
+
+		robot->stepMotion(motionPeriod);
+
+		stepPhysics(motionPeriod);
+
+		time += motionPeriod;
+
+		Util::setSimulatedTime(time);
+	}
+
+	simulatedDuration += (float)(time - matchStartTime);
+
+	delete controller;
+	controller = NULL;
+
+	delete robot;
+	robot = NULL;
+}
+
+void FieldSimulator::stepFrame(float dt) {
+	frameNumber++;
+
+	updateResult(frontResult, Dir::FRONT);
+	updateResult(rearResult, Dir::REAR);
+
+	while (gotMessages()) {
+		std::string message = dequeueMessage();
+
+		robot->handleCommunicationMessage(message);
+		controller->handleCommunicationMessage(message);
+	}
+
+	robot->receiveMotion();
+
+	Vision::Results* compensatedResults = robot->updateBallLocalizer(&visionResults);
+
+	__int64 start = Util::nanotime();
+
+	controller->step(dt, compensatedResults);
+
+	controllerDurations.add(Util::nanotime() - start);
+
+	start = Util::nanotime();
+
+	robot->step(dt, compensatedResults);
+
+	robotDurations.add(Util::nanotime() - start);
+
+	const std::string& stateName = controller->getCurrentStateName();
+
+	states[stateName].duration += dt;
+
+	// states are sampled after every step so the ones entered and left within a step are not seen
+	if (stateName != lastStateName) {
+		states[stateName].entries++;
+		transitions[lastStateName + " > " + stateName]++;
+
+		lastStateName = stateName;
+	}
+}
+
+void FieldSimulator::stepPhysics(float dt) {
+	// the wheels act on the speeds after the command latency
+	while (!pendingSpeeds.empty() && pendingSpeeds.front().time <= time) {
+		speeds = pendingSpeeds.front();
+
+		pendingSpeeds.pop_front();
+	}
+
+	movement = odometer->calculateMovement(
+		Wheel::speedToOmega((float)speeds.values[Config::wheelFLId]),
+		Wheel::speedToOmega((float)speeds.values[Config::wheelFRId]),
+		Wheel::speedToOmega((float)speeds.values[Config::wheelRLId]),
+		Wheel::speedToOmega((float)speeds.values[Config::wheelRRId])
+	);
+
+	// same integration order as the odometry accumulator, rotate first
+	position.orientation = Math::floatModulus(position.orientation + movement.omega * dt, Math::TWO_PI);
+	position.x += (movement.velocityX * Math::cos(position.orientation) - movement.velocityY * Math::sin(position.orientation)) * dt;
+	position.y += (movement.velocityX * Math::sin(position.orientation) + movement.velocityY * Math::cos(position.orientation)) * dt;
+
+	// the robot can drive on the border but not past it
+	float margin = Config::fieldBorderWidth - Config::robotRadius;
+
+	position.x = Math::limit(position.x, -margin, Config::fieldWidth + margin);
+	position.y = Math::limit(position.y, -margin, Config::fieldHeight + margin);
+
+	for (BallList::iterator it = balls.begin(); it != balls.end();) {
+		Ball& ball = *it;
+
+		stepBall(ball, dt);
+
+		bool inGoal = Math::abs(ball.y - Config::fieldHeight / 2.0f) < Config::goalWidth / 2.0f;
+
+		if (inGoal && (ball.x < 0.0f || ball.x > Config::fieldWidth)) {
+			Side side = ball.x > Config::fieldWidth ? Side::BLUE : Side::YELLOW;
+
+			if (side == controller->getTargetSide()) {
+				goalCount++;
+
+				scoreTimes.add((__int64)((time - lastGoalTime) * 1000.0));
+
+				lastGoalTime = time;
+			} else {
+				ownGoalCount++;
+			}
+
+			it = balls.erase(it);
+
+			continue;
+		}
+
+		// balls leaving the field elsewhere are put back on the line
+		if (ball.x < 0.0f || ball.x > Config::fieldWidth) {
+			ball.x = Math::limit(ball.x, 0.0f, Config::fieldWidth);
+			ball.velocityX = 0.0f;
+		}
+
+		if (ball.y < 0.0f || ball.y > Config::fieldHeight) {
+			ball.y = Math::limit(ball.y, 0.0f, Config::fieldHeight);
+			ball.velocityY = 0.0f;
+		}
+
+		it++;
+	}
+
+	reply(getDribblerBall() != -1 ? "ball:1" : "ball:0");
+}
+
+void FieldSimulator::stepBall(Ball& ball, float dt) {
+	float dribblerDistance = Config::robotRadius + Config::ballRadius;
+	float forwardX = Math::cos(position.orientation);
+	float forwardY = Math::sin(position.orientation);
+	float robotVelocityX = movement.velocityX * forwardX - movement.velocityY * forwardY;
+	float robotVelocityY = movement.velocityX * forwardY + movement.velocityY * forwardX;
+	bool dribblerRunning = speeds.values[Config::dribblerId] != 0;
+
+	if (ball.held && !dribblerRunning) {
+		ball.held = false;
+	}
+
+	if (!ball.held) {
+		// same drag as the ball localizer applies
+		float xSign = ball.velocityX > 0 ? 1.0f : -1.0f;
+		float ySign = ball.velocityY > 0 ? 1.0f : -1.0f;
+		float stepDrag = Config::rollingDrag * dt;
+
+		ball.velocityX = Math::abs(ball.velocityX) > stepDrag ? ball.velocityX - stepDrag * xSign : 0.0f;
+		ball.velocityY = Math::abs(ball.velocityY) > stepDrag ? ball.velocityY - stepDrag * ySign : 0.0f;
+
+		ball.x += ball.velocityX * dt;
+		ball.y += ball.velocityY * dt;
+
+		float dx = ball.x - position.x;
+		float dy = ball.y - position.y;
+		float distance = Math::sqrt(dx * dx + dy * dy);
+
+		if (distance >= dribblerDistance || distance == 0.0f) {
+			return;
+		}
+
+		float forward = dx * forwardX + dy * forwardY;
+		float right = -dx * forwardY + dy * forwardX;
+
+		// the body of the robot pushes the ball away, the running dribbler catches it
+		if (forward <= 0.0f || Math::abs(right) >= Config::simulatedDribblerWidth / 2.0f || !dribblerRunning) {
+			float normalX = dx / distance;
+			float normalY = dy / distance;
+			float ballNormalVelocity = ball.velocityX * normalX + ball.velocityY * normalY;
+			float robotNormalVelocity = robotVelocityX * normalX + robotVelocityY * normalY;
+
+			ball.x = position.x + normalX * dribblerDistance;
+			ball.y = position.y + normalY * dribblerDistance;
+
+			if (ballNormalVelocity < robotNormalVelocity) {
+				ball.velocityX += (robotNormalVelocity - ballNormalVelocity) * normalX;
+				ball.velocityY += (robotNormalVelocity - ballNormalVelocity) * normalY;
+			}
+
+			return;
+		}
+
+		ball.held = true;
+	}
+
+	// a held ball moves with the front of the robot
+	ball.x = position.x + forwardX * dribblerDistance;
+	ball.y = position.y + forwardY * dribblerDistance;
+	ball.velocityX = robotVelocityX - movement.omega * dribblerDistance * forwardY;
+	ball.velocityY = robotVelocityY + movement.omega * dribblerDistance * forwardX;
+}
+
+void FieldSimulator::kick(int microseconds) {
+	int index = getDribblerBall();
+
+	if (index == -1 || microseconds <= 0) {
+		return;
+	}
+
+	Ball& ball = balls[index];
+	float speed = (float)microseconds * Config::simulatedKickSpeed;
+
+	ball.held = false;
+	ball.velocityX += Math::cos(position.orientation) * speed;
+	ball.velocityY += Math::sin(position.orientation) * speed;
+
+	kickCount++;
+}
+
+int FieldSimulator::getDribblerBall() {
+	float forwardX = Math::cos(position.orientation);
+	float forwardY = Math::sin(position.orientation);
+
+	for (unsigned int i = 0; i < balls.size(); i++) {
+		if (balls[i].held) {
+			return i;
+		}
+
+		float dx = balls[i].x - position.x;
+		float dy = balls[i].y - position.y;
+		float forward = dx * forwardX + dy * forwardY;
+		float right = -dx * forwardY + dy * forwardX;
+
+		if (
+			forward > 0.0f
+			&& Math::abs(right) < Config::simulatedDribblerWidth / 2.0f
+			&& Math::sqrt(dx * dx + dy * dy) < Config::robotRadius + Config::ballRadius + ballSenseDistance
+		) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void FieldSimulator::updateResult(Vision::Result& result, Dir dir) {
+	CameraTranslator* translator = dir == Dir::FRONT ? frontCameraTranslator : rearCameraTranslator;
+	float forward, right, cameraX, cameraY;
+
+	result.reset(time, frameNumber);
+
+	for (unsigned int i = 0; i < balls.size(); i++) {
+		FrameGenerator::getCameraCoordinates(position, dir, balls[i].x, balls[i].y, forward, right);
+
+		if (!FrameGenerator::project(translator, width, forward, right, Config::ballRadius, cameraX, cameraY)) {
+			continue;
+		}
+
+		float radius = Config::ballRadius * translator->A / (forward - translator->B) / translator->C;
+		Object* ball = createObject(result, dir, cameraX - radius, cameraY - radius, cameraX + radius, cameraY + radius, ballType, true);
+
+		if (ball != NULL) {
+			result.balls.push_back(ball);
+		}
+	}
+
+	for (int side = 0; side < 2; side++) {
+		float goalX = side == Side::BLUE ? Config::fieldWidth : 0.0f;
+		float x1 = (float)width, y1 = (float)height, x2 = -1.0f, y2 = -1.0f;
+
+		FrameGenerator::projectGoalEdges(position, dir, translator, width, goalX, goalEdges);
+
+		for (unsigned int i = 0; i < goalEdges.size(); i++) {
+			const FrameGenerator::GoalEdge& edge = goalEdges[i];
+
+			if (!edge.visible) {
+				continue;
+			}
+
+			x1 = Math::min(x1, Math::min(edge.topX, edge.bottomX));
+			x2 = Math::max(x2, Math::max(edge.topX, edge.bottomX));
+			y1 = Math::min(y1, edge.topY);
+			y2 = Math::max(y2, edge.bottomY);
+		}
+
+		Object* goal = createObject(result, dir, x1, y1, x2, y2, side, false);
+
+		if (goal != NULL) {
+			result.goals.push_back(goal);
+		}
+	}
+
+	result.whiteDistance = getColorDistance(result, dir, FrameGenerator::WHITE_SURFACE);
+	result.blackDistance = getColorDistance(result, dir, FrameGenerator::BLACK_SURFACE);
+}
+
+Object* FieldSimulator::createObject(Vision::Result& result, Dir dir, float x1, float y1, float x2, float y2, int type, bool round) {
+	CameraTranslator* translator = dir == Dir::FRONT ? frontCameraTranslator : rearCameraTranslator;
+
+	// an object partly out of the frame is seen as the blob of its visible part
+	x1 = Math::max(x1, 0.0f);
+	y1 = Math::max(y1, 0.0f);
+	x2 = Math::min(x2, (float)(width - 1));
+	y2 = Math::min(y2, (float)(height - 1));
+
+	if (x1 >= x2 || y1 >= y2) {
+		return NULL;
+	}
+
+	// the blob is the box around the distorted corners and edge centers
+	float xs[3] = { x1, (x1 + x2) / 2.0f, x2 };
+	float ys[3] = { y1, (y1 + y2) / 2.0f, y2 };
+	int blobX1 = width, blobY1 = height, blobX2 = 0, blobY2 = 0;
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			CameraTranslator::CameraPosition distorted = translator->distort((int)xs[i], (int)ys[j]);
+
+			blobX1 = std::min(blobX1, distorted.x);
+			blobY1 = std::min(blobY1, distorted.y);
+			blobX2 = std::max(blobX2, distorted.x);
+			blobY2 = std::max(blobY2, distorted.y);
+		}
+	}
+
+	int blobWidth = blobX2 - blobX1;
+	int blobHeight = blobY2 - blobY1;
+	int area = round ? (int)(blobWidth * blobHeight * Math::PI / 4.0f) : blobWidth * blobHeight;
+
+	if (area < (type == ballType ? Config::ballBlobMinArea : Config::goalBlobMinArea)) {
+		return NULL;
+	}
+
+	// measured from the bottom center like the vision does
+	Vision::Distance distance = result.vision->getDistance(blobX1 + blobWidth / 2, blobY2);
+
+	if (dir == Dir::REAR) {
+		if (distance.angle > 0.0f) {
+			distance.angle -= Math::PI;
+		} else {
+			distance.angle += Math::PI;
+		}
+	}
+
+	return result.objects.create(Object(
+		blobX1 + blobWidth / 2,
+		blobY1 + blobHeight / 2,
+		blobWidth,
+		blobHeight,
+		area,
+		distance.straight,
+		distance.x,
+		distance.y,
+		distance.angle,
+		type,
+		dir == Dir::FRONT ? false : true
+	));
+}
+
+Vision::ColorDistance FieldSimulator::getColorDistance(Vision::Result& result, Dir dir, FrameGenerator::Surface surface) {
+	// the same samples as the vision takes
+	return Vision::ColorDistance(
+		getColorDistance(result, dir, surface, 0, 0),
+		getColorDistance(result, dir, surface, width / 4, 0),
+		getColorDistance(result, dir, surface, width / 2, 0),
+		getColorDistance(result, dir, surface, width / 2 + width / 4, 0),
+		getColorDistance(result, dir, surface, width, 0)
+	);
+}
+
+float FieldSimulator::getColorDistance(Vision::Result& result, Dir dir, FrameGenerator::Surface surface, int x2, int y2) {
+	CameraTranslator* translator = dir == Dir::FRONT ? frontCameraTranslator : rearCameraTranslator;
+	float orientation = position.orientation + (dir == Dir::REAR ? Math::PI : 0.0f);
+	float forwardX = Math::cos(orientation);
+	float forwardY = Math::sin(orientation);
+	int x1 = width / 2;
+	int y1 = Config::colorDistanceStartY;
+	int steps = std::max(std::abs(x2 - x1), std::abs(y2 - y1));
+
+	// every third pixel along the line from the bottom center, until past the horizon
+	for (int i = 0; i <= steps; i += 3) {
+		int x = std::min(x1 + (x2 - x1) * i / steps, width - 1);
+		int y = y1 + (y2 - y1) * i / steps;
+		CameraTranslator::WorldPosition pos = translator->getWorldPosition(x, y);
+
+		if (!pos.isValid) {
+			break;
+		}
+
+		float fieldX = position.x + pos.dy * forwardX - pos.dx * forwardY;
+		float fieldY = position.y + pos.dy * forwardY + pos.dx * forwardX;
+
+		if (FrameGenerator::getGroundSurface(fieldX, fieldY) == surface) {
+			return pos.distance;
+		}
+	}
+
+	return -1.0f;
+}
+
+void FieldSimulator::send(std::string message) {
+	handleCommand("<" + message + ">");
+}
+
+void FieldSimulator::sendFrame(const unsigned char* data, int length) {
+	BinaryProtocol::Frame frame;
+
+	for (int i = 0; i < length; i++) {
+		if (decoder.push(data[i], frame)) {
+			handleCommand(BinaryProtocol::toText(frame));
+		}
+	}
+}
+
+void FieldSimulator::handleCommand(const std::string& message) {
+	Command cmd = Command::parse(message);
+
+	if (cmd.name == "speeds" && cmd.parameters.size() >= 5) {
+		Speeds commanded;
+
+		commanded.time = time + Config::robotCommandLatency;
+
+		for (int i = 0; i < 5; i++) {
+			commanded.values[i] = Util::toInt(cmd.parameters[i]);
+		}
+
+		pendingSpeeds.push_back(commanded);
+
+		// the firmware reports the speeds the wheels are turning at, as a binary frame once that was negotiated
+		reply(
+			"speeds:" + Util::toString(speeds.values[0]) + ":" + Util::toString(speeds.values[1]) + ":" + Util::toString(speeds.values[2])
+			+ ":" + Util::toString(speeds.values[3]) + ":" + Util::toString(speeds.values[4]),
+			firmwareBinary
+		);
+	} else if (cmd.name == "protocol" && cmd.parameters.size() == 1) {
+		firmwareBinary = cmd.parameters[0] == "binary";
+
+		reply(firmwareBinary ? "protocol:binary" : "protocol:text");
+	} else if (cmd.name == "reset") {
+		firmwareBinary = false;
+		speeds = Speeds();
+		pendingSpeeds.clear();
+	} else if (cmd.name == "charge") {
+		charging = true;
+	} else if (cmd.name == "discharge") {
+		charging = false;
+	} else if (cmd.name == "adc") {
+		reply(charging ? "adc:300" : "adc:0");
+	} else if (cmd.name == "kick" && cmd.parameters.size() >= 1) {
+		kick(Util::toInt(cmd.parameters[0]));
+	} else if (cmd.name == "dkick" && cmd.parameters.size() >= 4) {
+		// the ball flying over a chip kick is not simulated, both kick it along the ground
+		int mainDuration = Util::toInt(cmd.parameters[0]);
+
+		kick(mainDuration > 0 ? mainDuration : Util::toInt(cmd.parameters[2]));
+	}
+}
+
+// binary frames are received in their text form
+void FieldSimulator::reply(const std::string& message, bool binary) {
+	std::string text = "<" + message + ">";
+
+	receiveMessage(StringView(text), binary);
+}
+
+bool FieldSimulator::save(const std::string& filename) {
+	if (filename.empty()) {
+		std::cout << getJSON() << std::endl;
+
+		return true;
+	}
+
+	std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+
+	if (!file.is_open()) {
+		std::cout << "- Opening simulation result file '" << filename << "' failed" << std::endl;
+
+		return false;
+	}
+
+	file << getJSON() << std::endl;
+
+	std::cout << "! Wrote simulation results to " << filename << std::endl;
+
+	return true;
+}
+
+std::string FieldSimulator::getJSON() {
+	std::stringstream stream;
+
+	stream << "{";
+	stream << "\"matches\":" << matchCount << ",";
+	stream << "\"balls\":" << ballCount << ",";
+	stream << "\"goals\":" << goalCount << ",";
+	stream << "\"ownGoals\":" << ownGoalCount << ",";
+	stream << "\"kicks\":" << kickCount << ",";
+	stream << "\"simulatedDuration\":" << simulatedDuration << ",";
+	stream << "\"realDuration\":" << realDuration << ",";
+	stream << "\"controllerStep\":" << controllerDurations.toJSON(1000000.0) << ",";
+	stream << "\"robotStep\":" << robotDurations.toJSON(1000000.0) << ",";
+	stream << "\"timeToScore\":" << scoreTimes.toJSON(1000.0) << ",";
+
+	stream << "\"states\":{";
+
+	for (StateMap::const_iterator it = states.begin(); it != states.end(); it++) {
+		if (it != states.begin()) {
+			stream << ",";
+		}
+
+		stream << "\"" << it->first << "\":{\"entries\":" << it->second.entries << ",\"duration\":" << it->second.duration << "}";
+	}
+
+	stream << "},";
+
+	stream << "\"transitions\":{";
+
+	for (TransitionMap::const_iterator it = transitions.begin(); it != transitions.end(); it++) {
+		if (it != transitions.begin()) {
+			stream << ",";
+		}
+
+		stream << "\"" << it->first << "\":" << it->second;
+	}
+
+	stream << "}";
+	stream << "}";
+
+	return stream.str();
+}
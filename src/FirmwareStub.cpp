@@ -0,0 +1,343 @@
+#include "FirmwareStub.h"
+#include "Command.h"
+#include "Util.h"
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <boost/bind.hpp>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <termios.h>
+	#include <unistd.h>
+#endif
+
+using boost::asio::ip::udp;
+
+FirmwareStub::FirmwareStub(int port) :
+	port(port), baud(0), delay(0), loss(0.0f), running(false), binaryProtocol(false), charging(false),
+	receivedCount(0), repliedCount(0), lostCount(0), socket(NULL), serialPort(NULL)
+#ifndef _WIN32
+	, pty(NULL)
+#endif
+{
+	for (int i = 0; i < 5; i++) {
+		speeds[i] = 0;
+	}
+}
+
+FirmwareStub::FirmwareStub(const std::string& device, int baud) :
+	port(-1), device(device), deviceName(device), baud(baud), delay(0), loss(0.0f), running(false), binaryProtocol(false), charging(false),
+	receivedCount(0), repliedCount(0), lostCount(0), socket(NULL), serialPort(NULL)
+#ifndef _WIN32
+	, pty(NULL)
+#endif
+{
+	for (int i = 0; i < 5; i++) {
+		speeds[i] = 0;
+	}
+}
+
+FirmwareStub::~FirmwareStub() {
+	close();
+	join();
+
+	if (socket != NULL) delete socket; socket = NULL;
+	if (serialPort != NULL) delete serialPort; serialPort = NULL;
+#ifndef _WIN32
+	if (pty != NULL) delete pty; pty = NULL;
+#endif
+}
+
+bool FirmwareStub::open() {
+	if (socket != NULL || serialPort != NULL) {
+		return true;
+	}
+
+#ifndef _WIN32
+	if (pty != NULL) {
+		return true;
+	}
+#endif
+
+	try {
+		if (port != -1) {
+			std::cout << "! Starting firmware stub on 127.0.0.1:" << port << std::endl;
+
+			socket = new udp::socket(ioService, udp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), port));
+		} else if (device == "pty") {
+#ifndef _WIN32
+			int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+			if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0 || ptsname(master) == NULL) {
+				std::cout << "- Creating firmware stub pseudo terminal failed" << std::endl;
+
+				if (master != -1) {
+					::close(master);
+				}
+
+				return false;
+			}
+
+			// no echo or line editing, the stream carries binary frames
+			termios settings;
+
+			tcgetattr(master, &settings);
+			cfmakeraw(&settings);
+			tcsetattr(master, TCSANOW, &settings);
+
+			deviceName = ptsname(master);
+			pty = new boost::asio::posix::stream_descriptor(ioService, master);
+
+			std::cout << "! Starting firmware stub on pseudo terminal " << deviceName << std::endl;
+#else
+			std::cout << "- Pseudo terminals are not available, use a virtual null-modem port pair instead" << std::endl;
+
+			return false;
+#endif
+		} else {
+			std::cout << "! Starting firmware stub on " << device << " @ " << baud << std::endl;
+
+			serialPort = new boost::asio::serial_port(ioService, device);
+			serialPort->set_option(boost::asio::serial_port_base::baud_rate(baud));
+		}
+	} catch (std::exception& e) {
+		std::cout << "- Starting firmware stub failed: " << e.what() << std::endl;
+
+		return false;
+	}
+
+	if (delay > 0 || loss > 0.0f) {
+		std::cout << "  > replies delayed by " << delay << "ms, " << (int)(loss * 100.0f) << "% lost" << std::endl;
+	}
+
+	return true;
+}
+
+void FirmwareStub::close() {
+	running = false;
+
+	ioService.stop();
+}
+
+void* FirmwareStub::run() {
+	if (!open()) {
+		return NULL;
+	}
+
+	running = true;
+
+	receiveNext();
+
+	ioService.run();
+
+	return NULL;
+}
+
+void FirmwareStub::receiveNext() {
+	if (socket != NULL) {
+		socket->async_receive_from(
+			boost::asio::buffer(receiveBuffer, MAX_SIZE), senderEndpoint,
+			boost::bind(&FirmwareStub::onReceive, this, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)
+		);
+	} else if (serialPort != NULL) {
+		serialPort->async_read_some(
+			boost::asio::buffer(receiveBuffer, MAX_SIZE),
+			boost::bind(&FirmwareStub::onReceive, this, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)
+		);
+	}
+#ifndef _WIN32
+	else if (pty != NULL) {
+		pty->async_read_some(
+			boost::asio::buffer(receiveBuffer, MAX_SIZE),
+			boost::bind(&FirmwareStub::onReceive, this, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)
+		);
+	}
+#endif
+}
+
+void FirmwareStub::onReceive(const boost::system::error_code& error, size_t bytesReceived) {
+	if (!running) {
+		return;
+	}
+
+	if (error) {
+#ifndef _WIN32
+		// reading the pseudo terminal fails with EIO while its other side is not open, that is just idle
+		if (pty != NULL && error == boost::system::errc::io_error) {
+			Util::sleep(10);
+			receiveNext();
+
+			return;
+		}
+#endif
+
+		std::cout << "- Firmware stub receive error: " << error << std::endl;
+
+		if (socket == NULL) {
+			Util::sleep(10);
+		}
+	} else if (socket != NULL) {
+		handleDatagram(receiveBuffer, (int)bytesReceived);
+	} else {
+		handleStream(receiveBuffer, (int)bytesReceived);
+	}
+
+	receiveNext();
+}
+
+void FirmwareStub::handleDatagram(const unsigned char* data, int length) {
+	if (length > 0 && data[0] == BinaryProtocol::FRAME_START) {
+		BinaryProtocol::Frame frame;
+
+		decoder.reset();
+
+		for (int i = 0; i < length; i++) {
+			if (decoder.push(data[i], frame)) {
+				handleCommand(BinaryProtocol::toText(frame));
+			}
+		}
+
+		return;
+	}
+
+	// text messages are newline terminated
+	std::string datagram((const char*)data, length);
+	size_t start = 0;
+	size_t end;
+
+	while (start < datagram.size()) {
+		end = datagram.find('\n', start);
+
+		if (end == std::string::npos) {
+			end = datagram.size();
+		}
+
+		if (end > start) {
+			handleCommand("<" + datagram.substr(start, end - start) + ">");
+		}
+
+		start = end + 1;
+	}
+}
+
+void FirmwareStub::handleStream(const unsigned char* data, int length) {
+	BinaryProtocol::Frame frame;
+
+	// serial messages are newline terminated text lines and binary frames
+	for (int i = 0; i < length; i++) {
+		if (decoder.isReceiving() || (line.empty() && data[i] == BinaryProtocol::FRAME_START)) {
+			if (decoder.push(data[i], frame)) {
+				handleCommand(BinaryProtocol::toText(frame));
+			}
+		} else if (data[i] == '\n' || data[i] == '\r') {
+			if (!line.empty()) {
+				handleCommand(line[0] == '<' ? line : "<" + line + ">");
+				line.clear();
+			}
+		} else if (line.size() < MAX_SIZE) {
+			line += (char)data[i];
+		} else {
+			line.clear();
+		}
+	}
+}
+
+void FirmwareStub::handleCommand(const std::string& message) {
+	receivedCount++;
+
+	Command cmd = Command::parse(message);
+
+	if (cmd.name == "speeds" && cmd.parameters.size() >= 5) {
+		for (int i = 0; i < 5; i++) {
+			speeds[i] = Util::toInt(cmd.parameters[i]);
+		}
+
+		replySpeeds();
+	} else if (cmd.name == "protocol" && cmd.parameters.size() == 1) {
+		binaryProtocol = cmd.parameters[0] == "binary";
+
+		reply(binaryProtocol ? "protocol:binary" : "protocol:text");
+	} else if (cmd.name == "reset") {
+		binaryProtocol = false;
+
+		for (int i = 0; i < 5; i++) {
+			speeds[i] = 0;
+		}
+	} else if (cmd.name == "charge") {
+		charging = true;
+	} else if (cmd.name == "discharge") {
+		charging = false;
+	} else if (cmd.name == "adc") {
+		reply(charging ? "adc:300" : "adc:0");
+	} else if (cmd.name == "kick" || cmd.name == "dkick") {
+		reply("kicked");
+	}
+}
+
+void FirmwareStub::reply(const std::string& message) {
+	// a datagram is a single message, on a serial stream messages are separated by line feeds
+	std::string text = socket != NULL ? "<" + message + ">" : "<" + message + ">\n";
+
+	reply((const unsigned char*)text.c_str(), (int)text.size());
+}
+
+void FirmwareStub::replySpeeds() {
+	if (!binaryProtocol) {
+		reply("speeds:" + Util::toString(speeds[0]) + ":" + Util::toString(speeds[1]) + ":" + Util::toString(speeds[2]) + ":" + Util::toString(speeds[3]) + ":" + Util::toString(speeds[4]));
+
+		return;
+	}
+
+	unsigned char frame[BinaryProtocol::MAX_FRAME_SIZE];
+	int length = BinaryProtocol::encodeSpeeds(frame, speeds[0], speeds[1], speeds[2], speeds[3], speeds[4]);
+
+	reply(frame, length);
+}
+
+void FirmwareStub::reply(const unsigned char* data, int length) {
+	if (loss > 0.0f && (float)rand() / RAND_MAX < loss) {
+		lostCount++;
+
+		return;
+	}
+
+	boost::shared_ptr<std::string> copy(new std::string((const char*)data, length));
+
+	if (delay <= 0) {
+		transmit(copy, senderEndpoint);
+
+		return;
+	}
+
+	// every reply gets its own timer so replies keep their order and don't wait for each other
+	boost::shared_ptr<boost::asio::deadline_timer> timer(new boost::asio::deadline_timer(ioService, boost::posix_time::milliseconds(delay)));
+
+	timer->async_wait(boost::bind(&FirmwareStub::onDelayed, this, boost::asio::placeholders::error, timer, copy, senderEndpoint));
+}
+
+void FirmwareStub::onDelayed(const boost::system::error_code& error, boost::shared_ptr<boost::asio::deadline_timer> timer, boost::shared_ptr<std::string> data, udp::endpoint endpoint) {
+	if (!error && running) {
+		transmit(data, endpoint);
+	}
+}
+
+void FirmwareStub::transmit(boost::shared_ptr<std::string> data, udp::endpoint endpoint) {
+	boost::system::error_code error;
+
+	if (socket != NULL) {
+		socket->send_to(boost::asio::buffer(*data), endpoint, 0, error);
+	} else if (serialPort != NULL) {
+		boost::asio::write(*serialPort, boost::asio::buffer(*data), error);
+	}
+#ifndef _WIN32
+	else if (pty != NULL) {
+		boost::asio::write(*pty, boost::asio::buffer(*data), error);
+	}
+#endif
+
+	if (!error) {
+		repliedCount++;
+	}
+}
@@ -0,0 +1,98 @@
+#include "FrameBufferPool.h"
+#include "Platform.h"
+#include "Config.h"
+
+#include <iostream>
+
+namespace {
+	const char* formatNames[FrameBufferPool::FORMAT_COUNT] = {
+		"bayer", "y", "chroma", "yuyv", "rgb", "argb"
+	};
+}
+
+FrameBufferPool::BufferList FrameBufferPool::buffers;
+boost::mutex FrameBufferPool::mutex;
+
+size_t FrameBufferPool::getSize(Format format, int width, int height) {
+	size_t size;
+
+	switch (format) {
+		case BAYER_FORMAT:
+		case Y_PLANE:
+			size = (size_t)width * height;
+		break;
+
+		case CHROMA_PLANE:
+			size = (size_t)((width + 1) / 2) * ((height + 1) / 2);
+		break;
+
+		case YUYV_FORMAT:
+			size = (size_t)width * height * 2;
+		break;
+
+		case RGB_FORMAT:
+			size = (size_t)width * height * 3;
+		break;
+
+		case ARGB_FORMAT:
+			size = (size_t)width * height * 4;
+		break;
+
+		default:
+			size = 0;
+		break;
+	}
+
+	return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+const char* FrameBufferPool::getFormatName(Format format) {
+	return format >= 0 && format < FORMAT_COUNT ? formatNames[format] : "unknown";
+}
+
+unsigned char* FrameBufferPool::acquire(Format format, int width, int height) {
+	size_t size = getSize(format, width, height);
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (BufferList::iterator it = buffers.begin(); it != buffers.end(); it++) {
+		if (!it->acquired && it->size == size) {
+			it->acquired = true;
+
+			return it->data;
+		}
+	}
+
+	Buffer buffer;
+
+	buffer.data = (unsigned char*)Platform::allocateAligned(size, ALIGNMENT, Config::frameBufferHugePages);
+	buffer.size = size;
+	buffer.acquired = true;
+
+	if (buffer.data == NULL) {
+		std::cout << "- Allocating " << width << "x" << height << " " << getFormatName(format) << " frame buffer failed" << std::endl;
+
+		return NULL;
+	}
+
+	buffers.push_back(buffer);
+
+	return buffer.data;
+}
+
+void FrameBufferPool::release(unsigned char* data) {
+	if (data == NULL) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (BufferList::iterator it = buffers.begin(); it != buffers.end(); it++) {
+		if (it->data == data) {
+			it->acquired = false;
+
+			return;
+		}
+	}
+
+	std::cout << "- Released frame buffer does not belong to the pool" << std::endl;
+}
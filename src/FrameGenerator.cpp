@@ -0,0 +1,471 @@
+#include "FrameGenerator.h"
+#include "CameraTranslator.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace {
+	// objects closer to the camera plane than this are not rendered (meters)
+	const float minDepth = 0.01f;
+
+	// goals are rendered as vertical strips of this width (meters)
+	const float goalStripWidth = 0.05f;
+}
+
+FrameGenerator::FrameGenerator(Blobber* blobber, CameraTranslator* frontCameraTranslator, CameraTranslator* rearCameraTranslator, int width, int height) :
+	width(width), height(height),
+	noise(Config::syntheticNoise), blur(Config::syntheticBlur),
+	frontCameraTranslator(frontCameraTranslator), rearCameraTranslator(rearCameraTranslator)
+{
+	surfaces = new unsigned char[width * height];
+	dataRGB = new unsigned char[width * height * 3];
+	dataBlur = new unsigned char[width * height * 3];
+	dataBayer = new unsigned char[width * height];
+
+	pickColors(blobber);
+}
+
+FrameGenerator::~FrameGenerator() {
+	if (surfaces != NULL) delete[] surfaces; surfaces = NULL;
+	if (dataRGB != NULL) delete[] dataRGB; dataRGB = NULL;
+	if (dataBlur != NULL) delete[] dataBlur; dataBlur = NULL;
+	if (dataBayer != NULL) delete[] dataBayer; dataBayer = NULL;
+}
+
+unsigned char* FrameGenerator::render(Dir dir) {
+	CameraTranslator* translator = dir == Dir::FRONT ? frontCameraTranslator : rearCameraTranslator;
+
+	drawGround(dir, translator);
+
+	shapes.clear();
+
+	addShapes(dir, translator);
+
+	// the farthest first so the closer ones cover them
+	std::sort(shapes.begin(), shapes.end());
+
+	for (unsigned int i = 0; i < shapes.size(); i++) {
+		drawShape(shapes[i]);
+	}
+
+	applyDistortion(translator);
+
+	if (blur > 0) {
+		applyBlur();
+	}
+
+	applyMosaic();
+
+	return dataBayer;
+}
+
+FrameGenerator::VisibleBallList FrameGenerator::getVisibleBalls(Dir dir) {
+	CameraTranslator* translator = dir == Dir::FRONT ? frontCameraTranslator : rearCameraTranslator;
+	VisibleBallList visibleBalls;
+	float forward, right, cameraX, cameraY;
+
+	for (unsigned int i = 0; i < scene.balls.size(); i++) {
+		getCameraCoordinates(scene.robot, dir, scene.balls[i].x, scene.balls[i].y, forward, right);
+
+		if (
+			!project(translator, width, forward, right, 0.0f, cameraX, cameraY)
+			|| cameraX < 0.0f || cameraX >= (float)width
+			|| cameraY < 0.0f || cameraY >= (float)height
+		) {
+			continue;
+		}
+
+		float angle = atan2(right, forward);
+
+		// same as the rear camera angles of vision
+		if (dir == Dir::REAR) {
+			angle += angle > 0.0f ? -Math::PI : Math::PI;
+		}
+
+		visibleBalls.push_back(VisibleBall(Math::sqrt(forward * forward + right * right), angle));
+	}
+
+	return visibleBalls;
+}
+
+FrameGenerator::Scene FrameGenerator::getRandomScene(int ballCount, int robotCount) {
+	Scene scene;
+	float margin = Config::robotRadius * 2.0f;
+	int attempts = 100;
+
+	scene.robot = Math::Position(
+		Math::randomFloat(margin, Config::fieldWidth - margin),
+		Math::randomFloat(margin, Config::fieldHeight - margin),
+		Math::randomFloat(0.0f, Math::TWO_PI)
+	);
+
+	for (int i = 0; i < robotCount; i++) {
+		for (int attempt = 0; attempt < attempts; attempt++) {
+			Math::Point robot(
+				Math::randomFloat(margin, Config::fieldWidth - margin),
+				Math::randomFloat(margin, Config::fieldHeight - margin)
+			);
+			bool overlaps = Math::distanceBetween(robot.x, robot.y, scene.robot.x, scene.robot.y) < margin * 1.5f;
+
+			for (unsigned int j = 0; j < scene.robots.size() && !overlaps; j++) {
+				overlaps = robot.getDistanceTo(scene.robots[j]) < margin;
+			}
+
+			if (!overlaps) {
+				scene.robots.push_back(robot);
+
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < ballCount; i++) {
+		for (int attempt = 0; attempt < attempts; attempt++) {
+			Math::Point ball(
+				Math::randomFloat(Config::ballRadius, Config::fieldWidth - Config::ballRadius),
+				Math::randomFloat(Config::ballRadius, Config::fieldHeight - Config::ballRadius)
+			);
+			bool overlaps = Math::distanceBetween(ball.x, ball.y, scene.robot.x, scene.robot.y) < Config::robotRadius + Config::ballRadius;
+
+			for (unsigned int j = 0; j < scene.robots.size() && !overlaps; j++) {
+				overlaps = ball.getDistanceTo(scene.robots[j]) < Config::robotRadius + Config::ballRadius;
+			}
+
+			if (!overlaps) {
+				scene.balls.push_back(ball);
+
+				break;
+			}
+		}
+	}
+
+	return scene;
+}
+
+void FrameGenerator::pickColors(Blobber* blobber) {
+	const char* names[] = { "ball", "yellow-goal", "blue-goal", "white", "green", "black" };
+
+	colors[NONE_SURFACE] = pickColor(blobber, "");
+
+	for (int surface = 0; surface < NONE_SURFACE; surface++) {
+		if (blobber->getColorId(names[surface]) == -1) {
+			std::cout << "- Blobber has no color '" << names[surface] << "' to render, leaving it unclassified" << std::endl;
+
+			colors[surface] = colors[NONE_SURFACE];
+
+			continue;
+		}
+
+		colors[surface] = pickColor(blobber, names[surface]);
+	}
+}
+
+Blobber::Rgb FrameGenerator::pickColor(Blobber* blobber, const std::string& name) {
+	int colorId = name.empty() ? -1 : blobber->getColorId(name);
+	std::vector<Blobber::Rgb> candidates;
+	int sumRed = 0, sumGreen = 0, sumBlue = 0;
+
+	// the colors the thresholds classify as the wanted color after the same conversion to yuv as the camera frames go through
+	for (int red = 4; red < 256; red += 8) {
+		for (int green = 4; green < 256; green += 8) {
+			for (int blue = 4; blue < 256; blue += 8) {
+				int y = (66 * red + 129 * green + 25 * blue + 0x1080) >> 8;
+				int u = (112 * blue - 74 * green - 38 * red + 0x8080) >> 8;
+				int v = (112 * red - 94 * green - 18 * blue + 0x8080) >> 8;
+
+				if (Blobber::getColorIndex(blobber->getClass(y, u, v)) != colorId) {
+					continue;
+				}
+
+				candidates.push_back(Blobber::Rgb(red, green, blue));
+
+				sumRed += red;
+				sumGreen += green;
+				sumBlue += blue;
+			}
+		}
+	}
+
+	if (candidates.empty()) {
+		std::cout << "- Blobber thresholds classify no color as '" << name << "', using its example color" << std::endl;
+
+		return colorId == -1 ? Blobber::Rgb() : blobber->getColor(colorId)->color;
+	}
+
+	// the candidate closest to the middle of them all stays classified the same with some noise
+	int count = (int)candidates.size();
+	int bestDistance = -1;
+	Blobber::Rgb best;
+
+	for (int i = 0; i < count; i++) {
+		int dr = candidates[i].red - sumRed / count;
+		int dg = candidates[i].green - sumGreen / count;
+		int db = candidates[i].blue - sumBlue / count;
+		int distance = dr * dr + dg * dg + db * db;
+
+		if (bestDistance == -1 || distance < bestDistance) {
+			best = candidates[i];
+			bestDistance = distance;
+		}
+	}
+
+	return best;
+}
+
+void FrameGenerator::getCameraCoordinates(const Math::Position& robot, Dir dir, float x, float y, float& forward, float& right) {
+	float orientation = robot.orientation + (dir == Dir::REAR ? Math::PI : 0.0f);
+	float dx = x - robot.x;
+	float dy = y - robot.y;
+
+	// object angles are added to the robot orientation to get the field angle
+	forward = dx * Math::cos(orientation) + dy * Math::sin(orientation);
+	right = -dx * Math::sin(orientation) + dy * Math::cos(orientation);
+}
+
+bool FrameGenerator::project(CameraTranslator* translator, int width, float forward, float right, float height, float& cameraX, float& cameraY) {
+	if (forward - translator->B < minDepth) {
+		return false;
+	}
+
+	// inverse of the world position of the translator, C works out as the height of the camera
+	float scale = translator->A / (forward - translator->B);
+
+	cameraX = (float)(width / 2) + right * scale / translator->C;
+	cameraY = translator->horizon + scale * (1.0f - height / translator->C);
+
+	return true;
+}
+
+FrameGenerator::Surface FrameGenerator::getGroundSurface(float x, float y) {
+	float lineWidth = Config::fieldLineWidth;
+	float borderWidth = Config::fieldBorderWidth;
+
+	if (x < -borderWidth || x > Config::fieldWidth + borderWidth || y < -borderWidth || y > Config::fieldHeight + borderWidth) {
+		return NONE_SURFACE;
+	}
+
+	if (x < 0.0f || x > Config::fieldWidth || y < 0.0f || y > Config::fieldHeight) {
+		return BLACK_SURFACE;
+	}
+
+	if (
+		x < lineWidth || x > Config::fieldWidth - lineWidth
+		|| y < lineWidth || y > Config::fieldHeight - lineWidth
+		|| Math::abs(x - Config::fieldWidth / 2.0f) < lineWidth / 2.0f
+	) {
+		return WHITE_SURFACE;
+	}
+
+	return GREEN_SURFACE;
+}
+
+void FrameGenerator::addShapes(Dir dir, CameraTranslator* translator) {
+	float forward, right, x1, y1, x2, y2;
+
+	for (unsigned int i = 0; i < scene.balls.size(); i++) {
+		getCameraCoordinates(scene.robot, dir, scene.balls[i].x, scene.balls[i].y, forward, right);
+
+		if (!project(translator, width, forward, right, Config::ballRadius, x1, y1)) {
+			continue;
+		}
+
+		float radius = Config::ballRadius * translator->A / (forward - translator->B) / translator->C;
+
+		shapes.push_back(Shape(forward, BALL_SURFACE, x1 - radius, y1 - radius, x1 + radius, y1 + radius, true));
+	}
+
+	// other robots are black boxes of the size of their front side
+	for (unsigned int i = 0; i < scene.robots.size(); i++) {
+		getCameraCoordinates(scene.robot, dir, scene.robots[i].x, scene.robots[i].y, forward, right);
+
+		forward -= Config::robotRadius;
+
+		if (
+			!project(translator, width, forward, right - Config::robotRadius, Config::robotHeight, x1, y1)
+			|| !project(translator, width, forward, right + Config::robotRadius, 0.0f, x2, y2)
+		) {
+			continue;
+		}
+
+		shapes.push_back(Shape(forward, BLACK_SURFACE, x1, y1, x2, y2, false));
+	}
+
+	addGoalShapes(dir, translator, 0.0f, YELLOW_GOAL_SURFACE);
+	addGoalShapes(dir, translator, Config::fieldWidth, BLUE_GOAL_SURFACE);
+}
+
+void FrameGenerator::projectGoalEdges(const Math::Position& robot, Dir dir, CameraTranslator* translator, int width, float goalX, GoalEdgeList& edges) {
+	int stripCount = (int)(Config::goalWidth / goalStripWidth);
+	float startY = (Config::fieldHeight - Config::goalWidth) / 2.0f;
+	float right;
+
+	edges.resize(stripCount + 1);
+
+	for (int i = 0; i <= stripCount; i++) {
+		GoalEdge& edge = edges[i];
+
+		getCameraCoordinates(robot, dir, goalX, startY + goalStripWidth * i, edge.forward, right);
+
+		edge.visible = project(translator, width, edge.forward, right, Config::goalHeight, edge.topX, edge.topY)
+			&& project(translator, width, edge.forward, right, 0.0f, edge.bottomX, edge.bottomY);
+	}
+}
+
+void FrameGenerator::addGoalShapes(Dir dir, CameraTranslator* translator, float goalX, Surface surface) {
+	projectGoalEdges(scene.robot, dir, translator, width, goalX, goalEdges);
+
+	for (unsigned int i = 0; i + 1 < goalEdges.size(); i++) {
+		const GoalEdge& edge1 = goalEdges[i];
+		const GoalEdge& edge2 = goalEdges[i + 1];
+
+		if (!edge1.visible || !edge2.visible) {
+			continue;
+		}
+
+		shapes.push_back(Shape(
+			(edge1.forward + edge2.forward) / 2.0f, surface,
+			Math::min(edge1.topX, edge2.topX), Math::min(edge1.topY, edge2.topY),
+			Math::max(edge1.bottomX, edge2.bottomX), Math::max(edge1.bottomY, edge2.bottomY),
+			false
+		));
+	}
+}
+
+void FrameGenerator::drawGround(Dir dir, CameraTranslator* translator) {
+	float orientation = scene.robot.orientation + (dir == Dir::REAR ? Math::PI : 0.0f);
+	float forwardX = Math::cos(orientation);
+	float forwardY = Math::sin(orientation);
+	int centerX = width / 2;
+
+	for (int y = 0; y < height; y++) {
+		unsigned char* row = surfaces + y * width;
+		float pixelVerticalCoord = (float)y - translator->horizon;
+
+		if (pixelVerticalCoord < 1.0f) {
+			memset(row, NONE_SURFACE, width);
+
+			continue;
+		}
+
+		// world position of the translator for every pixel of the row, walking right from the first one
+		float forward = translator->B + translator->A / pixelVerticalCoord;
+		float rightStep = translator->C / pixelVerticalCoord;
+		float right = rightStep * (float)(-centerX);
+		float fieldX = scene.robot.x + forward * forwardX - right * forwardY;
+		float fieldY = scene.robot.y + forward * forwardY + right * forwardX;
+		float stepX = -rightStep * forwardY;
+		float stepY = rightStep * forwardX;
+
+		for (int x = 0; x < width; x++) {
+			row[x] = (unsigned char)getGroundSurface(fieldX, fieldY);
+
+			fieldX += stepX;
+			fieldY += stepY;
+		}
+	}
+}
+
+void FrameGenerator::drawShape(const Shape& shape) {
+	int startX = (int)Math::max(shape.x1, 0.0f);
+	int startY = (int)Math::max(shape.y1, 0.0f);
+	int endX = (int)Math::min(shape.x2, (float)(width - 1));
+	int endY = (int)Math::min(shape.y2, (float)(height - 1));
+	float centerX = (shape.x1 + shape.x2) / 2.0f;
+	float centerY = (shape.y1 + shape.y2) / 2.0f;
+	float radius = (shape.x2 - shape.x1) / 2.0f;
+
+	for (int y = startY; y <= endY; y++) {
+		unsigned char* row = surfaces + y * width;
+
+		for (int x = startX; x <= endX; x++) {
+			if (shape.round && Math::pow((float)x + 0.5f - centerX, 2) + Math::pow((float)y + 0.5f - centerY, 2) > radius * radius) {
+				continue;
+			}
+
+			row[x] = (unsigned char)shape.surface;
+		}
+	}
+}
+
+void FrameGenerator::applyDistortion(CameraTranslator* translator) {
+	unsigned char* output = dataRGB;
+
+	// every camera pixel shows what is at its undistorted position
+	for (int y = 0; y < height; y++) {
+		const CameraTranslator::CameraMapRow& rowX = translator->undistortMapX[y];
+		const CameraTranslator::CameraMapRow& rowY = translator->undistortMapY[y];
+
+		for (int x = 0; x < width; x++) {
+			int undistortedX = rowX[x];
+			int undistortedY = rowY[x];
+			Surface surface = NONE_SURFACE;
+
+			if (undistortedX >= 0 && undistortedX < width && undistortedY >= 0 && undistortedY < height) {
+				surface = (Surface)surfaces[undistortedY * width + undistortedX];
+			}
+
+			*output++ = colors[surface].red;
+			*output++ = colors[surface].green;
+			*output++ = colors[surface].blue;
+		}
+	}
+}
+
+void FrameGenerator::applyBlur() {
+	int size = blur * 2 + 1;
+
+	int stride = width * 3;
+
+	// box blur, horizontally into the blur buffer and vertically back, the edge pixels repeat outside the frame
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			for (int channel = 0; channel < 3; channel++) {
+				int sum = 0;
+
+				for (int offset = -blur; offset <= blur; offset++) {
+					int sampleX = std::min(std::max(x + offset, 0), width - 1);
+
+					sum += dataRGB[y * stride + sampleX * 3 + channel];
+				}
+
+				dataBlur[y * stride + x * 3 + channel] = (unsigned char)(sum / size);
+			}
+		}
+	}
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			for (int channel = 0; channel < 3; channel++) {
+				int sum = 0;
+
+				for (int offset = -blur; offset <= blur; offset++) {
+					int sampleY = std::min(std::max(y + offset, 0), height - 1);
+
+					sum += dataBlur[sampleY * stride + x * 3 + channel];
+				}
+
+				dataRGB[y * stride + x * 3 + channel] = (unsigned char)(sum / size);
+			}
+		}
+	}
+}
+
+void FrameGenerator::applyMosaic() {
+	const unsigned char* input = dataRGB;
+	unsigned char* output = dataBayer;
+
+	// RGGB, red and green on the even rows, green and blue on the odd ones
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int channel = (y & 1) + (x & 1);
+			int value = input[channel];
+
+			if (noise > 0.0f) {
+				value = (int)Math::limit((float)value + Math::randomGaussian(noise), 0.0f, 255.0f);
+			}
+
+			*output++ = (unsigned char)value;
+			input += 3;
+		}
+	}
+}
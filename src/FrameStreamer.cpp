@@ -0,0 +1,380 @@
+#include "FrameStreamer.h"
+#include "ImageProcessor.h"
+#include "Util.h"
+
+#include <iostream>
+
+FrameStreamer::FrameStreamer(Server* server, int width, int height) :
+	server(server), width(width), height(height),
+	running(true), pending(false), encoding(false), requested(false),
+	rgb(width * height * 3), classification(width * height * 3), frameNumber(-1), camera(Dir::FRONT),
+	jpegBuffer(Config::jpegBufferSize)
+{
+	formats[JPEG_CLASSIFICATION] = formats[RUN_CLASSIFICATION] = false;
+}
+
+FrameStreamer::~FrameStreamer() {
+	close();
+	join();
+}
+
+void FrameStreamer::close() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	running = false;
+
+	condition.notify_all();
+}
+
+void FrameStreamer::subscribe(Server::Client* client, int fps, ClassificationFormat format) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	Subscription* subscription = getSubscription(client);
+
+	subscription->interval = fps > 0 ? 1.0 / fps : 0.0;
+	subscription->format = format;
+
+	std::cout << "! Client #" << client->id << " " << (fps > 0 ? "subscribed to frames at " + Util::toString(fps) + " fps" + (format == RUN_CLASSIFICATION ? " with classification runs" : "") : "unsubscribed from frames") << std::endl;
+}
+
+void FrameStreamer::requestFrame(Server::Client* client) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	getSubscription(client)->once = true;
+}
+
+FrameStreamer::Request FrameStreamer::getRequest() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	Request request;
+
+	if (pending || encoding) {
+		return request;
+	}
+
+	double time = Util::millitime();
+
+	for (Subscriptions::const_iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+		if (isDue(*it, time)) {
+			request.wanted = true;
+		}
+	}
+
+	// only the classification formats that some client is due get rendered, copied and encoded
+	if (request.wanted) {
+		request.formats[JPEG_CLASSIFICATION] = isFormatDue(JPEG_CLASSIFICATION, time);
+		request.formats[RUN_CLASSIFICATION] = isFormatDue(RUN_CLASSIFICATION, time);
+	}
+
+	return request;
+}
+
+bool FrameStreamer::submit(const Request& request, unsigned char* rgb, unsigned char* classification, Blobber* blobber, int frameNumber, Dir camera, const std::string& streamName) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (!request.wanted) {
+		return false;
+	}
+
+	if (pending || encoding) {
+		stats.skipped++;
+
+		return false;
+	}
+
+	for (std::deque<EncodedFrame>::const_iterator it = cache.begin(); it != cache.end(); it++) {
+		if (it->frameNumber == frameNumber) {
+			requested = true;
+			condition.notify_one();
+
+			return true;
+		}
+	}
+
+	formats[JPEG_CLASSIFICATION] = request.formats[JPEG_CLASSIFICATION];
+	formats[RUN_CLASSIFICATION] = request.formats[RUN_CLASSIFICATION];
+
+	memcpy(&this->rgb[0], rgb, this->rgb.size());
+
+	if (formats[JPEG_CLASSIFICATION]) {
+		memcpy(&this->classification[0], classification, this->classification.size());
+	}
+
+	if (formats[RUN_CLASSIFICATION]) {
+		runs.assign(blobber->getRuns(), blobber->getRuns() + blobber->getRunCount());
+		colors.resize(blobber->getColorCount());
+
+		for (int i = 0; i < blobber->getColorCount(); i++) {
+			colors[i] = blobber->getColor(i)->color;
+		}
+	}
+
+	this->frameNumber = frameNumber;
+	this->camera = camera;
+	this->streamName = streamName;
+
+	pending = true;
+	condition.notify_one();
+
+	return true;
+}
+
+FrameStreamer::Stats FrameStreamer::getStats() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return stats;
+}
+
+void* FrameStreamer::run() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (running) {
+		if (!pending && !requested) {
+			condition.wait(lock);
+
+			continue;
+		}
+
+		if (pending) {
+			pending = false;
+			encoding = true;
+
+			lock.unlock();
+
+			EncodedFrame encoded;
+			bool encodeSuccess = encode(encoded);
+
+			lock.lock();
+
+			encoding = false;
+
+			if (!encodeSuccess) {
+				continue;
+			}
+
+			cache.push_back(encoded);
+			stats.encoded++;
+
+			while ((int)cache.size() > Config::frameCacheSize) {
+				cache.pop_front();
+			}
+		}
+
+		requested = false;
+
+		deliver(lock);
+	}
+
+	return NULL;
+}
+
+FrameStreamer::Subscription* FrameStreamer::getSubscription(Server::Client* client) {
+	for (Subscriptions::iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+		if (it->clientId == client->id) {
+			return &*it;
+		}
+	}
+
+	Subscription subscription;
+
+	subscription.clientId = client->id;
+	subscription.connection = client->connection;
+
+	subscriptions.push_back(subscription);
+
+	return &subscriptions.back();
+}
+
+bool FrameStreamer::isDue(const Subscription& subscription, double time) const {
+	return subscription.once || (subscription.interval > 0.0 && time - subscription.lastSendTime >= subscription.interval);
+}
+
+bool FrameStreamer::isFormatDue(ClassificationFormat format, double time) const {
+	for (Subscriptions::const_iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+		if (it->format == format && isDue(*it, time)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FrameStreamer::encode(EncodedFrame& encoded) {
+	int rgbSize = (int)jpegBuffer.size();
+
+	if (!ImageProcessor::rgbToJpeg(&rgb[0], &jpegBuffer[0], rgbSize, width, height)) {
+		std::cout << "- Converting RGB image to JPEG failed, probably need to increase buffer size" << std::endl;
+
+		return false;
+	}
+
+	std::string rgbJpeg((const char*)&jpegBuffer[0], rgbSize);
+
+	encoded.frameNumber = frameNumber;
+	encoded.sendCount = 0;
+
+	if (formats[JPEG_CLASSIFICATION]) {
+		int classificationSize = (int)jpegBuffer.size();
+
+		if (!ImageProcessor::rgbToJpeg(&classification[0], &jpegBuffer[0], classificationSize, width, height)) {
+			std::cout << "- Converting classification image to JPEG failed, probably need to increase buffer size" << std::endl;
+
+			return false;
+		}
+
+		boost::shared_ptr<std::string> message(new std::string());
+
+		message->reserve(HEADER_SIZE + streamName.size() + rgbSize + classificationSize);
+		encodeHeader(*message, FRAME_MESSAGE, rgbSize, classificationSize);
+		message->append(rgbJpeg);
+		message->append((const char*)&jpegBuffer[0], classificationSize);
+
+		encoded.messages[JPEG_CLASSIFICATION] = message;
+	}
+
+	if (formats[RUN_CLASSIFICATION]) {
+		std::string runSection;
+
+		encodeRuns(runSection);
+
+		boost::shared_ptr<std::string> message(new std::string());
+
+		message->reserve(HEADER_SIZE + streamName.size() + rgbSize + runSection.size());
+		encodeHeader(*message, RUNS_FRAME_MESSAGE, rgbSize, (int)runSection.size());
+		message->append(rgbJpeg);
+		message->append(runSection);
+
+		encoded.messages[RUN_CLASSIFICATION] = message;
+	}
+
+	return true;
+}
+
+void FrameStreamer::encodeHeader(std::string& message, MessageType type, int rgbSize, int classificationSize) {
+	unsigned char header[HEADER_SIZE];
+	unsigned int values[3] = { (unsigned int)frameNumber, (unsigned int)rgbSize, (unsigned int)classificationSize };
+	int nameLength = streamName.size() < 255 ? (int)streamName.size() : 255;
+
+	header[0] = (unsigned char)type;
+	header[1] = (unsigned char)camera;
+
+	for (int i = 0; i < 4; i++) {
+		header[2 + i] = (unsigned char)(values[0] >> (i * 8));
+		header[10 + i] = (unsigned char)(values[1] >> (i * 8));
+		header[14 + i] = (unsigned char)(values[2] >> (i * 8));
+	}
+
+	header[6] = (unsigned char)(width & 0xFF);
+	header[7] = (unsigned char)(width >> 8);
+	header[8] = (unsigned char)(height & 0xFF);
+	header[9] = (unsigned char)(height >> 8);
+	header[18] = (unsigned char)nameLength;
+
+	message.append((const char*)header, HEADER_SIZE);
+	message.append(streamName, 0, nameLength);
+}
+
+void FrameStreamer::encodeRuns(std::string& message) {
+	int colorCount = (int)colors.size();
+	int runCount = (int)runs.size();
+
+	// a run takes two bytes unless it is longer than 127 pixels
+	message.reserve(1 + colorCount * 3 + runCount * 2);
+	message.push_back((char)colorCount);
+
+	for (int i = 0; i < colorCount; i++) {
+		message.push_back((char)colors[i].red);
+		message.push_back((char)colors[i].green);
+		message.push_back((char)colors[i].blue);
+	}
+
+	for (int i = 0; i < runCount; i++) {
+		unsigned int length = (unsigned int)runs[i].length;
+
+		message.push_back((char)(Blobber::getColorIndex(runs[i].color) + 1));
+
+		while (length >= 0x80) {
+			message.push_back((char)((length & 0x7F) | 0x80));
+			length >>= 7;
+		}
+
+		message.push_back((char)length);
+	}
+}
+
+void FrameStreamer::deliver(boost::mutex::scoped_lock& lock) {
+	if (cache.empty()) {
+		return;
+	}
+
+	EncodedFrame newest = cache.back();
+	std::vector<Subscription> targets;
+	double time = Util::millitime();
+
+	for (Subscriptions::iterator it = subscriptions.begin(); it != subscriptions.end(); ) {
+		if (it->connection.expired()) {
+			it = subscriptions.erase(it);
+
+			continue;
+		}
+
+		// a client that just changed its format waits for the next frame
+		if (isDue(*it, time) && it->lastFrameNumber < newest.frameNumber && newest.messages[it->format]) {
+			targets.push_back(*it);
+		}
+
+		it++;
+	}
+
+	// sending happens without holding the lock so the main loop never waits for the sockets
+	lock.unlock();
+
+	std::vector<bool> sent(targets.size(), false);
+
+	for (unsigned int i = 0; i < targets.size(); i++) {
+		if (server->getBufferedAmount(targets[i].connection) > (size_t)Config::frameStreamMaxBuffered) {
+			continue;
+		}
+
+		server->sendBinary(targets[i].connection, *newest.messages[targets[i].format]);
+		sent[i] = true;
+	}
+
+	lock.lock();
+
+	for (unsigned int i = 0; i < targets.size(); i++) {
+		for (Subscriptions::iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+			if (it->clientId != targets[i].clientId) {
+				continue;
+			}
+
+			if (!sent[i]) {
+				stats.dropped++;
+
+				break;
+			}
+
+			// clients after the first one get the frame without encoding it again
+			if (cache.back().sendCount++ > 0) {
+				stats.cacheHits++;
+			}
+
+			// keeps to the frame rate despite the encoding delay, unless the client has fallen behind by more than a frame
+			it->lastSendTime = time - it->lastSendTime < it->interval * 2.0 ? it->lastSendTime + it->interval : time;
+			it->lastFrameNumber = newest.frameNumber;
+			it->once = false;
+			stats.sent++;
+
+			break;
+		}
+	}
+
+	// single frame requests without a subscription are done
+	for (Subscriptions::iterator it = subscriptions.begin(); it != subscriptions.end(); ) {
+		if (it->interval == 0.0 && !it->once) {
+			it = subscriptions.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#include "FramerBenchmark.h"
+#include "LineFramer.h"
+#include "BinaryProtocol.h"
+#include "Config.h"
+#include "Util.h"
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+FramerBenchmark::FramerBenchmark() {
+
+}
+
+bool FramerBenchmark::load(const std::string& filename) {
+	std::ifstream file(filename.c_str(), std::ios::binary);
+
+	if (!file.is_open()) {
+		std::cout << "- Failed to open serial capture: " << filename << std::endl;
+
+		return false;
+	}
+
+	stream.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	std::cout << "! Loaded " << stream.size() << " bytes of serial capture from " << filename << std::endl;
+
+	return true;
+}
+
+void FramerBenchmark::generate(int messageCount) {
+	unsigned char frame[BinaryProtocol::MAX_FRAME_SIZE];
+	char text[64];
+
+	stream.clear();
+
+	for (int i = 0; i < messageCount; i++) {
+		int length;
+
+		switch (i % 8) {
+			case 0:
+				length = BinaryProtocol::encodeBall(frame, (i / 8) % 2 == 0);
+				stream.insert(stream.end(), frame, frame + length);
+			break;
+
+			case 1:
+				length = BinaryProtocol::encodeSpeeds(frame, i % 300, -i % 300, 150, -150, 0);
+				stream.insert(stream.end(), frame, frame + length);
+			break;
+
+			case 2:
+				length = sprintf(text, "<adc:%d>\n", 250 + i % 50);
+				stream.insert(stream.end(), text, text + length);
+			break;
+
+			case 3:
+				// line noise and a broken message that the framer has to resynchronize from
+				length = sprintf(text, "#\xA5\x02<speeds:1:2");
+				stream.insert(stream.end(), text, text + length);
+			break;
+
+			default:
+				length = sprintf(text, "<speeds:%d:%d:%d:%d:%d>\n", i % 200, -(i % 200), i % 50, -(i % 50), 0);
+				stream.insert(stream.end(), text, text + length);
+			break;
+		}
+	}
+
+	std::cout << "! Generated " << stream.size() << " bytes of serial stream" << std::endl;
+}
+
+void FramerBenchmark::run(int passes) {
+	std::vector<std::string> expected;
+	std::vector<std::string> actual;
+
+	frame(0, &expected);
+
+	double lineRate = Config::serialBaud / 10.0;
+	double startTime = Util::preciseTime();
+	int frameCount = 0;
+	bool matching = true;
+
+	for (int pass = 0; pass < passes; pass++) {
+		// chunk sizes vary per pass so frames get split at every possible position
+		frameCount += frame(1 + pass % 97, pass == 0 ? &actual : NULL);
+	}
+
+	double duration = Util::preciseTime() - startTime;
+	double byteRate = (double)stream.size() * passes / duration;
+
+	if (actual != expected) {
+		matching = false;
+	}
+
+	std::cout << "! Replayed " << passes << " passes, " << frameCount << " frames in " << duration << "s" << std::endl;
+	std::cout << "  > " << (int)(frameCount / duration) << " frames/s, " << (int)byteRate << " bytes/s, " << (int)(byteRate / lineRate) << "x line rate at " << Config::serialBaud << " baud" << std::endl;
+	std::cout << "  > " << expected.size() << " frames per pass, chunked framing " << (matching ? "matches" : "DIFFERS FROM") << " whole stream framing" << std::endl;
+}
+
+int FramerBenchmark::frame(int maxChunkSize, std::vector<std::string>* frames) {
+	LineFramer framer(Config::serialReceiveBufferSize);
+	StringView message;
+	const char* data = stream.empty() ? NULL : &stream[0];
+	int remaining = (int)stream.size();
+	int frameCount = 0;
+	int chunk = 0;
+
+	while (remaining > 0) {
+		int chunkSize = maxChunkSize > 0 ? 1 + (chunk++ * 7) % maxChunkSize : remaining;
+
+		if (chunkSize > remaining) {
+			chunkSize = remaining;
+		}
+
+		while (chunkSize > 0) {
+			int written = framer.write(data, chunkSize);
+
+			data += written;
+			remaining -= written;
+			chunkSize -= written;
+
+			while (framer.next(message)) {
+				if (frames != NULL) {
+					frames->push_back(message.toString());
+				}
+
+				frameCount++;
+			}
+		}
+	}
+
+	return frameCount;
+}
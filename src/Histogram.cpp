@@ -0,0 +1,92 @@
+#include "Histogram.h"
+
+#include <sstream>
+
+void Histogram::clear() {
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		buckets[i] = 0;
+	}
+
+	count = 0;
+	sum = 0;
+	min = 0;
+	max = 0;
+}
+
+void Histogram::add(__int64 value) {
+	if (count == 0 || value < min) {
+		min = value;
+	}
+
+	if (count == 0 || value > max) {
+		max = value;
+	}
+
+	buckets[getBucket(value)]++;
+	count++;
+	sum += value;
+}
+
+// the middle of the bucket that contains the percentile
+double Histogram::getPercentile(double fraction) const {
+	if (count == 0) {
+		return 0.0;
+	}
+
+	int target = (int)(fraction * (count - 1)) + 1;
+	int total = 0;
+
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		total += buckets[i];
+
+		if (total >= target) {
+			double value = (double)(getBucketStart(i) + getBucketStart(i + 1)) / 2.0;
+
+			return value < (double)min ? (double)min : value > (double)max ? (double)max : value;
+		}
+	}
+
+	return (double)max;
+}
+
+std::string Histogram::toJSON(double unit) const {
+	std::stringstream stream;
+
+	stream << "{";
+	stream << "\"count\":" << count << ",";
+	stream << "\"mean\":" << getMean() / unit << ",";
+	stream << "\"min\":" << (double)min / unit << ",";
+	stream << "\"p50\":" << getPercentile(0.5) / unit << ",";
+	stream << "\"p90\":" << getPercentile(0.9) / unit << ",";
+	stream << "\"p99\":" << getPercentile(0.99) / unit << ",";
+	stream << "\"max\":" << (double)max / unit;
+	stream << "}";
+
+	return stream.str();
+}
+
+// exact below 4
+int Histogram::getBucket(__int64 value) {
+	if (value < 4) {
+		return value > 0 ? (int)value : 0;
+	}
+
+	int octave = 0;
+
+	while (value >= 8) {
+		value >>= 1;
+		octave++;
+	}
+
+	int bucket = 4 + octave * 4 + (int)(value - 4);
+
+	return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+__int64 Histogram::getBucketStart(int bucket) {
+	if (bucket < 4) {
+		return bucket;
+	}
+
+	return (__int64)(4 + (bucket - 4) % 4) << ((bucket - 4) / 4);
+}
@@ -0,0 +1,157 @@
+#include "LineFramer.h"
+
+#include <string.h>
+
+LineFramer::LineFramer(int minCapacity) : head(0), tail(0), binary(false), frameCount(0), errorCount(0), droppedByteCount(0) {
+	capacity = 1;
+
+	while (capacity < minCapacity) {
+		capacity <<= 1;
+	}
+
+	mask = capacity - 1;
+	buffer.resize(capacity);
+	wrapped.resize(capacity);
+}
+
+int LineFramer::write(const char* data, int length) {
+	int available = capacity - (int)(tail - head);
+
+	if (available == 0 && length > 0) {
+		// a message longer than the buffer never completes, start over
+		droppedByteCount += capacity;
+		errorCount++;
+		head = tail;
+		available = capacity;
+	}
+
+	int count = length < available ? length : available;
+	int start = tail & mask;
+	int firstPart = count < capacity - start ? count : capacity - start;
+
+	memcpy(&buffer[start], data, firstPart);
+	memcpy(&buffer[0], data + firstPart, count - firstPart);
+
+	tail += count;
+
+	return count;
+}
+
+bool LineFramer::next(StringView& frame) {
+	while (true) {
+		int available = (int)(tail - head);
+		int messageStart = find('<', 0, available);
+		int frameStart = find((char)BinaryProtocol::FRAME_START, 0, messageStart != -1 ? messageStart : available);
+		int start = frameStart != -1 ? frameStart : messageStart;
+
+		if (start == -1) {
+			head = tail;
+
+			return false;
+		}
+
+		head += start;
+		available -= start;
+
+		if (start == messageStart) {
+			int end = find('>', 1, available);
+			int restart = find('<', 1, end != -1 ? end : available);
+
+			if (restart != -1) {
+				errorCount++;
+				head += restart;
+
+				continue;
+			}
+
+			if (end == -1) {
+				return false;
+			}
+
+			frame = view(end + 1);
+			head += end + 1;
+			binary = false;
+			frameCount++;
+
+			return true;
+		}
+
+		if (available < BinaryProtocol::HEADER_SIZE) {
+			return false;
+		}
+
+		int type = (unsigned char)at(1);
+		int payloadLength = (unsigned char)at(2);
+
+		if (!BinaryProtocol::isValidLength(type, payloadLength)) {
+			errorCount++;
+			head++;
+
+			continue;
+		}
+
+		int frameLength = BinaryProtocol::HEADER_SIZE + payloadLength + BinaryProtocol::CRC_SIZE;
+
+		if (available < frameLength) {
+			return false;
+		}
+
+		BinaryProtocol::Frame decoded;
+		bool valid = false;
+
+		decoder.reset();
+
+		for (int i = 0; i < frameLength && !valid; i++) {
+			valid = decoder.push((unsigned char)at(i), decoded);
+		}
+
+		if (!valid) {
+			// the start byte was part of something else, resynchronize from the next byte
+			errorCount++;
+			head++;
+
+			continue;
+		}
+
+		head += frameLength;
+		frame = StringView(scratch, BinaryProtocol::toText(decoded, scratch));
+		binary = true;
+		frameCount++;
+
+		return true;
+	}
+}
+
+int LineFramer::find(char character, int from, int available) const {
+	if (from >= available) {
+		return -1;
+	}
+
+	int start = (head + from) & mask;
+	int firstPart = available - from < capacity - start ? available - from : capacity - start;
+	const char* found = (const char*)memchr(&buffer[start], character, firstPart);
+
+	if (found != NULL) {
+		return from + (int)(found - &buffer[start]);
+	}
+
+	found = (const char*)memchr(&buffer[0], character, available - from - firstPart);
+
+	return found != NULL ? from + firstPart + (int)(found - &buffer[0]) : -1;
+}
+
+StringView LineFramer::view(int length) {
+	int start = head & mask;
+
+	if (start + length <= capacity) {
+		return StringView(&buffer[start], length);
+	}
+
+	// wrapped around the end of the ring
+	int firstPart = capacity - start;
+
+	memcpy(&wrapped[0], &buffer[start], firstPart);
+	memcpy(&wrapped[firstPart], &buffer[0], length - firstPart);
+
+	return StringView(&wrapped[0], length);
+}
@@ -6,12 +6,18 @@
 #include "Coilgun.h"
 #include "Util.h"
 
-ManualController::ManualController(Robot* robot, AbstractCommunication* com) : Controller(robot, com), lastCommandTime(0.0) {
+#include <boost/bind.hpp>
 
+ManualController::ManualController(Robot* robot, AbstractCommunication* com) : Controller(robot, com), lastCommandTime(0.0) {
+	commands.add("target-vector", "fff", boost::bind(&ManualController::handleTargetVectorCommand, this, _1));
+	commands.add("target-dir", "fff", boost::bind(&ManualController::handleTargetDirCommand, this, _1));
+	commands.add("set-dribbler", "f", boost::bind(&ManualController::handleSetDribblerCommand, this, _1));
+	commands.add("kick", "i", boost::bind(&ManualController::handleKickCommand, this, _1));
+	commands.add("reset-position", "", boost::bind(&ManualController::handleResetPositionCommand, this, _1));
 };
 
 void ManualController::reset() {
-	com->send("reset");
+	com->sendReset();
 }
 
 void ManualController::step(float dt, Vision::Results* visionResults) {
@@ -23,24 +29,6 @@ void ManualController::step(float dt, Vision::Results* visionResults) {
 	}
 }
 
-bool ManualController::handleCommand(const Command& cmd) {
-    if (cmd.name == "target-vector" && cmd.parameters.size() == 3) {
-        handleTargetVectorCommand(cmd);
-    } else if (cmd.name == "target-dir" && cmd.parameters.size() == 3) {
-        handleTargetDirCommand(cmd);
-    } else if (cmd.name == "set-dribbler" && cmd.parameters.size() == 1) {
-        handleSetDribblerCommand(cmd);
-    } else if (cmd.name == "kick" && cmd.parameters.size() == 1) {
-        handleKickCommand(cmd);
-    } else if (cmd.name == "reset-position") {
-		robot->setPosition(Config::fieldWidth / 2.0f, Config::fieldHeight / 2.0f, 0.0f);
-    } else {
-        return false;
-    }
-
-    return true;
-}
-
 void ManualController::handleCommunicationMessage(std::string message) {
 	if (Command::isValid(message)) {
         Command command = Command::parse(message);
@@ -49,38 +37,42 @@ void ManualController::handleCommunicationMessage(std::string message) {
 	}
 }
 
-void ManualController::handleTargetVectorCommand(const Command& cmd) {
-    float x = Util::toFloat(cmd.parameters[0]);
-    float y = Util::toFloat(cmd.parameters[1]);
-    float omega = Util::toFloat(cmd.parameters[2]);
+void ManualController::handleTargetVectorCommand(const CommandDispatcher::Arguments& args) {
+    float x = args.getFloat(0);
+    float y = args.getFloat(1);
+    float omega = args.getFloat(2);
 
     robot->setTargetDir(x, y, omega);
 
 	lastCommandTime = Util::millitime();
 }
 
-void ManualController::handleTargetDirCommand(const Command& cmd) {
-    Math::Deg dir = Math::Deg(Util::toFloat(cmd.parameters[0]));
-    float speed = Util::toFloat(cmd.parameters[1]);
-    float omega = Util::toFloat(cmd.parameters[2]);
+void ManualController::handleTargetDirCommand(const CommandDispatcher::Arguments& args) {
+    Math::Deg dir = Math::Deg(args.getFloat(0));
+    float speed = args.getFloat(1);
+    float omega = args.getFloat(2);
 
     robot->setTargetDir(dir, speed, omega);
 
 	lastCommandTime = Util::millitime();
 }
 
-void ManualController::handleSetDribblerCommand(const Command& cmd) {
-    float targetOmega = Util::toFloat(cmd.parameters[0]);
+void ManualController::handleSetDribblerCommand(const CommandDispatcher::Arguments& args) {
+    float targetOmega = args.getFloat(0);
 
 	robot->dribbler->setTargetOmega(targetOmega);
 }
 
-void ManualController::handleKickCommand(const Command& cmd) {
-    int strength = Util::toInt(cmd.parameters[0]);
+void ManualController::handleKickCommand(const CommandDispatcher::Arguments& args) {
+    int strength = args.getInt(0);
 
 	robot->coilgun->kick(strength);
 }
 
+void ManualController::handleResetPositionCommand(const CommandDispatcher::Arguments& args) {
+	robot->setPosition(Config::fieldWidth / 2.0f, Config::fieldHeight / 2.0f, 0.0f);
+}
+
 std::string ManualController::getJSON() {
 	return "null";
 }
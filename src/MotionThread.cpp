@@ -0,0 +1,102 @@
+#include "MotionThread.h"
+#include "Robot.h"
+#include "Maths.h"
+#include "Util.h"
+#include "Profiler.h"
+
+MotionThread::MotionThread(Robot* robot, float frequency) : Thread(), robot(robot), period(1.0f / frequency), running(true),
+	windowStartTime(0.0), windowTicks(0), windowSquaredError(0.0f), windowMaxError(0.0f)
+{
+
+}
+
+void MotionThread::stop() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	running = false;
+}
+
+bool MotionThread::isRunning() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return running;
+}
+
+MotionThread::Stats MotionThread::getStats() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return stats;
+}
+
+void* MotionThread::run() {
+	double nextTime = Util::preciseTime();
+	double lastTime = nextTime;
+	double currentTime;
+	double remaining;
+	bool overrun;
+
+	windowStartTime = nextTime;
+
+	while (isRunning()) {
+		nextTime += period;
+		remaining = nextTime - Util::preciseTime();
+		overrun = remaining < 0.0;
+
+		if (overrun) {
+			// a step took longer than the period, don't try to catch up
+			nextTime = Util::preciseTime();
+		} else {
+			// sleep most of the remaining time and yield the rest as sleep granularity is about a millisecond
+			if (remaining > 0.002) {
+				Util::sleep((int)((remaining - 0.001) * 1000.0));
+			}
+
+			while (Util::preciseTime() < nextTime) {
+				Util::sleep(0);
+			}
+		}
+
+		currentTime = Util::preciseTime();
+		float dt = (float)(currentTime - lastTime);
+		lastTime = currentTime;
+
+		Profiler::Scope scope(Profiler::MOTION_ZONE);
+
+		robot->stepMotion(dt);
+
+		scope.end();
+
+		updateStats(dt, overrun);
+	}
+
+	return NULL;
+}
+
+void MotionThread::updateStats(float dt, bool overrun) {
+	float error = Math::abs(dt - period);
+
+	windowTicks++;
+	windowSquaredError += error * error;
+	windowMaxError = Math::max(windowMaxError, error);
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (overrun) {
+		stats.overrunCount++;
+	}
+
+	double windowDuration = Util::preciseTime() - windowStartTime;
+
+	if (windowDuration < 1.0) {
+		return;
+	}
+
+	stats.rate = (float)(windowTicks / windowDuration);
+	stats.jitter = Math::sqrt(windowSquaredError / (float)windowTicks) * 1000.0f;
+	stats.maxJitter = windowMaxError * 1000.0f;
+
+	windowStartTime += windowDuration;
+	windowTicks = 0;
+	windowSquaredError = 0.0f;
+	windowMaxError = 0.0f;
+}
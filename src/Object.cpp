@@ -1,11 +1,9 @@
 #include "Object.h"
-#include "Util.h"
+#include "ObjectArena.h"
 #include "Maths.h"
 #include "Config.h"
 
-Object::Object(int x, int y, int width, int height, int area, float distance, float distanceX, float distanceY, float angle, int type, bool behind) : x(x), y(y), width(width), height(height), area(area), distance(distance), distanceX(distanceX), distanceY(distanceY), angle(angle), type(type), behind(behind), processed(false) {
-	lastSeenTime = Util::millitime();
-}
+Object::Object(int x, int y, int width, int height, int area, float distance, float distanceX, float distanceY, float angle, int type, bool behind) : x(x), y(y), width(width), height(height), area(area), distance(distance), distanceX(distanceX), distanceY(distanceY), angle(angle), type(type), lastSeenTime(0.0), behind(behind), processed(false) {}
 
 void Object::copyFrom(const Object* other) {
 	x = other->x;
@@ -51,10 +49,12 @@ bool Object::contains(Object* other) const {
 	return bx1 >= ax1 && bx2 <= ax2 && by1 >= ay1 && by2 <= ay2;
 }
 
-Object* Object::mergeWith(Object* other) const {
-	Object* merged = new Object();
+Object* Object::mergeWith(Object* other, ObjectArena& arena) const {
+	Object* merged = arena.create(*this);
 
-	merged->copyFrom(this);
+	if (merged == NULL) {
+		return NULL;
+	}
 
 	float minX = Math::max(Math::min((float)(x - width / 2), (float)(other->x - other->width / 2)), 0.0f);
 	float minY = Math::max(Math::min((float)(y - height / 2), (float)(other->y - other->height / 2)), 0.0f);
@@ -72,10 +72,8 @@ Object* Object::mergeWith(Object* other) const {
 	return merged;
 }
 
-std::vector<Object*> Object::mergeOverlapping(const std::vector<Object*>& set, int margin, bool requireSameType) {
-	ObjectList stack(set);
-	ObjectList individuals;
-	ObjectList garbage;
+void Object::mergeOverlapping(std::vector<Object*>& stack, std::vector<Object*>& individuals, ObjectArena& arena, int margin, bool requireSameType) {
+	individuals.clear();
 
 	while (stack.size() > 0) {
 		Object* object1 = stack.back();
@@ -103,7 +101,7 @@ std::vector<Object*> Object::mergeOverlapping(const std::vector<Object*>& set, i
 				continue;
 			}
 
-			mergedObject = object1->mergeWith(object2);
+			mergedObject = object1->mergeWith(object2, arena);
 
 			if (mergedObject != NULL) {
 				object1->processed = true;
@@ -112,8 +110,6 @@ std::vector<Object*> Object::mergeOverlapping(const std::vector<Object*>& set, i
 				merged = true;
 
 				stack.push_back(mergedObject);
-				garbage.push_back(object1);
-				garbage.push_back(object2);
 
 				break;
 			}
@@ -123,12 +119,4 @@ std::vector<Object*> Object::mergeOverlapping(const std::vector<Object*>& set, i
 			individuals.push_back(object1);
 		}
 	}
-
-	for (ObjectListItc it = garbage.begin(); it != garbage.end(); it++) {
-		delete *it;
-	}
-
-	garbage.clear();
-
-	return individuals;
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "OdometryAccumulator.h"
+#include "Odometer.h"
+#include "Wheel.h"
+#include "Maths.h"
+#include "Util.h"
+#include "Config.h"
+
+OdometryAccumulator::OdometryAccumulator() : lastSampleTime(-1.0) {
+	odometer = new Odometer(
+		Config::robotWheelAngle1,
+		Config::robotWheelAngle2,
+		Config::robotWheelAngle3,
+		Config::robotWheelAngle4,
+		Config::robotWheelOffset,
+		Config::robotWheelRadius
+	);
+}
+
+OdometryAccumulator::~OdometryAccumulator() {
+	if (odometer != NULL) delete odometer; odometer = NULL;
+}
+
+void OdometryAccumulator::onCommunicationReceive(const StringView& message) {
+	int speeds[4];
+
+	if (!parseSpeeds(message, speeds)) {
+		return;
+	}
+
+	double time = Util::millitime();
+
+	if (lastSampleTime < 0.0) {
+		lastSampleTime = time;
+
+		return;
+	}
+
+	// the reported speeds are integrated over the interval since the previous report
+	float dt = Math::min((float)(time - lastSampleTime), Config::odometryMaxSampleInterval);
+
+	lastSampleTime = time;
+
+	Odometer::Movement movement = odometer->calculateMovement(
+		Wheel::speedToOmega((float)speeds[Config::wheelFLId]),
+		Wheel::speedToOmega((float)speeds[Config::wheelFRId]),
+		Wheel::speedToOmega((float)speeds[Config::wheelRLId]),
+		Wheel::speedToOmega((float)speeds[Config::wheelRRId])
+	);
+
+	// same integration order as the odometer localizer, rotate first
+	pose.orientation += movement.omega * dt;
+	pose.x += (movement.velocityX * Math::cos((float)pose.orientation) - movement.velocityY * Math::sin((float)pose.orientation)) * dt;
+	pose.y += (movement.velocityX * Math::sin((float)pose.orientation) + movement.velocityY * Math::cos((float)pose.orientation)) * dt;
+	pose.time += dt;
+	pose.sampleCount++;
+
+	poses.getBack() = pose;
+	poses.publish();
+}
+
+OdometryAccumulator::Delta OdometryAccumulator::consume() {
+	Delta delta;
+
+	if (!poses.update()) {
+		return delta;
+	}
+
+	const Pose& latest = poses.getFront();
+
+	float worldDx = (float)(latest.x - consumed.x);
+	float worldDy = (float)(latest.y - consumed.y);
+	float orientation = (float)latest.orientation;
+
+	delta.dx = worldDx * Math::cos(orientation) + worldDy * Math::sin(orientation);
+	delta.dy = -worldDx * Math::sin(orientation) + worldDy * Math::cos(orientation);
+	delta.dOrientation = (float)(latest.orientation - consumed.orientation);
+	delta.duration = (float)(latest.time - consumed.time);
+	delta.sampleCount = latest.sampleCount - consumed.sampleCount;
+
+	consumed = latest;
+
+	return delta;
+}
+
+void OdometryAccumulator::Delta::append(const Delta& next) {
+	float cosine = Math::cos(next.dOrientation);
+	float sine = Math::sin(next.dOrientation);
+	float previousDx = dx;
+
+	// express the translation so far in the robot frame at the end of the next delta
+	dx = cosine * previousDx + sine * dy + next.dx;
+	dy = -sine * previousDx + cosine * dy + next.dy;
+	dOrientation += next.dOrientation;
+	duration += next.duration;
+	sampleCount += next.sampleCount;
+}
+
+bool OdometryAccumulator::parseSpeeds(const StringView& message, int speeds[4]) {
+	static const char prefix[] = "<speeds:";
+
+	if (!message.startsWith(prefix)) {
+		return false;
+	}
+
+	// parsed within the view as it is not zero terminated
+	const char* cursor = message.getData() + sizeof(prefix) - 1;
+	const char* end = message.getData() + message.getLength();
+
+	for (int i = 0; i < 4; i++) {
+		bool negative = cursor < end && *cursor == '-';
+		const char* digits = negative ? cursor + 1 : cursor;
+		int value = 0;
+
+		for (cursor = digits; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++) {
+			value = value * 10 + (*cursor - '0');
+		}
+
+		if (cursor == digits || cursor == end || (*cursor != ':' && *cursor != '>')) {
+			return false;
+		}
+
+		speeds[i] = negative ? -value : value;
+		cursor++;
+	}
+
+	return true;
+}
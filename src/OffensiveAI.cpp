@@ -15,7 +15,7 @@ OffensiveAI::OffensiveAI(Robot* robot, AbstractCommunication* com) : BaseAI(robo
 void OffensiveAI::reset() {
 	std::cout << "! Reset offensive AI" << std::endl;
 
-	com->send("reset");
+	com->sendReset();
 	targetSide = Side::UNKNOWN;
 	totalDuration = 0.0f;
 	currentStateDuration = 0.0f;
@@ -0,0 +1,172 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <tchar.h>
+#include <strsafe.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+
+unsigned int Platform::getMilliseconds() {
+	return timeGetTime();
+}
+
+__int64 Platform::getCounter() {
+	LARGE_INTEGER counter;
+
+	QueryPerformanceCounter(&counter);
+
+	return counter.QuadPart;
+}
+
+__int64 Platform::getCounterFrequency() {
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceFrequency(&frequency);
+
+	return frequency.QuadPart;
+}
+
+void Platform::sleep(int milliseconds) {
+	Sleep(milliseconds);
+}
+
+void* Platform::allocateAligned(size_t size, size_t alignment, bool hugePages) {
+	// pages are aligned more than the vision needs, large pages require the lock pages in memory privilege
+	SIZE_T largePageSize = GetLargePageMinimum();
+
+	if (hugePages && largePageSize > 0 && size >= largePageSize) {
+		void* data = VirtualAlloc(NULL, (size + largePageSize - 1) / largePageSize * largePageSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+
+		if (data != NULL) {
+			return data;
+		}
+	}
+
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void Platform::freeAligned(void* data) {
+	if (data != NULL) {
+		VirtualFree(data, 0, MEM_RELEASE);
+	}
+}
+
+std::vector<std::string> Platform::getFilesInDir(const std::string& path) {
+	std::vector<std::string> files;
+
+	TCHAR szDir[MAX_PATH];
+	HANDLE hFind = INVALID_HANDLE_VALUE;
+	WIN32_FIND_DATA ffd;
+
+	StringCchCopy(szDir, MAX_PATH, path.c_str());
+	StringCchCat(szDir, MAX_PATH, TEXT("\\*"));
+
+	hFind = FindFirstFile(szDir, &ffd);
+
+	if (INVALID_HANDLE_VALUE == hFind) {
+		return files;
+	}
+
+	do {
+		if (!(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			files.push_back(ffd.cFileName);
+		}
+	} while (FindNextFile(hFind, &ffd) != 0);
+
+	FindClose(hFind);
+
+	return files;
+}
+
+#else
+
+unsigned int Platform::getMilliseconds() {
+	timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (unsigned int)((unsigned long long)time.tv_sec * 1000ULL + time.tv_nsec / 1000000);
+}
+
+__int64 Platform::getCounter() {
+	timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (__int64)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+__int64 Platform::getCounterFrequency() {
+	return 1000000000LL;
+}
+
+void Platform::sleep(int milliseconds) {
+	if (milliseconds <= 0) {
+		sched_yield();
+	} else {
+		usleep(milliseconds * 1000);
+	}
+}
+
+void* Platform::allocateAligned(size_t size, size_t alignment, bool hugePages) {
+	const size_t hugePageSize = 2 * 1024 * 1024;
+	void* data = NULL;
+
+	// transparent huge pages are only advised, the kernel falls back to normal pages on its own
+	if (hugePages && size >= hugePageSize) {
+		size = (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+
+		if (posix_memalign(&data, hugePageSize, size) != 0) {
+			return NULL;
+		}
+
+#ifdef MADV_HUGEPAGE
+		madvise(data, size, MADV_HUGEPAGE);
+#endif
+
+		return data;
+	}
+
+	if (posix_memalign(&data, alignment, size) != 0) {
+		return NULL;
+	}
+
+	return data;
+}
+
+void Platform::freeAligned(void* data) {
+	free(data);
+}
+
+std::vector<std::string> Platform::getFilesInDir(const std::string& path) {
+	std::vector<std::string> files;
+	DIR* dir = opendir(path.c_str());
+
+	if (dir == NULL) {
+		return files;
+	}
+
+	dirent* entry;
+	struct stat info;
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (stat((path + "/" + entry->d_name).c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+			files.push_back(entry->d_name);
+		}
+	}
+
+	closedir(dir);
+
+	return files;
+}
+
+#endif
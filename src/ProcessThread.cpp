@@ -3,56 +3,63 @@
 #include "ImageProcessor.h"
 #include "DebugRenderer.h"
 #include "Canvas.h"
+#include "FrameBufferPool.h"
 #include "BaseCamera.h"
 #include "Util.h"
+#include "Profiler.h"
 #include "Config.h"
 
 #include <iostream>
 
-ProcessThread::ProcessThread(BaseCamera* camera, Blobber* blobber, Vision* vision) : Thread(), dir(dir), camera(camera), blobber(blobber), vision(vision), visionResult(NULL), debug(false), gotFrame(false), faulty(false), done(true) {
+ProcessThread::ProcessThread(BaseCamera* camera, Blobber* blobber, Vision* vision, CaptureThread* capture) : Thread(), dir(dir), camera(camera), capture(capture), blobber(blobber), vision(vision), visionResult(NULL), debug(false), classify(true), gotFrame(false), faulty(false), done(true) {
 	frame = NULL;
+	frameSlot = NULL;
+	frameTimestamp = 0.0;
+	frameNumber = -1;
 	width = blobber->getWidth();
 	height = blobber->getHeight();
-	dataY = new unsigned char[width * height];
-    dataU = new unsigned char[(width / 2) * (height / 2)];
-    dataV = new unsigned char[(width / 2) * (height / 2)];
-	dataYUYV = new unsigned char[width * height * 3];
-	classification = new unsigned char[width * height * 3];
-	argb = new unsigned char[width * height * 4];
-	rgb = new unsigned char[width * height * 3];
+	dataY = FrameBufferPool::acquire(FrameBufferPool::Y_PLANE, width, height);
+	dataU = FrameBufferPool::acquire(FrameBufferPool::CHROMA_PLANE, width, height);
+	dataV = FrameBufferPool::acquire(FrameBufferPool::CHROMA_PLANE, width, height);
+	dataYUYV = FrameBufferPool::acquire(FrameBufferPool::YUYV_FORMAT, width, height);
+	classification = NULL;
+	argb = NULL;
+	rgb = NULL;
 
 	visionResult = new Vision::Result();
 	visionResult->vision = vision;
 }
 
 ProcessThread::~ProcessThread() {
+	if (capture != NULL) {
+		capture->release(frameSlot);
+		frameSlot = NULL;
+	}
+
 	if (visionResult != NULL) {
 		delete visionResult;
 		visionResult = NULL;
 	}
 
-	delete dataY;
-	delete dataU;
-	delete dataV;
-	delete dataYUYV;
-	delete classification;
-	delete argb;
-	delete rgb;
+	FrameBufferPool::release(dataY);
+	FrameBufferPool::release(dataU);
+	FrameBufferPool::release(dataV);
+	FrameBufferPool::release(dataYUYV);
+	FrameBufferPool::release(classification);
+	FrameBufferPool::release(argb);
+	FrameBufferPool::release(rgb);
 }
 
 void* ProcessThread::run() {
+	// before fetching as the debug images of the previous frame are drawn on when the frame fails
+	updateDebugBuffers();
+
 	gotFrame = fetchFrame();
 
 	if (!gotFrame || frame == NULL) {
 		if (faulty) {
-			if (visionResult != NULL) {
-				delete visionResult;
-				visionResult = NULL;
-			}
-
-			// fetching frame failed, create empty result set
-			visionResult = new Vision::Result();
-			visionResult->vision = vision;
+			// fetching frame failed, empty the result set
+			visionResult->reset(Util::millitime(), -1);
 
 			std::cout << "- Getting frame failed and faulty camera detected, creating blank results" << std::endl;
 		} else {
@@ -62,50 +69,47 @@ void* ProcessThread::run() {
 		return NULL;
 	}
 
-	if (visionResult != NULL) {
-		delete visionResult;
-		visionResult = NULL;
-	}
+	visionResult->reset(frameTimestamp, frameNumber);
 
 	done = false;
-	
-	//Util::timerStart();
+
+	Profiler::Scope scope(Profiler::BAYER_ZONE);
+
 	ImageProcessor::bayerRGGBToI420(
 		frame,
 		dataY, dataU, dataV,
 		width, height
 	);
-	//std::cout << "  - RGGB > I420: " << Util::timerEnd() << std::endl;
 
-	//Util::timerStart();
+	scope.next(Profiler::YUYV_ZONE);
+
 	ImageProcessor::I420ToYUYV(
 		dataY, dataU, dataV,
 		dataYUYV,
 		width, height
 	);
-	//std::cout << "  - I420 > YUYV: " << Util::timerEnd() << std::endl;
 
-	//Util::timerStart();
+	scope.next(Profiler::BLOBBER_ZONE);
+
 	blobber->processFrame((Blobber::Pixel*)dataYUYV);
-	//std::cout << "  - Process:     " << Util::timerEnd() << " (" << blobber->getBlobCount("ball") << " ball blobs)" << std::endl;
 
 	if (debug) {
-		//Util::timerStart();
-		blobber->classify((Blobber::Rgb*)classification, (Blobber::Pixel*)dataYUYV);
-		//std::cout << "  - Blobber classify: " << Util::timerEnd() << std::endl;
+		if (classify) {
+			scope.next(Profiler::CLASSIFY_ZONE);
+
+			blobber->classify((Blobber::Rgb*)classification, (Blobber::Pixel*)dataYUYV);
+		}
+
+		scope.next(Profiler::DEBUG_IMAGE_ZONE);
 
-		//Util::timerStart();
 		ImageProcessor::YUYVToARGB(dataYUYV, argb, width, height);
-		//std::cout << "  - YUYV > ARGB: " << Util::timerEnd() << std::endl;
 
-		//Util::timerStart();
 		//ImageProcessor::ARGBToBGR(
 		ImageProcessor::ARGBToRGB(
 			argb,
 			rgb,
 			width, height
 		);
-		//std::cout << "  - ARGB > RGB: " << Util::timerEnd() << std::endl;
 
 		vision->setDebugImage(rgb, width, height);
 	} else {
@@ -117,7 +121,15 @@ void* ProcessThread::run() {
 		DebugRenderer::renderGrid(rgb, vision);
 	}
 
-	visionResult = vision->process();
+	scope.next(Profiler::VISION_ZONE);
+
+	vision->process(visionResult);
+
+	scope.end();
+
+	if (visionResult->objects.getOverflowCount() > 0) {
+		std::cout << "- Dropped " << visionResult->objects.getOverflowCount() << " objects over the vision object arena size" << std::endl;
+	}
 
 	if (debug) {
 		// DebugRenderer::renderBlobs(classification, blobber);
@@ -134,14 +146,49 @@ void* ProcessThread::run() {
 }
 
 bool ProcessThread::fetchFrame() {
-	if (camera->isAcquisitioning()) {
+	// the capture thread only serves its own camera, not the screenshot stream that may replace it
+	bool captured = capture != NULL && capture->getCamera() == camera;
+
+	if (!captured && frameSlot != NULL) {
+		capture->release(frameSlot);
+		frameSlot = NULL;
+	}
+
+	if (captured && camera->isAcquisitioning()) {
+		Profiler::Scope scope(Profiler::FETCH_ZONE);
+
+		// the newest frame if it hasn't been processed yet, otherwise the next one
+		CaptureThread::Slot* slot = capture->takeFrame(Config::cameraFrameTimeout);
+
+		scope.end();
+
+		if (slot == NULL) {
+			std::cout << "- No frame from camera #" << camera->getSerial() << " in " << Config::cameraFrameTimeout << " seconds" << std::endl;
+
+			faulty = true;
+
+			return false;
+		}
+
+		capture->release(frameSlot);
+
+		frameSlot = slot;
+		frame = slot->frame.data;
+		frameTimestamp = slot->frame.timestamp;
+		frameNumber = slot->frame.number;
+
+		return true;
+	} else if (camera->isAcquisitioning()) {
 		double startTime = Util::millitime();
+		Profiler::Scope scope(Profiler::FETCH_ZONE);
 		
 		const BaseCamera::Frame* cameraFrame = camera->getFrame();
+
+		scope.end();
 		
 		double timeTaken = Util::duration(startTime);
 
-		if (timeTaken > 0.03) {
+		if (timeTaken > Config::cameraFrameTimeout) {
 			std::cout << "- Fetching camera #" << camera->getSerial() << " frame took: " << timeTaken << std::endl;
 
 			faulty = true;
@@ -168,6 +215,8 @@ bool ProcessThread::fetchFrame() {
 		if (cameraFrame != NULL) {
 			if (cameraFrame->fresh) {
 				frame = cameraFrame->data;
+				frameTimestamp = cameraFrame->timestamp;
+				frameNumber = cameraFrame->number;
 
 				return true;
 			}
@@ -175,4 +224,22 @@ bool ProcessThread::fetchFrame() {
 	}
 
 	return false;
-}
\ No newline at end of file
+}
+
+void ProcessThread::updateDebugBuffers() {
+	if (debug) {
+		if (rgb == NULL) {
+			classification = FrameBufferPool::acquire(FrameBufferPool::RGB_FORMAT, width, height);
+			argb = FrameBufferPool::acquire(FrameBufferPool::ARGB_FORMAT, width, height);
+			rgb = FrameBufferPool::acquire(FrameBufferPool::RGB_FORMAT, width, height);
+		}
+	} else if (rgb != NULL) {
+		FrameBufferPool::release(classification);
+		FrameBufferPool::release(argb);
+		FrameBufferPool::release(rgb);
+
+		classification = NULL;
+		argb = NULL;
+		rgb = NULL;
+	}
+}
@@ -0,0 +1,270 @@
+#include "Profiler.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace {
+	const char* zoneNames[Profiler::ZONE_COUNT] = {
+		"frame", "fetch", "bayer", "yuyv", "blobber", "classify", "debug-image", "vision",
+		"server", "communication", "controller", "robot", "motion", "state", "profiler"
+	};
+}
+
+std::vector<Profiler::Ring*> Profiler::rings;
+Histogram Profiler::histograms[Profiler::ZONE_COUNT];
+pthread_key_t Profiler::ringKey = Profiler::createRingKey();
+boost::mutex Profiler::mutex;
+double Profiler::overhead = 0.0;
+int Profiler::lostCount = 0;
+std::ofstream* Profiler::trace = NULL;
+std::string Profiler::traceFilename;
+__int64 Profiler::traceStartTime = 0;
+__int64 Profiler::traceEndTime = 0;
+int Profiler::traceEventCount = 0;
+
+const char* Profiler::getZoneName(Zone zone) {
+	return zone >= 0 && zone < ZONE_COUNT ? zoneNames[zone] : "unknown";
+}
+
+void Profiler::record(Zone zone, __int64 start, __int64 end) {
+	Ring* ring = getRing();
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+	Entry& entry = ring->entries[head % RING_SIZE];
+
+	entry.start = start;
+	entry.end = end;
+	entry.zone = zone;
+
+	// publishes the entry to the collecting thread
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+// created before any thread records, releases the ring of a thread when it finishes
+pthread_key_t Profiler::createRingKey() {
+	pthread_key_t key;
+
+	pthread_key_create(&key, releaseRing);
+
+	return key;
+}
+
+Profiler::Ring* Profiler::getRing() {
+	Ring* ring = (Ring*)pthread_getspecific(ringKey);
+
+	if (ring != NULL) {
+		return ring;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	// threads are started for every frame so rings of finished threads are handed out again
+	for (unsigned int i = 0; i < rings.size(); i++) {
+		if (!rings[i]->used) {
+			ring = rings[i];
+
+			break;
+		}
+	}
+
+	if (ring == NULL) {
+		ring = new Ring();
+		ring->id = (int)rings.size() + 1;
+
+		rings.push_back(ring);
+	}
+
+	ring->used = true;
+
+	pthread_setspecific(ringKey, ring);
+
+	return ring;
+}
+
+void Profiler::releaseRing(void* ring) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	((Ring*)ring)->used = false;
+}
+
+void Profiler::collect() {
+	Scope scope(PROFILER_ZONE);
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (unsigned int i = 0; i < rings.size(); i++) {
+		collectRing(rings[i]);
+	}
+
+	if (trace != NULL && Util::nanotime() > traceEndTime) {
+		lock.unlock();
+
+		stopTrace();
+	}
+}
+
+void Profiler::collectRing(Ring* ring) {
+	unsigned int head = ring->head.load(std::memory_order_acquire);
+
+	if (head - ring->read > RING_SIZE) {
+		lostCount += head - ring->read - RING_SIZE;
+		ring->read = head - RING_SIZE;
+	}
+
+	unsigned int read = ring->read;
+	Entry entries[64];
+
+	while (read != head) {
+		int count = head - read < 64 ? head - read : 64;
+
+		for (int i = 0; i < count; i++) {
+			entries[i] = ring->entries[(read + i) % RING_SIZE];
+		}
+
+		// entries that the thread has overwritten while they were copied are dropped
+		unsigned int newHead = ring->head.load(std::memory_order_acquire);
+		int skip = 0;
+
+		if (newHead - read > RING_SIZE) {
+			skip = newHead - read - RING_SIZE < (unsigned int)count ? newHead - read - RING_SIZE : count;
+			lostCount += skip;
+		}
+
+		for (int i = skip; i < count; i++) {
+			if (entries[i].zone >= 0 && entries[i].zone < ZONE_COUNT) {
+				histograms[entries[i].zone].add(entries[i].end - entries[i].start);
+
+				if (trace != NULL) {
+					traceEntry(entries[i], ring->id);
+				}
+			}
+		}
+
+		read += count;
+	}
+
+	ring->read = read;
+}
+
+double Profiler::measureOverhead(int iterations) {
+	__int64 startTime = Util::nanotime();
+
+	for (int i = 0; i < iterations; i++) {
+		Scope scope(PROFILER_ZONE);
+	}
+
+	__int64 duration = Util::nanotime() - startTime;
+
+	// the measurement is not collected
+	Ring* ring = getRing();
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		ring->read = ring->head.load(std::memory_order_acquire);
+		overhead = (double)duration / iterations;
+	}
+
+	std::cout << "! Profiler scope overhead: " << overhead << "ns" << std::endl;
+
+	return overhead;
+}
+
+void Profiler::reset() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (int i = 0; i < ZONE_COUNT; i++) {
+		histograms[i].clear();
+	}
+
+	lostCount = 0;
+}
+
+bool Profiler::startTrace(const std::string& filename, double duration) {
+	stopTrace();
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	trace = new std::ofstream(filename.c_str(), std::ios::out | std::ios::trunc);
+
+	if (!trace->is_open()) {
+		std::cout << "- Opening profiler trace file '" << filename << "' failed" << std::endl;
+
+		delete trace;
+		trace = NULL;
+
+		return false;
+	}
+
+	traceFilename = filename;
+	traceStartTime = Util::nanotime();
+	traceEndTime = traceStartTime + (__int64)(duration * 1000000000.0);
+	traceEventCount = 0;
+
+	*trace << "{\"traceEvents\":[" << std::endl;
+
+	std::cout << "! Tracing zones for " << duration << "s to " << filename << std::endl;
+
+	return true;
+}
+
+void Profiler::stopTrace() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (trace == NULL) {
+		return;
+	}
+
+	*trace << std::endl << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+	trace->close();
+
+	delete trace;
+	trace = NULL;
+
+	std::cout << "! Wrote " << traceEventCount << " zones to profiler trace " << traceFilename << std::endl;
+}
+
+void Profiler::traceEntry(const Entry& entry, int threadId) {
+	if (entry.start < traceStartTime || entry.start > traceEndTime) {
+		return;
+	}
+
+	// complete events with microsecond timestamps
+	*trace << (traceEventCount++ > 0 ? ",\n" : "")
+		<< "{\"name\":\"" << zoneNames[entry.zone] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+		<< ",\"ts\":" << (double)(entry.start - traceStartTime) / 1000.0
+		<< ",\"dur\":" << (double)(entry.end - entry.start) / 1000.0 << "}";
+}
+
+std::string Profiler::getJSON() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	std::stringstream stream;
+	bool first = true;
+
+	stream << "{";
+	stream << "\"overhead\":" << overhead << ",";
+	stream << "\"lost\":" << lostCount << ",";
+	stream << "\"threads\":" << rings.size() << ",";
+	stream << "\"tracing\":" << (trace != NULL ? "true" : "false") << ",";
+	stream << "\"zones\":{";
+
+	for (int i = 0; i < ZONE_COUNT; i++) {
+		const Histogram& histogram = histograms[i];
+
+		if (histogram.getCount() == 0) {
+			continue;
+		}
+
+		if (!first) {
+			stream << ",";
+		} else {
+			first = false;
+		}
+
+		stream << "\"" << zoneNames[i] << "\":" << histogram.toJSON(1000000.0);
+	}
+
+	stream << "}}";
+
+	return stream.str();
+}
@@ -0,0 +1,181 @@
+#include "Recorder.h"
+
+#include <iostream>
+
+Recorder::Recorder(int width, int height) : width(width), height(height), running(false) {
+
+}
+
+Recorder::~Recorder() {
+	close();
+}
+
+bool Recorder::open(const std::string& filename) {
+	file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open()) {
+		std::cout << "- Opening recording file '" << filename << "' failed" << std::endl;
+
+		return false;
+	}
+
+	this->filename = filename;
+
+	int header[3] = { VERSION, width, height };
+
+	file.write("SBLG", 4);
+	file.write((const char*)header, sizeof(header));
+
+	stats.bytes = 4 + sizeof(header);
+	running = true;
+
+	start();
+
+	std::cout << "! Recording camera frames and communication to " << filename << std::endl;
+
+	return true;
+}
+
+void Recorder::recordStep(float dt, double time) {
+	if (!step.empty()) {
+		commitStep();
+	}
+
+	append((unsigned char)STEP_RECORD);
+	append(dt);
+	append(time);
+}
+
+void Recorder::recordFrame(Dir camera, const unsigned char* data, int number, double timestamp) {
+	if (step.empty() || data == NULL) {
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		// the loop would stall on the disk otherwise, the replay keeps using the previous frame of the camera instead
+		if ((int)pendingSteps.size() >= Config::recordMaxPendingSteps) {
+			stats.droppedFrames++;
+
+			return;
+		}
+
+		stats.frames++;
+	}
+
+	append((unsigned char)FRAME_RECORD);
+	append((unsigned char)camera);
+	append(number);
+	append(timestamp);
+	append(data, width * height);
+}
+
+void Recorder::recordMessage(const std::string& message) {
+	if (step.empty()) {
+		return;
+	}
+
+	append((unsigned char)MESSAGE_RECORD);
+	append((int)message.size());
+	append(message.c_str(), (int)message.size());
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	stats.messages++;
+}
+
+void Recorder::close() {
+	if (!file.is_open()) {
+		return;
+	}
+
+	if (!step.empty()) {
+		commitStep();
+	}
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		running = false;
+
+		condition.notify_one();
+	}
+
+	join();
+
+	file.close();
+
+	std::cout << "! Recorded " << stats.steps << " steps with " << stats.frames << " frames (" << stats.droppedFrames << " dropped) and " << stats.messages << " messages, " << (stats.bytes / (1024 * 1024)) << "MB to " << filename << std::endl;
+}
+
+Recorder::Stats Recorder::getStats() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return stats;
+}
+
+void Recorder::commitStep() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (!running) {
+		step.clear();
+
+		return;
+	}
+
+	pendingSteps.push_back(std::string());
+	pendingSteps.back().swap(step);
+
+	// the next step reuses the capacity of a written one so frames are not reallocated every step
+	if (!freeSteps.empty()) {
+		step.swap(freeSteps.back());
+		freeSteps.pop_back();
+	}
+
+	stats.steps++;
+
+	condition.notify_one();
+}
+
+void Recorder::append(const void* data, int length) {
+	step.append((const char*)data, length);
+}
+
+void* Recorder::run() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (running || !pendingSteps.empty()) {
+		if (pendingSteps.empty()) {
+			condition.wait(lock);
+
+			continue;
+		}
+
+		std::string written;
+
+		written.swap(pendingSteps.front());
+		pendingSteps.pop_front();
+
+		lock.unlock();
+
+		file.write(written.c_str(), written.size());
+
+		lock.lock();
+
+		stats.bytes += written.size();
+
+		if (!file.good()) {
+			std::cout << "- Writing recording to " << filename << " failed" << std::endl;
+
+			running = false;
+			pendingSteps.clear();
+		}
+
+		written.clear();
+		freeSteps.push_back(std::string());
+		freeSteps.back().swap(written);
+	}
+
+	return NULL;
+}
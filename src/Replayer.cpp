@@ -0,0 +1,165 @@
+#include "Replayer.h"
+#include "VirtualCamera.h"
+#include "DummyCommunication.h"
+#include "Util.h"
+
+#include <iostream>
+
+Replayer::Replayer() : width(0), height(0), stepCount(0), realtime(false), firstStepTime(0.0), lastStepTime(0.0), startTime(0.0), timeOffset(0.0) {
+
+}
+
+bool Replayer::open(const std::string& filename) {
+	file.open(filename.c_str(), std::ios::in | std::ios::binary);
+
+	if (!file.is_open()) {
+		std::cout << "- Opening replay file '" << filename << "' failed" << std::endl;
+
+		return false;
+	}
+
+	this->filename = filename;
+
+	char magic[4];
+	int header[3];
+
+	if (!read(magic, 4) || !read(header, sizeof(header)) || memcmp(magic, "SBLG", 4) != 0 || header[0] != Recorder::VERSION) {
+		std::cout << "- File '" << filename << "' is not a recording of a supported version" << std::endl;
+
+		file.close();
+
+		return false;
+	}
+
+	width = header[1];
+	height = header[2];
+	stepCount = 0;
+
+	if (width != Config::cameraWidth || height != Config::cameraHeight) {
+		std::cout << "- Recording frames are " << width << "x" << height << " but the cameras are configured for " << Config::cameraWidth << "x" << Config::cameraHeight << std::endl;
+
+		file.close();
+
+		return false;
+	}
+
+	frameBuffer.resize(width * height);
+
+	std::cout << "! Replaying " << width << "x" << height << " recording " << filename << std::endl;
+
+	return true;
+}
+
+bool Replayer::next(Step& step, VirtualCamera* frontCamera, VirtualCamera* rearCamera, DummyCommunication* com) {
+	if (!file.is_open()) {
+		return false;
+	}
+
+	unsigned char type;
+
+	if (!read(type) || type != Recorder::STEP_RECORD || !read(step.dt) || !read(step.time)) {
+		return false;
+	}
+
+	step.frames = 0;
+	step.messages = 0;
+
+	// the playback is paced on the performance counter as the clock of the robot is set to the recording
+	double time = Util::preciseTime();
+
+	if (stepCount == 0) {
+		firstStepTime = step.time;
+		startTime = time;
+		timeOffset = time - step.time;
+	}
+
+	lastStepTime = step.time;
+
+	if (realtime) {
+		double wait = step.time + timeOffset - time;
+
+		if (wait > 0.0) {
+			Util::sleep((int)(wait * 1000.0));
+		} else if (wait < -Config::replayMaxLag) {
+			// a slow step delays the rest of the playback rather than having the following ones rushed
+			timeOffset -= wait;
+		}
+	}
+
+	// the timers of the robot and the controllers run on the recorded time like they do in the simulator
+	Util::setSimulatedTime(step.time);
+
+	while (file.peek() == Recorder::FRAME_RECORD || file.peek() == Recorder::MESSAGE_RECORD) {
+		read(type);
+
+		if (type == Recorder::FRAME_RECORD) {
+			unsigned char camera;
+			int number;
+			double timestamp;
+
+			if (!read(camera) || !read(number) || !read(timestamp) || !read(&frameBuffer[0], (int)frameBuffer.size())) {
+				break;
+			}
+
+			VirtualCamera* target = camera == Dir::FRONT ? frontCamera : rearCamera;
+
+			target->setFrame(&frameBuffer[0], (int)frameBuffer.size(), number, timestamp);
+
+			step.frames++;
+		} else {
+			int length;
+
+			if (!read(length) || length < 0) {
+				break;
+			}
+
+			message.resize(length);
+
+			if (length > 0 && !read(&message[0], length)) {
+				break;
+			}
+
+			com->receive(message);
+
+			step.messages++;
+		}
+	}
+
+	stepCount++;
+
+	return true;
+}
+
+void Replayer::close() {
+	if (!file.is_open()) {
+		return;
+	}
+
+	file.close();
+
+	Util::clearSimulatedTime();
+
+	double duration = Util::preciseTime() - startTime;
+
+	std::cout << "! Replayed " << stepCount << " steps of " << (lastStepTime - firstStepTime) << "s in " << duration << "s";
+
+	if (duration > 0.0) {
+		std::cout << ", " << (stepCount / duration) << " steps per second";
+	}
+
+	std::cout << std::endl;
+}
+
+bool Replayer::read(void* data, int length) {
+	file.read((char*)data, length);
+
+	if (file.gcount() != length) {
+		if (file.gcount() != 0) {
+			std::cout << "- Recording " << filename << " ends with an incomplete record after " << stepCount << " steps" << std::endl;
+		}
+
+		return false;
+	}
+
+	return true;
+}
@@ -4,6 +4,8 @@
 #include "Coilgun.h"
 #include "Odometer.h"
 #include "OdometerLocalizer.h"
+#include "OdometryAccumulator.h"
+#include "MotionThread.h"
 #include "Util.h"
 #include "Tasks.h"
 #include "Config.h"
@@ -12,7 +14,7 @@
 #include <map>
 #include <sstream>
 
-Robot::Robot(AbstractCommunication* com) : com(com), wheelFL(NULL), wheelFR(NULL), wheelRL(NULL), wheelRR(NULL), coilgun(NULL), robotLocalizer(NULL), odometerLocalizer(NULL), ballLocalizer(NULL), odometer(NULL), visionResults(NULL), chipKickRequested(false), requestedChipKickLowerDribbler(false), requestedChipKickDistance(0.0f), lookAtPid(0.35f, 0.0f, 0.0012f, 0.016f) {
+Robot::Robot(AbstractCommunication* com) : com(com), wheelFL(NULL), wheelFR(NULL), wheelRL(NULL), wheelRR(NULL), coilgun(NULL), robotLocalizer(NULL), odometerLocalizer(NULL), ballLocalizer(NULL), odometer(NULL), odometryAccumulator(NULL), visionResults(NULL), chipKickRequested(false), requestedChipKickLowerDribbler(false), requestedChipKickDistance(0.0f), lookAtActive(false), lookAtAngle(0.0f), lookAtRotation(0.0f), lookAtPid(0.35f, 0.0f, 0.0012f, 1.0f / Config::motionControlFrequency), motionThread(NULL) {
     targetOmega = 0;
     targetDir = Math::Vector(0, 0);
    
@@ -26,6 +28,7 @@ Robot::Robot(AbstractCommunication* com) : com(com), wheelFL(NULL), wheelFR(NULL
 	travelledRotation = 0.0f;
 
     lastCommandTime = -1;
+	lastProtocolRequestTime = 0.0;
 	lastDriveBehindBallTime = -1;
 	frameTargetSpeedSet = false;
 	coilgunCharged = false;
@@ -34,6 +37,8 @@ Robot::Robot(AbstractCommunication* com) : com(com), wheelFL(NULL), wheelFR(NULL
 
 	float lookAtLimit = 10.0f;
 
+	// the gain, integral and derivative times are in seconds and the pid scales them by its interval, so the tunings
+	// made at the camera frame rate hold at the motion control rate
 	// lookAtPid.setTunings(0.35f, 0.0f, 0.0012f); // 2014
 	lookAtPid.setTunings(0.4f, 0.0f, 0.002f);
 	lookAtPid.setInputLimits(-Config::lookAtMaxSpeedAngle, Config::lookAtMaxSpeedAngle);
@@ -44,6 +49,8 @@ Robot::Robot(AbstractCommunication* com) : com(com), wheelFL(NULL), wheelFR(NULL
 }
 
 Robot::~Robot() {
+	stopMotionThread();
+
     if (wheelRR != NULL) delete wheelRR; wheelRR = NULL;
     if (wheelRL != NULL) delete wheelRL; wheelRL = NULL;
     if (wheelFR != NULL) delete wheelFR; wheelFR = NULL;
@@ -51,6 +58,7 @@ Robot::~Robot() {
 	if (coilgun != NULL) delete coilgun; coilgun = NULL;
 	if (dribbler != NULL) delete dribbler; dribbler = NULL;
 	if (odometer != NULL) delete odometer; odometer = NULL;
+	if (odometryAccumulator != NULL) delete odometryAccumulator; odometryAccumulator = NULL;
 	if (ballLocalizer != NULL) delete ballLocalizer; ballLocalizer = NULL;
 	if (robotLocalizer != NULL) delete robotLocalizer; robotLocalizer = NULL;
 	if (odometerLocalizer != NULL) delete odometerLocalizer; odometerLocalizer = NULL;
@@ -107,6 +115,8 @@ void Robot::setupRobotLocalizer() {
 
 void Robot::setupBallLocalizer() {
 	ballLocalizer = new BallLocalizer();
+
+	visibleBalls.reserve(Config::ballLocalizerPoolSize);
 }
 
 void Robot::setupOdometerLocalizer() {
@@ -122,10 +132,14 @@ void Robot::setupWheels() {
 
 void Robot::setupCoilgun() {
 	coilgun = new Coilgun(com);
+
+	com->addReceiveListener(coilgun);
 }
 
 void Robot::setupDribbler() {
 	dribbler = new Dribbler(Config::dribblerId, com, coilgun);
+
+	coilgun->setDribbler(dribbler);
 }
 
 void Robot::setupOdometer() {
@@ -137,11 +151,169 @@ void Robot::setupOdometer() {
 		Config::robotWheelOffset,
 		Config::robotWheelRadius
 	);
+
+	odometryAccumulator = new OdometryAccumulator();
+
+	com->addReceiveListener(odometryAccumulator);
+}
+
+void Robot::startMotionThread() {
+	if (motionThread != NULL) {
+		return;
+	}
+
+	motionThread = new MotionThread(this, Config::motionControlFrequency);
+	motionThread->start();
+}
+
+void Robot::stopMotionThread() {
+	if (motionThread == NULL) {
+		return;
+	}
+
+	motionThread->stop();
+	motionThread->join();
+
+	delete motionThread;
+	motionThread = NULL;
+}
+
+// the wheels and the look-at pid belong to the motion control, the lock is only released for sending
+void Robot::stepMotion(float dt) {
+	OdometryAccumulator::Delta delta = odometryAccumulator->consume();
+	int speedFL, speedFR, speedRL, speedRR, speedDribbler;
+	bool reacting;
+
+	{
+		boost::mutex::scoped_lock lock(motionMutex);
+
+		MotionCommand command = motionCommand;
+
+		reacting = !command.sent;
+		motionCommand.sent = true;
+
+		updateOdometry(delta);
+		updateWheelSpeeds(command.targetDir, command.lookAtActive ? updateLookAt(command) : command.targetOmega);
+
+		wheelFL->step(dt);
+		wheelFR->step(dt);
+		wheelRL->step(dt);
+		wheelRR->step(dt);
+
+		updateWheelState(motionFeedback.wheelFL, wheelFL);
+		updateWheelState(motionFeedback.wheelFR, wheelFR);
+		updateWheelState(motionFeedback.wheelRL, wheelRL);
+		updateWheelState(motionFeedback.wheelRR, wheelRR);
+
+		speedFL = (int)Math::round(wheelFL->getTargetSpeed());
+		speedFR = (int)Math::round(wheelFR->getTargetSpeed());
+		speedRL = (int)Math::round(wheelRL->getTargetSpeed());
+		speedRR = (int)Math::round(wheelRR->getTargetSpeed());
+		speedDribbler = (int)Math::round(command.dribblerSpeed);
+	}
+
+	com->sendSpeeds(speedFL, speedFR, speedRL, speedRR, speedDribbler);
+	com->flush();
+
+	if (reacting) {
+		boost::mutex::scoped_lock lock(motionMutex);
+
+		motionFeedback.sendTime = Util::millitime();
+	}
+}
+
+void Robot::updateOdometry(const OdometryAccumulator::Delta& delta) {
+	if (delta.sampleCount == 0 || delta.duration <= 0.0f) {
+		return;
+	}
+
+	motionFeedback.odometry.append(delta);
+
+	motionFeedback.movement = Odometer::Movement(
+		delta.dx / delta.duration,
+		delta.dy / delta.duration,
+		delta.dOrientation / delta.duration
+	);
+
+	motionFeedback.travelledDistance += Math::sqrt(delta.dx * delta.dx + delta.dy * delta.dy);
+	motionFeedback.totalRotation += delta.dOrientation;
+}
+
+float Robot::updateLookAt(const MotionCommand& command) {
+	// the target angle was measured from a camera frame, account for how much the robot has turned since
+	float angle = Math::getAngleDiff(motionFeedback.totalRotation - command.lookAtRotation, command.lookAtAngle);
+
+	lookAtPid.setSetPoint(0.0f);
+	lookAtPid.setProcessValue(Math::radToDeg(angle));
+
+	return -lookAtPid.compute();
+}
+
+void Robot::updateWheelState(WheelState& state, Wheel* wheel) {
+	state.stalled = wheel->isStalled();
+	state.targetOmega = wheel->getTargetOmega();
+	state.filteredTargetOmega = wheel->getFilteredTargetOmega();
+	state.realOmega = wheel->getRealOmega();
+}
+
+void Robot::receiveMotion() {
+	MotionFeedback feedback;
+
+	{
+		boost::mutex::scoped_lock lock(motionMutex);
+
+		feedback = motionFeedback;
+
+		motionFeedback.odometry = OdometryAccumulator::Delta();
+		motionFeedback.travelledDistance = 0.0f;
+		motionFeedback.sendTime = 0.0;
+	}
+
+	if (feedback.sendTime != 0.0) {
+		updateSendLatency(frontLatency, feedback.sendTime);
+		updateSendLatency(rearLatency, feedback.sendTime);
+	}
+
+	if (feedback.odometry.sampleCount > 0) {
+		frameOdometry.append(feedback.odometry);
+
+		movement = feedback.movement;
+
+		Math::Vector velocityVec(movement.velocityX, movement.velocityY);
+		lastVelocity = velocity;
+		velocity = velocityVec.getLength();
+
+		omega = movement.omega;
+
+		travelledDistance += feedback.travelledDistance;
+		travelledRotation += feedback.odometry.dOrientation;
+	}
+
+	receivedMotion = feedback;
+}
+
+void Robot::publishMotion() {
+	boost::mutex::scoped_lock lock(motionMutex);
+
+	motionCommand.targetDir = targetDir;
+	motionCommand.targetOmega = targetOmega;
+	motionCommand.dribblerSpeed = dribbler->getTargetSpeed();
+	motionCommand.lookAtActive = lookAtActive;
+	motionCommand.lookAtAngle = lookAtAngle;
+	motionCommand.lookAtRotation = lookAtRotation;
+	motionCommand.sent = false;
 }
 
 void Robot::step(float dt, Vision::Results* visionResults) {
 	this->visionResults = visionResults;
 
+	if (visionResults != NULL) {
+		double time = Util::millitime();
+
+		updateCommandLatency(frontLatency, visionResults->front, time);
+		updateCommandLatency(rearLatency, visionResults->rear, time);
+	}
+
 	lastDt = dt;
     totalTime += dt;
 
@@ -151,57 +323,54 @@ void Robot::step(float dt, Vision::Results* visionResults) {
 		coilgunCharged = true;
 	}
 
-    handleTasks(dt);
-    updateWheelSpeeds();
-    updateBallLocalizer(visionResults, dt);
+	// keep requesting the binary protocol until the firmware acknowledges it
+	if (Config::communicationProtocol == Config::BINARY_PROTOCOL && !com->isBinaryProtocol() && Util::duration(lastProtocolRequestTime) >= 1.0) {
+		com->requestBinaryProtocol();
+
+		lastProtocolRequestTime = Util::millitime();
+	}
 
-    wheelFL->step(dt);
-    wheelFR->step(dt);
-    wheelRL->step(dt);
-    wheelRR->step(dt);
+    handleTasks(dt);
 	coilgun->step(dt);
 	dribbler->step(dt);
 
-	com->setSpeeds(
-		(int)Math::round(wheelFL->getTargetSpeed()),
-		(int)Math::round(wheelFR->getTargetSpeed()),
-		(int)Math::round(wheelRL->getTargetSpeed()),
-		(int)Math::round(wheelRR->getTargetSpeed()),
-		(int)Math::round(dribbler->getTargetSpeed())
-	);
+	Odometer::Movement frameMovement;
 
-	// TODO restore once serial is working correctly
-	com->send("speeds:"
-		+ Util::toString((int)Math::round(wheelFL->getTargetSpeed())) + ":"
-		+ Util::toString((int)Math::round(wheelFR->getTargetSpeed())) + ":"
-		+ Util::toString((int)Math::round(wheelRL->getTargetSpeed())) + ":"
-		+ Util::toString((int)Math::round(wheelRR->getTargetSpeed())) + ":"
-		+ Util::toString((int)Math::round(dribbler->getTargetSpeed()))
-	);
+	if (frameOdometry.sampleCount > 0 && dt > 0.0f) {
+		// wheel feedback integrated by the motion control, scaled so moving for dt reproduces the delta
+		frameMovement = Odometer::Movement(
+			frameOdometry.dx / dt,
+			frameOdometry.dy / dt,
+			frameOdometry.dOrientation / dt
+		);
+	} else {
+		movement = odometer->calculateMovement(
+			receivedMotion.wheelFL.realOmega,
+			receivedMotion.wheelFR.realOmega,
+			receivedMotion.wheelRL.realOmega,
+			receivedMotion.wheelRR.realOmega
+		);
 
-	movement = odometer->calculateMovement(
-		wheelFL->getRealOmega(),
-		wheelFR->getRealOmega(),
-		wheelRL->getRealOmega(),
-		wheelRR->getRealOmega()
-	);
+		Math::Vector velocityVec(movement.velocityX, movement.velocityY);
+		lastVelocity = velocity;
+		velocity = velocityVec.getLength();
+
+		omega = movement.omega;
 
-	Math::Vector velocityVec(movement.velocityX, movement.velocityY);
-	lastVelocity = velocity;
-	velocity = velocityVec.getLength();
+		travelledDistance += velocity * dt;
+		travelledRotation += movement.omega * dt;
 
-	omega = movement.omega;
+		frameMovement = movement;
+	}
 
-	travelledDistance += velocity * dt;
-	travelledRotation += movement.omega * dt;
+	frameOdometry = OdometryAccumulator::Delta();
 
 	updateMeasurements();
-	updateBallLocalizer(visionResults, dt);
 	handleQueuedChipKickRequest();
 
 	robotLocalizer->update(measurements);
-	robotLocalizer->move(movement.velocityX, movement.velocityY, movement.omega, dt, measurements.size() == 0 ? true : false);
-	odometerLocalizer->move(movement.velocityX, movement.velocityY, movement.omega, dt);
+	robotLocalizer->move(frameMovement.velocityX, frameMovement.velocityY, frameMovement.omega, dt, measurements.size() == 0 ? true : false);
+	odometerLocalizer->move(frameMovement.velocityX, frameMovement.velocityY, frameMovement.omega, dt);
 
 	Math::Position localizerPosition = robotLocalizer->getPosition();
 	Math::Position odometerPosition = odometerLocalizer->getPosition();
@@ -227,31 +396,31 @@ void Robot::step(float dt, Vision::Results* visionResults) {
     stream << "\"gotBall\":" << (dribbler->gotBall() ? "true" : "false") << ",";
 
     stream << "\"wheelFL\": {";
-	stream << "\"stalled\":" << (wheelFL->isStalled() ? "true" : "false") << ",";
-	stream << "\"targetOmega\":" << wheelFL->getTargetOmega() << ",";
-	stream << "\"filteredTargetOmega\":" << wheelFL->getFilteredTargetOmega() << ",";
-    stream << "\"realOmega\":" << wheelFL->getRealOmega();
+	stream << "\"stalled\":" << (receivedMotion.wheelFL.stalled ? "true" : "false") << ",";
+	stream << "\"targetOmega\":" << receivedMotion.wheelFL.targetOmega << ",";
+	stream << "\"filteredTargetOmega\":" << receivedMotion.wheelFL.filteredTargetOmega << ",";
+    stream << "\"realOmega\":" << receivedMotion.wheelFL.realOmega;
     stream << "},";
 
     stream << "\"wheelFR\": {";
-	stream << "\"stalled\":" << (wheelFR->isStalled() ? "true" : "false") << ",";
-    stream << "\"targetOmega\":" << wheelFR->getTargetOmega() << ",";
-	stream << "\"filteredTargetOmega\":" << wheelFR->getFilteredTargetOmega() << ",";
-    stream << "\"realOmega\":" << wheelFR->getRealOmega();
+	stream << "\"stalled\":" << (receivedMotion.wheelFR.stalled ? "true" : "false") << ",";
+    stream << "\"targetOmega\":" << receivedMotion.wheelFR.targetOmega << ",";
+	stream << "\"filteredTargetOmega\":" << receivedMotion.wheelFR.filteredTargetOmega << ",";
+    stream << "\"realOmega\":" << receivedMotion.wheelFR.realOmega;
     stream << "},";
 
     stream << "\"wheelRL\": {";
-	stream << "\"stalled\":" << (wheelRL->isStalled() ? "true" : "false") << ",";
-    stream << "\"targetOmega\":" << wheelRL->getTargetOmega() << ",";
-	stream << "\"filteredTargetOmega\":" << wheelRL->getFilteredTargetOmega() << ",";
-    stream << "\"realOmega\":" << wheelRL->getRealOmega();
+	stream << "\"stalled\":" << (receivedMotion.wheelRL.stalled ? "true" : "false") << ",";
+    stream << "\"targetOmega\":" << receivedMotion.wheelRL.targetOmega << ",";
+	stream << "\"filteredTargetOmega\":" << receivedMotion.wheelRL.filteredTargetOmega << ",";
+    stream << "\"realOmega\":" << receivedMotion.wheelRL.realOmega;
     stream << "},";
 
     stream << "\"wheelRR\": {";
-	stream << "\"stalled\":" << (wheelRR->isStalled() ? "true" : "false") << ",";
-    stream << "\"targetOmega\":" << wheelRR->getTargetOmega() << ",";
-	stream << "\"filteredTargetOmega\":" << wheelRR->getFilteredTargetOmega() << ",";
-    stream << "\"realOmega\":" << wheelRR->getRealOmega();
+	stream << "\"stalled\":" << (receivedMotion.wheelRR.stalled ? "true" : "false") << ",";
+    stream << "\"targetOmega\":" << receivedMotion.wheelRR.targetOmega << ",";
+	stream << "\"filteredTargetOmega\":" << receivedMotion.wheelRR.filteredTargetOmega << ",";
+    stream << "\"realOmega\":" << receivedMotion.wheelRR.realOmega;
     stream << "},";
 
 	stream << "\"dribbler\": {";
@@ -270,6 +439,23 @@ void Robot::step(float dt, Vision::Results* visionResults) {
 
 	stream << "\"cameraFOV\":" << currentCameraFOV.toJSON() << ",";
 
+	stream << "\"latency\": {";
+	debugLatency("front", stream, frontLatency);
+	stream << ",";
+	debugLatency("rear", stream, rearLatency);
+	stream << "},";
+
+	if (motionThread != NULL) {
+		MotionThread::Stats motionStats = motionThread->getStats();
+
+		stream << "\"motion\": {";
+		stream << "\"rate\":" << motionStats.rate << ",";
+		stream << "\"jitter\":" << motionStats.jitter << ",";
+		stream << "\"maxJitter\":" << motionStats.maxJitter << ",";
+		stream << "\"overruns\":" << motionStats.overrunCount;
+		stream << "},";
+	}
+
 	stream << "\"tasks\": [";
 
     bool first = true;
@@ -294,11 +480,13 @@ void Robot::step(float dt, Vision::Results* visionResults) {
 
 	json = stream.str();
 
+	publishMotion();
+
 	frameTargetSpeedSet = false;
 }
 
-void Robot::updateWheelSpeeds() {
-	Odometer::WheelSpeeds wheelSpeeds = odometer->calculateWheelSpeeds(targetDir.x, targetDir.y, targetOmega);
+void Robot::updateWheelSpeeds(const Math::Vector& dir, float omega) {
+	Odometer::WheelSpeeds wheelSpeeds = odometer->calculateWheelSpeeds(dir.x, dir.y, omega);
 
 	//std::cout << "! Updating wheel speeds: " << wheelSpeeds.FL << ", " << wheelSpeeds.FR << ", " << wheelSpeeds.RL << ", " << wheelSpeeds.RR << std::endl;
 
@@ -323,48 +511,111 @@ void Robot::updateMeasurements() {
 	}
 }
 
-void Robot::updateBallLocalizer(Vision::Results* visionResults, float dt) {
-	// delete balls from previous frame
-	for (BallLocalizer::BallListIt it = visibleBalls.begin(); it != visibleBalls.end(); it++) {
-		delete (*it);
-	}
-
+Vision::Results* Robot::updateBallLocalizer(Vision::Results* visionResults) {
+	// the storage is reused between frames
 	visibleBalls.clear();
 
 	if (visionResults == NULL) {
-		return;
+		return NULL;
 	}
 
-	BallLocalizer::BallList frontBalls;
-	BallLocalizer::BallList rearBalls;
-	
+	double timestamp = 0.0;
+
 	if (visionResults->front != NULL) {
-		frontBalls = ballLocalizer->extractBalls(
+		ballLocalizer->extractBalls(
 			visionResults->front->balls,
 			x,
 			y,
-			orientation
+			orientation,
+			visionResults->front->timestamp,
+			visibleBalls
 		);
+
+		timestamp = visionResults->front->timestamp;
 	}
 
 	if (visionResults->rear != NULL) {
-		rearBalls = ballLocalizer->extractBalls(
+		ballLocalizer->extractBalls(
 			visionResults->rear->balls,
 			x,
 			y,
-			orientation
+			orientation,
+			visionResults->rear->timestamp,
+			visibleBalls
 		);
+
+		if (visionResults->rear->timestamp > timestamp) {
+			timestamp = visionResults->rear->timestamp;
+		}
+	}
+
+	if (timestamp == 0.0) {
+		timestamp = Util::millitime();
 	}
-	
-	visibleBalls.reserve(frontBalls.size() + rearBalls.size());
-	visibleBalls.insert(visibleBalls.end(), frontBalls.begin(), frontBalls.end());
-	visibleBalls.insert(visibleBalls.end(), rearBalls.begin(), rearBalls.end());
 
 	currentCameraFOV = cameraFOV.getRotated(orientation).getTranslated(x, y);
 
-	ballLocalizer->update(visibleBalls, currentCameraFOV, dt);
+	ballLocalizer->update(visibleBalls, currentCameraFOV, timestamp);
+
+	//std::cout << "@ UP visible: " << visibleBalls.size() << ", tracked: " << ballLocalizer->balls.size() << std::endl;
+
+	// the wheel speeds calculated from this frame only take effect after the command latency
+	double commandTime = Util::millitime() + Config::robotCommandLatency;
+	int trackedIndex = 0;
+
+	compensatedResults = *visionResults;
+	compensatedResults.front = compensateBallLatency(visionResults->front, compensatedFront, commandTime, trackedIndex);
+	compensatedResults.rear = compensateBallLatency(visionResults->rear, compensatedRear, commandTime, trackedIndex);
+
+	return &compensatedResults;
+}
+
+// the tracked balls are in the order the balls of the results were extracted in, front first
+Vision::Result* Robot::compensateBallLatency(const Vision::Result* result, Vision::Result& compensated, double commandTime, int& trackedIndex) {
+	if (result == NULL) {
+		return NULL;
+	}
+
+	compensated.reset(result->timestamp, result->frameNumber);
+	compensated.goals = result->goals;
+	compensated.colorOrder = result->colorOrder;
+	compensated.whiteDistance = result->whiteDistance;
+	compensated.blackDistance = result->blackDistance;
+	compensated.vision = result->vision;
+
+	BallLocalizer::Ball* trackedBall;
+	Object* ball;
+
+	for (ObjectListItc it = result->balls.begin(); it != result->balls.end(); it++) {
+		trackedBall = ballLocalizer->getTrackedBall(trackedIndex++);
+		ball = compensated.objects.create(**it);
+
+		if (ball == NULL) {
+			compensated.balls.push_back(*it);
 
-	//std::cout << "@ UP front: " << frontBalls.size() << ", rear: " << rearBalls.size() << ", merged: " << visibleBalls.size() << std::endl;
+			continue;
+		}
+
+		compensated.balls.push_back(ball);
+
+		if (trackedBall == NULL) {
+			continue;
+		}
+
+		Math::Point predicted = trackedBall->getPredictedPosition(commandTime);
+		float globalAngle = atan2(predicted.y - y, predicted.x - x);
+		float angle = Math::getAngleDiff(orientation, globalAngle);
+		float distance = Math::distanceBetween(x, y, predicted.x, predicted.y);
+		float directionSign = ball->behind ? -1.0f : 1.0f;
+
+		// inverse of the angle and distance convention used by vision
+		ball->distance = distance;
+		ball->angle = angle;
+		ball->distanceX = directionSign * distance * Math::sin(angle);
+		ball->distanceY = directionSign * distance * Math::cos(angle);
+	}
+
+	return &compensated;
 }
 
 void Robot::setTargetDir(float x, float y, float omega) {
@@ -372,6 +623,7 @@ void Robot::setTargetDir(float x, float y, float omega) {
 
 	targetDir = Math::Vector(x, y);
 	targetOmega = omega;
+	lookAtActive = false;
 
     lastCommandTime = Util::millitime();
 	frameTargetSpeedSet = true;
@@ -400,10 +652,10 @@ float Robot::getTimeSincLastDroveBehindBall() {
 }
 
 bool Robot::isStalled() {
-	return wheelFL->isStalled()
-		|| wheelFR->isStalled()
-		|| wheelRL->isStalled()
-		|| wheelRR->isStalled();
+	return receivedMotion.wheelFL.stalled
+		|| receivedMotion.wheelFR.stalled
+		|| receivedMotion.wheelRL.stalled
+		|| receivedMotion.wheelRR.stalled;
 }
 
 void Robot::stop() {
@@ -518,13 +770,10 @@ void Robot::lookAt(const Math::Angle& angle, float lookAtP) {
 	// simple P-controller
 	//setTargetOmega(Math::limit(angle.rad() * lookAtP, Math::degToRad(Config::lookAtMaxSpeedAngle) * Config::lookAtP));
 
-	// PID controller
-	lookAtPid.setSetPoint(0.0f);
-	lookAtPid.setProcessValue(angle.deg());
-
-	float targetOmega = lookAtPid.compute();
-
-	setTargetOmega(-targetOmega);
+	// PID controller, stepped by the motion control
+	lookAtAngle = angle.rad();
+	lookAtRotation = receivedMotion.totalRotation;
+	lookAtActive = true;
 
 	/*lookAtPid.setProcessValue(angle.deg());
 
@@ -629,10 +878,14 @@ bool Robot::handleCommand(const Command& cmd) {
 		com->send("charge");
 	}
 
-	if (wheelFL->handleCommand(cmd)) handled = true;
-	if (wheelFR->handleCommand(cmd)) handled = true;
-	if (wheelRL->handleCommand(cmd)) handled = true;
-	if (wheelRR->handleCommand(cmd)) handled = true;
+	{
+		boost::mutex::scoped_lock lock(motionMutex);
+
+		if (wheelFL->handleCommand(cmd)) handled = true;
+		if (wheelFR->handleCommand(cmd)) handled = true;
+		if (wheelRL->handleCommand(cmd)) handled = true;
+		if (wheelRR->handleCommand(cmd)) handled = true;
+	}
 
 	if (dribbler->handleCommand(cmd)) handled = true;
 	if (coilgun->handleCommand(cmd)) handled = true;
@@ -640,14 +893,53 @@ bool Robot::handleCommand(const Command& cmd) {
 	return handled;
 }
 
-void Robot::debugBallList(std::string name, std::stringstream& stream, BallLocalizer::BallList balls) {
-	BallLocalizer::Ball* ball;
+void Robot::resetLatency() {
+	frontLatency = FrameLatency();
+	rearLatency = FrameLatency();
+}
+
+// only counted once for every frame, the results of a camera that did not deliver a new frame are stepped again
+void Robot::updateCommandLatency(FrameLatency& latency, const Vision::Result* result, double time) {
+	if (result == NULL || result->frameNumber == -1 || result->frameNumber == latency.lastFrameNumber) {
+		return;
+	}
+
+	// camera clock offset estimation can put the exposure slightly in the future
+	double commandLatency = Math::max((float)(time - result->timestamp), 0.0f);
+
+	latency.command.add((__int64)(commandLatency * 1000000.0));
+	latency.lastFrameNumber = result->frameNumber;
+	latency.pendingExposure = result->timestamp;
+}
+
+// the first speeds sent after stepping with a frame are the ones that react to it
+void Robot::updateSendLatency(FrameLatency& latency, double time) {
+	if (latency.pendingExposure == 0.0) {
+		return;
+	}
+
+	double sendLatency = Math::max((float)(time - latency.pendingExposure), 0.0f);
+
+	latency.send.add((__int64)(sendLatency * 1000000.0));
+	latency.pendingExposure = 0.0;
+}
+
+// milliseconds
+void Robot::debugLatency(std::string name, std::stringstream& stream, const FrameLatency& latency) {
+	stream << "\"" << name << "\": {";
+	stream << "\"command\":" << latency.command.toJSON(1000.0) << ",";
+	stream << "\"send\":" << latency.send.toJSON(1000.0);
+	stream << "}";
+}
+
+void Robot::debugBallList(std::string name, std::stringstream& stream, const BallLocalizer::BallList& balls) {
+	const BallLocalizer::Ball* ball;
 	bool first = true;
 
 	stream << "\"" << name << "\": [";
 
-	for (BallLocalizer::BallListIt it = balls.begin(); it != balls.end(); it++) {
-		ball = *it;
+	for (BallLocalizer::BallListItc it = balls.begin(); it != balls.end(); it++) {
+		ball = &(*it);
 
 		if (!first) {
             stream << ",";
@@ -6,7 +6,8 @@ SerialCommunication::SerialCommunication(std::string portName, int baud) :
 	portName(portName),
 	baud(baud),
 	serial(portName, baud),
-	receivingMessage(false)
+	framer(Config::serialReceiveBufferSize),
+	scheduler(Config::communicationQueueSize)
 {
 	std::cout << "! Starting communication serial to " << portName << " @ " << baud << std::endl;
 
@@ -31,64 +32,16 @@ SerialCommunication::PortList SerialCommunication::getPortList() {
 }
 
 void SerialCommunication::send(std::string message) {
-	boost::mutex::scoped_lock lock(messagesMutex);
+	// messages added while the port is closed wait in the scheduler, drops are counted in the send stats
+	scheduler.add(message);
+}
 
-	sendQueue.push(message);
+void SerialCommunication::sendFrame(const unsigned char* data, int length) {
+	scheduler.addFrame(data, length);
 }
 
 void SerialCommunication::sync() {
-
-//return;
-
-	boost::mutex::scoped_lock lock(messagesMutex);
-
-	std::string message = "";
-	std::string queuedMessage;
-	int messageCount = sendQueue.size();
-
-	// TODO sends speeds only when the queue is empty
-	/*if (sendQueue.size() == 0 && !speedsSent) {
-		sendQueue.push("speeds:"
-			+ Util::toString(speedFL) + ":"
-			+ Util::toString(speedFR) + ":"
-			+ Util::toString(speedRL) + ":"
-			+ Util::toString(speedRR) + ":"
-			+ Util::toString(speedDribbler)
-		);
-
-		speedsSent = true;
-	}*/
-
-	if (sendQueue.size() == 0) {
-		return;
-	}
-
-	while (sendQueue.size() > 0) {
-		queuedMessage = sendQueue.front();
-
-		sendQueue.pop();
-
-		message += queuedMessage + "\n";
-
-		//if (queuedMessage.substr(0, 6) != "speeds" && queuedMessage.substr(0, 3) != "adc") {
-		//	std::cout << "SEND: " << queuedMessage << " [" << sendQueue.size() << "]" << std::endl;
-		//}
-
-		// TODO only sends one message at a time, remove the break once serial works again
-		//break;
-	}
-
-	if (message.size() >= MAX_SIZE) {
-		std::cout << "- Too big socket message" << std::endl;
-
-		return;
-	}
-
 	if (!serial.isOpen()) {
-		std::cout << "QUEUE " << message << std::endl;
-
-		queuedMessages.push(message);
-
 		return;
 	} else if (serial.errorStatus()) {
 		std::cout << "Error: serial port unexpectedly closed" << std::endl;
@@ -96,60 +49,30 @@ void SerialCommunication::sync() {
 		return;
 	}
 
-	while (!queuedMessages.empty()) {
-		std::cout << "! Socket queue size: " << queuedMessages.size() << std::endl;
-
-		std::string queuedMessage = queuedMessages.front();
-		queuedMessages.pop();
+	// whatever does not fit in the buffer stays pending for the next sync
+	int length = scheduler.flush(requestBuffer, MAX_SIZE, binaryProtocol);
 
-		send(queuedMessage);
+	if (length == 0) {
+		return;
 	}
 
-	/*if (message.substr(0, 6) != "speeds") {
-		std::cout << "SEND > " << message << std::endl;
-	}*/
-
-	//message += "\n";
-
-	//std::cout << "SEND: " << message << " [" << sendQueue.size() << "]" << std::endl;
-
-	memcpy(requestBuffer, message.c_str(), message.size());
-	requestBuffer[message.size()] = 0;
-
 	try {
-		serial.write(requestBuffer, message.size());
+		serial.write((const char*)requestBuffer, length);
 	}
 	catch (std::exception& e) {
 		std::cout << "- SerialCommunication send error: " << e.what() << std::endl;
 	}
 }
 
-bool SerialCommunication::gotMessages() {
-	boost::mutex::scoped_lock lock(messagesMutex);
-
-	return messages.size() > 0;
-}
-
-std::string SerialCommunication::dequeueMessage() {
-	boost::mutex::scoped_lock lock(messagesMutex);
+AbstractCommunication::SendStats SerialCommunication::getSendStats() const {
+	SendStats stats;
 
-	int messageCount = messages.size();
+	stats.pending = scheduler.getPendingCount();
+	stats.coalesced = scheduler.getCoalescedCount();
+	stats.dropped = scheduler.getDroppedCount();
+	stats.datagrams = scheduler.getDatagramCount();
 
-	if (messageCount == 0) {
-		//std::cout << "R [" << messageCount << "]" << std::endl;
-
-		return "";
-	}
-
-	std::string message = messages.front();
-
-	messages.pop();
-
-	//if (message.substr(0, 7) != "<speeds" && message.substr(0, 4) != "<adc") {
-	//	std::cout << "RECV: '" << message << "' [" << (messageCount - 1) << "]" << std::endl;
-	//}
-
-	return message;
+	return stats;
 }
 
 void SerialCommunication::close() {
@@ -168,50 +91,5 @@ void* SerialCommunication::run() {
 }
 
 void SerialCommunication::received(const char *data, unsigned int len) {
-	std::vector<char> v(data, data + len);
-
-	for (unsigned int i = 0; i<v.size(); i++) {
-		if (v[i] == '\n') {
-			
-		} else {
-			if (v[i] == '<') {
-				if (receivingMessage) {
-					std::cout << "@ GOT '<' BUT WAS ALREADY RECEIVING MESSAGE, THIS SHOULD NOT HAPPEN" << std::endl;
-				}
-
-				receivingMessage = true;
-			}
-
-			if (receivingMessage) {
-				partialMessage += v[i];
-			} else {
-				std::cout << "# '" << v[i] << std::endl;
-			}
-
-			if (v[i] == '>') {
-				if (!receivingMessage) {
-					std::cout << "@ GOT '>' BUT WAS NOT RECEIVING MESSAGE, THIS SHOULD NOT HAPPEN" << std::endl;
-				}
-
-				receivingMessage = false;
-
-				if (partialMessage.size() > 0) {
-					boost::mutex::scoped_lock lock(messagesMutex);
-
-					messages.push(partialMessage);
-
-					//std::cout << "C < " << partialMessage << " [" << messages.size() << "]" << std::endl;
-
-					partialMessage = "";
-				}
-				else {
-					std::cout << "@ GOT '<' BUT PARTIAL MESSAGE WAS EMPTY, THIS SHOULD NOT HAPPEN" << std::endl;
-				}
-			}
-		}
-	}
-
-	/*if (partialMessage.size() > 0) {
-		std::cout << "P < " << partialMessage << std::endl;
-	}*/
-}
\ No newline at end of file
+	receiveBytes(framer, data, (int)len);
+}
@@ -1,8 +1,9 @@
 #include "Server.h"
+#include "Config.h"
 
 #include <iostream>
 
-Server::Server() : ws(NULL) {
+Server::Server() : ws(NULL), messages(Config::serverQueueSize) {
 	ws = new WebSocketServer();
 	ws->addListener(this);
 
@@ -28,15 +29,6 @@ Server::~Server() {
 
 	clients.clear();
 
-	Message* message;
-
-	while (messages.size() > 0) {
-		message = messages.front();
-		messages.pop();
-
-		delete message;
-	}
-
 	if (ws != NULL) delete ws; ws = NULL;
 }
 
@@ -58,26 +50,6 @@ void Server::close() {
 	}
 }
 
-bool Server::gotMessages() {
-	boost::mutex::scoped_lock lock(messagesMutex);
-
-	return messages.size() > 0;
-}
-
-Server::Message* Server::dequeueMessage() {
-	boost::mutex::scoped_lock lock(messagesMutex);
-	
-	if (messages.size() == 0) {
-		return NULL;
-	}
-
-	Message* message = messages.front();
-
-	messages.pop();
-
-	return message;
-}
-
 Server::Client* Server::getClientByConnection(websocketpp::connection_hdl connection) {
 	int id;
 	Client* client;
@@ -145,8 +117,13 @@ void Server::onSocketMessage(std::string message, websocketpp::connection_hdl co
 		return;
 	}
 
-	boost::mutex::scoped_lock lock(messagesMutex);
-	messages.push(new Message(client, this, message));
+	receivedMessage.client = client;
+	receivedMessage.server = this;
+	receivedMessage.content.swap(message);
+
+	if (!messages.push(receivedMessage)) {
+		std::cout << "- Server message queue full, dropped message from client #" << client->id << std::endl;
+	}
 	
 	//std::cout << "! Server client #" << client->id << " sent message: " << message << std::endl;
 }
\ No newline at end of file
@@ -9,7 +9,14 @@
 #include "SerialCommunication.h"
 #include "ComPortCommunication.h"
 #include "DummyCommunication.h"
+#include "FirmwareStub.h"
+#include "FrameStreamer.h"
+#include "StatePublisher.h"
+#include "Recorder.h"
+#include "Replayer.h"
+#include "Profiler.h"
 #include "ProcessThread.h"
+#include "CaptureThread.h"
 #include "Gui.h"
 #include "FpsCounter.h"
 #include "SignalHandler.h"
@@ -17,6 +24,7 @@
 #include "Util.h"
 #include "Robot.h"
 #include "Dribbler.h"
+#include "ParticleFilterLocalizer.h"
 #include "Wheel.h"
 #include "ManualController.h"
 #include "TestController.h"
@@ -26,17 +34,23 @@
 #include <iostream>
 #include <algorithm>
 
+#include <boost/bind.hpp>
+
 SoccerBot::SoccerBot() :
 	frontCamera(NULL), rearCamera(NULL),
 	ximeaFrontCamera(NULL), ximeaRearCamera(NULL),
 	virtualFrontCamera(NULL), virtualRearCamera(NULL),
+	replayFrontCamera(NULL), replayRearCamera(NULL),
 	frontBlobber(NULL), rearBlobber(NULL),
 	frontVision(NULL), rearVision(NULL),
 	frontProcessor(NULL), rearProcessor(NULL),
+	frontCapture(NULL), rearCapture(NULL),
 	frontCameraTranslator(NULL), rearCameraTranslator(NULL),
-	gui(NULL), fpsCounter(NULL), visionResults(NULL), robot(NULL), activeController(NULL), server(NULL), com(NULL),
-	jpegBuffer(NULL), screenshotBufferFront(NULL), screenshotBufferRear(NULL),
-	running(false), debugVision(false), showGui(false), controllerRequested(false), stateRequested(false), frameRequested(false), useScreenshot(false),
+	gui(NULL), fpsCounter(NULL), visionResults(NULL), robot(NULL), activeController(NULL), server(NULL), frameStreamer(NULL), statePublisher(NULL), com(NULL), firmwareStub(NULL),
+	recorder(NULL), replayer(NULL), replayCommunication(NULL),
+	screenshotBufferFront(NULL), screenshotBufferRear(NULL),
+	communicationMessages(NULL), serverMessages(NULL), activeMessage(NULL),
+	running(false), debugVision(false), showGui(false), useFirmwareStub(false), replayRealtime(false), controllerRequested(false), stateRequested(false), useScreenshot(false),
 	dt(0.01666f), lastStepTime(0.0), totalTime(0.0f),
 	debugCameraDir(Dir::FRONT)
 {
@@ -54,24 +68,41 @@ SoccerBot::~SoccerBot() {
     activeController = NULL;
 
 	if (gui != NULL) delete gui; gui = NULL;
+	if (frameStreamer != NULL) delete frameStreamer; frameStreamer = NULL;
+	if (statePublisher != NULL) delete statePublisher; statePublisher = NULL;
 	if (server != NULL) delete server; server = NULL;
+
+	// the robot listens on the communication thread, it has to stop before the listeners are freed
+	if (com != NULL) {
+		com->close();
+		com->join();
+	}
+
 	if (robot != NULL) delete robot; robot = NULL;
+	if (frontProcessor != NULL) frontBlobber->saveOptions(Config::blobberConfigFilename); delete frontProcessor; frontProcessor = NULL;
+	if (rearProcessor != NULL) delete rearProcessor; rearProcessor = NULL;
+	if (frontCapture != NULL) delete frontCapture; frontCapture = NULL;
+	if (rearCapture != NULL) delete rearCapture; rearCapture = NULL;
 	if (ximeaFrontCamera != NULL) delete ximeaFrontCamera; ximeaFrontCamera = NULL;
 	if (ximeaRearCamera != NULL) delete ximeaRearCamera; ximeaRearCamera = NULL;
 	if (virtualFrontCamera != NULL) delete virtualFrontCamera; virtualFrontCamera = NULL;
 	if (virtualRearCamera != NULL) delete virtualRearCamera; virtualRearCamera = NULL;
+	if (replayFrontCamera != NULL) delete replayFrontCamera; replayFrontCamera = NULL;
+	if (replayRearCamera != NULL) delete replayRearCamera; replayRearCamera = NULL;
 	if (frontCameraTranslator != NULL) delete frontCameraTranslator; frontCameraTranslator = NULL;
 	if (rearCameraTranslator != NULL) delete rearCameraTranslator; rearCameraTranslator = NULL;
 	if (fpsCounter != NULL) delete fpsCounter; fpsCounter = NULL;
-	if (frontProcessor != NULL) frontBlobber->saveOptions(Config::blobberConfigFilename); delete frontProcessor; frontProcessor = NULL;
-	if (rearProcessor != NULL) delete rearProcessor; rearProcessor = NULL;
 	if (visionResults != NULL) delete visionResults; visionResults = NULL;
 	if (frontVision != NULL) delete frontVision; frontVision = NULL;
 	if (rearVision != NULL) delete rearVision; rearVision = NULL;
 	if (frontBlobber != NULL) delete frontBlobber; frontBlobber = NULL;
 	if (rearBlobber != NULL) delete rearBlobber; rearBlobber = NULL;
 	if (com != NULL) delete com; com = NULL;
-	if (jpegBuffer != NULL) delete jpegBuffer; jpegBuffer = NULL;
+	if (firmwareStub != NULL) delete firmwareStub; firmwareStub = NULL;
+	if (recorder != NULL) delete recorder; recorder = NULL;
+	if (replayer != NULL) delete replayer; replayer = NULL;
+	if (communicationMessages != NULL) delete[] communicationMessages; communicationMessages = NULL;
+	if (serverMessages != NULL) delete[] serverMessages; serverMessages = NULL;
 
 	frontCamera = NULL;
 	rearCamera = NULL;
@@ -80,6 +111,10 @@ SoccerBot::~SoccerBot() {
 }
 
 void SoccerBot::setup() {
+	communicationMessages = new std::string[Config::messageBatchSize];
+	serverMessages = new Server::Message[Config::messageBatchSize];
+
+	setupRecording();
 	setupCommunication();
 	setupVision();
 	setupFpsCounter();
@@ -87,6 +122,7 @@ void SoccerBot::setup() {
 	setupProcessors();
 	setupRobot();
 	setupControllers();
+	setupCommands();
 	setupSignalHandler();
 	setupServer();
 
@@ -98,21 +134,37 @@ void SoccerBot::setup() {
 void SoccerBot::run() {
 	std::cout << "! Starting main loop" << std::endl;
 
+	if (!replayFilename.empty() && replayer == NULL) {
+		std::cout << "- Nothing to replay, not starting the main loop" << std::endl;
+
+		return;
+	}
+
 	running = true;
 
 	com->start();
 	server->start();
+	frameStreamer->start();
+	statePublisher->start();
 
-	com->send("reset");
+	com->sendReset();
 
 	setController(Config::defaultController);
 
 	if (frontCamera->isOpened()) {
 		frontCamera->startAcquisition();
+
+		if (frontCapture != NULL) {
+			frontCapture->start();
+		}
 	}
 
 	if (rearCamera->isOpened()) {
 		rearCamera->startAcquisition();
+
+		if (rearCapture != NULL) {
+			rearCapture->start();
+		}
 	}
 
 	if (!frontCamera->isOpened() && !rearCamera->isOpened()) {
@@ -129,21 +181,47 @@ void SoccerBot::run() {
 		return;
 	}
 
+	// a replay steps the motion control with the recorded time instead
+	if (replayer == NULL) {
+		robot->startMotionThread();
+	}
+
 	//bool gotFrontFrame, gotRearFrame;
 	double time;
 	double debugging;
+	bool frameWanted;
+	FrameStreamer::Request frameRequest;
+	Replayer::Step replayStep;
+	float motionPeriod = 1.0f / Config::motionControlFrequency;
+	float motionTime = 0.0f;
+
+	Profiler::measureOverhead();
 
 	while (running) {
-		//__int64 startTime = Util::timerStart();
+		Profiler::Scope frameScope(Profiler::FRAME_ZONE);
+
+		if (replayer != NULL) {
+			if (!replayer->next(replayStep, replayFrontCamera, replayRearCamera, replayCommunication)) {
+				std::cout << "! Reached the end of the replay" << std::endl;
+
+				break;
+			}
+		}
 
 		time = Util::millitime();
 
-		if (lastStepTime != 0.0) {
+		if (replayer != NULL) {
+			dt = replayStep.dt;
+		} else if (lastStepTime != 0.0) {
 			dt = (float)(time - lastStepTime);
 		} else {
 			dt = 1.0f / 60.0f;
 		}
 
+		if (recorder != NULL) {
+			recorder->recordStep(dt, time);
+		}
+
 		/*if (dt > 0.04f) {
 			std::cout << "@ LARGE DT: " << dt << std::endl;
 		}*/
@@ -151,7 +229,10 @@ void SoccerBot::run() {
 		totalTime += dt;
 
 		//gotFrontFrame = gotRearFrame = false;
-		debugging = frontProcessor->debug = rearProcessor->debug = debugVision || showGui || frameRequested;
+		frameRequest = frameStreamer->getRequest();
+		frameWanted = frameRequest.wanted;
+		debugging = frontProcessor->debug = rearProcessor->debug = debugVision || showGui || frameWanted;
+		frontProcessor->classify = rearProcessor->classify = debugVision || showGui || frameRequest.formats[FrameStreamer::JPEG_CLASSIFICATION];
 
 		/*gotFrontFrame = fetchFrame(frontCamera, frontProcessor);
 		gotRearFrame = fetchFrame(rearCamera, rearProcessor);
@@ -182,6 +263,16 @@ void SoccerBot::run() {
 			visionResults->rear = rearProcessor->visionResult;
 		//}
 
+		if (recorder != NULL) {
+			if (frontProcessor->gotFrame) {
+				recorder->recordFrame(Dir::FRONT, frontProcessor->frame, frontProcessor->frameNumber, frontProcessor->frameTimestamp);
+			}
+
+			if (rearProcessor->gotFrame) {
+				recorder->recordFrame(Dir::REAR, rearProcessor->frame, rearProcessor->frameNumber, rearProcessor->frameTimestamp);
+			}
+		}
+
 		// update goal path obstruction metric
 		Side targetSide = activeController->getTargetSide();
 		Object* targetGoal = visionResults->getLargestGoal(targetSide, Dir::FRONT);
@@ -226,15 +317,10 @@ void SoccerBot::run() {
 			//DebugRenderer::highlightObject(
 		}
 
-		if (frameRequested) {
-			// TODO Add camera choice
-			if (debugCameraDir == Dir::FRONT) {
-				broadcastFrame(frontProcessor->rgb, frontProcessor->classification);
-			} else {
-				broadcastFrame(rearProcessor->rgb, rearProcessor->classification);
-			}
+		if (frameWanted) {
+			ProcessThread* debugProcessor = debugCameraDir == Dir::FRONT ? frontProcessor : rearProcessor;
 
-			frameRequested = false;
+			frameStreamer->submit(frameRequest, debugProcessor->rgb, debugProcessor->classification, debugProcessor->blobber, fpsCounter->frameNumber, debugCameraDir, activeStreamName);
 		}
 
 		if (showGui) {
@@ -273,19 +359,53 @@ void SoccerBot::run() {
 			std::cout << "! FPS: " << fpsCounter->getFps() << std::endl;
 		}*/
 
-		handleServerMessages();
-		handleCommunicationMessages();
+		{
+			Profiler::Scope scope(Profiler::SERVER_ZONE);
 
-		if (activeController != NULL) {
-			activeController->step(dt, visionResults);
-		}
+			handleServerMessages();
+
+			scope.next(Profiler::COMMUNICATION_ZONE);
+
+			handleCommunicationMessages();
+
+			scope.next(Profiler::CONTROLLER_ZONE);
 
-		robot->step(dt, visionResults);
+			// the motion control keeps stepping meanwhile, take what it measured since the last frame
+			robot->receiveMotion();
 
-		if (server != NULL && stateRequested) {
-			server->broadcast(Util::json("state", getStateJSON()));
+			// localize the balls and predict them to when the resulting commands take effect
+			Vision::Results* compensatedResults = robot->updateBallLocalizer(visionResults);
 
-			stateRequested = false;
+			if (activeController != NULL) {
+				activeController->step(dt, compensatedResults);
+			}
+
+			scope.next(Profiler::ROBOT_ZONE);
+
+			robot->step(dt, compensatedResults);
+
+			if (replayer != NULL) {
+				scope.next(Profiler::MOTION_ZONE);
+
+				for (motionTime += dt; motionTime >= motionPeriod; motionTime -= motionPeriod) {
+					robot->stepMotion(motionPeriod);
+				}
+			}
+
+			scope.next(Profiler::STATE_ZONE);
+
+			if (server != NULL && stateRequested) {
+				server->broadcast(Util::json("state", getStateJSON()));
+
+				stateRequested = false;
+			}
+
+			// the publisher skips the frame rather than making the loop wait for it
+			if (statePublisher->isWanted()) {
+				stateJson = getStateJSON();
+
+				statePublisher->publish(stateJson);
+			}
 		}
 
 		lastStepTime = time;
@@ -294,12 +414,27 @@ void SoccerBot::run() {
 			running = false;
 		}
 
-		//std::cout << "! Total time: " << Util::timerEnd(startTime) << std::endl;
+		frameScope.end();
+
+		Profiler::collect();
 
 		//std::cout << "FRAME" << std::endl;
 	}
 
-	com->send("reset");
+	robot->stopMotionThread();
+
+	// a ball arriving on the communication thread must not fire an armed kick during the shutdown
+	robot->coilgun->cancelKickOnceGotBall(true);
+
+	com->sendReset();
+
+	if (recorder != NULL) {
+		recorder->close();
+	}
+
+	if (replayer != NULL) {
+		replayer->close();
+	}
 
 	std::cout << "! Main loop ended" << std::endl;
 }
@@ -328,37 +463,6 @@ void SoccerBot::run() {
 	return false;
 }*/
 
-void SoccerBot::broadcastFrame(unsigned char* rgb, unsigned char* classification) {
-	int jpegBufferSize = Config::jpegBufferSize;
-
-	if (jpegBuffer == NULL) {
-		std::cout << "! Creating frame JPEG buffer of " << jpegBufferSize << " bytes.. ";
-        jpegBuffer = new unsigned char[Config::jpegBufferSize];
-		std::cout << "done!" << std::endl;
-    }
-
-	if (!ImageProcessor::rgbToJpeg(rgb, jpegBuffer, jpegBufferSize, Config::cameraWidth, Config::cameraHeight)) {
-		std::cout << "- Converting RGB image to JPEG failed, probably need to increase buffer size" << std::endl;
-
-		return;
-	}
-
-	std::string base64Rgb = Util::base64Encode(jpegBuffer, jpegBufferSize);
-
-	jpegBufferSize = Config::jpegBufferSize;
-
-	if (!ImageProcessor::rgbToJpeg(classification, jpegBuffer, jpegBufferSize, Config::cameraWidth, Config::cameraHeight)) {
-		std::cout << "- Converting classification image to JPEG failed, probably need to increase buffer size" << std::endl;
-
-		return;
-	}
-
-	std::string base64Classification = Util::base64Encode(jpegBuffer, jpegBufferSize);
-	std::string frameResponse = Util::json("frame", "{\"rgb\": \"" + base64Rgb + "\",\"classification\": \"" + base64Classification + "\",\"activeStream\":\"" + activeStreamName + "\"}");
-
-	server->broadcast(frameResponse);
-}
-
 void SoccerBot::broadcastScreenshots() {
 	std::vector<std::string> screenshotFiles = Util::getFilesInDir(Config::screenshotsDirectory);
 	std::vector<std::string> screenshotNames;
@@ -406,82 +510,26 @@ void SoccerBot::setupVision() {
 	frontCameraTranslator = new CameraTranslator();
 	rearCameraTranslator = new CameraTranslator();
 
-
-	//float A = 290.0f;
-	//float B = -0.04f;
-	//float C = 0.20689130201672276f;
-	//float horizon = -300.0f;
-	float A = 120.11218157847301f;
-	float B = -0.037205566171594123f;
-	float C = 0.2124259596292023f;
-	float horizon = 119.40878f;
-
-	// TODO these are not actually currently used any more, remove at some point
-	float k1 = -0.28f;
-	float k2 = 0.07f;
-	float k3 = -0.0075f;
-	float distortionFocus = 6.904681785333543758e+02f;
-
-	// TODO Add to config or load from file
 	frontCameraTranslator->setConstants(
-		A, B, C,
-		k1, k2, k3,
-		horizon, distortionFocus,
+		Config::frontCameraA, Config::frontCameraB, Config::frontCameraC,
+		Config::cameraDistortionK1, Config::cameraDistortionK2, Config::cameraDistortionK3,
+		Config::frontCameraHorizon, Config::cameraDistortionFocus,
 		Config::cameraWidth, Config::cameraHeight
 	);
 
-	// rear parameters
-	A = 116.87509670118826f;
-	B = -0.024224799830663904f;
-	C = 0.20843106680747164f;
-	horizon = 123.73853f;
-
 	rearCameraTranslator->setConstants(
-		A, B, C,
-		k1, k2, k3,
-		horizon, distortionFocus,
+		Config::rearCameraA, Config::rearCameraB, Config::rearCameraC,
+		Config::cameraDistortionK1, Config::cameraDistortionK2, Config::cameraDistortionK3,
+		Config::rearCameraHorizon, Config::cameraDistortionFocus,
 		Config::cameraWidth, Config::cameraHeight
 	);
 
-	std::cout << "  > loading front camera distortion mappings.. ";
-	frontCameraTranslator->loadDistortionMapping(
-		Config::distortMappingFilenameFrontX,
-		Config::distortMappingFilenameFrontY
-	);
+	std::cout << "  > loading front camera mappings.. ";
+	frontCameraTranslator->loadMappings(Config::distortMappingFilenameFrontX, Config::distortMappingFilenameFrontY);
 	std::cout << "done!" << std::endl;
 
-	/*std::cout << "  > loading front camera undistorion mappings.. ";
-	frontCameraTranslator->loadUndistortionMapping(
-	Config::undistortMappingFilenameFrontX,
-	Config::undistortMappingFilenameFrontY
-	);
-	std::cout << "done!" << std::endl;*/
-
-	std::cout << "  > generating front camera undistortion mappings.. ";
-	CameraTranslator::CameraMapSet mapSet = frontCameraTranslator->generateInverseMap(frontCameraTranslator->distortMapX, frontCameraTranslator->distortMapY);
-	frontCameraTranslator->undistortMapX = mapSet.x;
-	frontCameraTranslator->undistortMapY = mapSet.y;
-	std::cout << "done!" << std::endl;
-	
-
-	std::cout << "  > loading rear camera distortion mappings.. ";
-	rearCameraTranslator->loadDistortionMapping(
-		Config::distortMappingFilenameRearX,
-		Config::distortMappingFilenameRearY
-	);
-	std::cout << "done!" << std::endl;
-
-	/*std::cout << "  > loading rear camera undistorion mappings.. ";
-	rearCameraTranslator->loadUndistortionMapping(
-	Config::undistortMappingFilenameRearX,
-	Config::undistortMappingFilenameRearY
-	);
-	std::cout << "done!" << std::endl;*/
-
-	std::cout << "  > generating rear camera undistortion mappings.. ";
-	mapSet = rearCameraTranslator->generateInverseMap(rearCameraTranslator->distortMapX, rearCameraTranslator->distortMapY);
-	rearCameraTranslator->undistortMapX = mapSet.x;
-	rearCameraTranslator->undistortMapY = mapSet.y;
+	std::cout << "  > loading rear camera mappings.. ";
+	rearCameraTranslator->loadMappings(Config::distortMappingFilenameRearX, Config::distortMappingFilenameRearY);
 	std::cout << "done!" << std::endl;
 
 	frontVision = new Vision(frontBlobber, frontCameraTranslator, Dir::FRONT, Config::cameraWidth, Config::cameraHeight);
@@ -493,8 +541,14 @@ void SoccerBot::setupVision() {
 void SoccerBot::setupProcessors() {
 	std::cout << "! Setting up processor threads.. ";
 
-	frontProcessor = new ProcessThread(frontCamera, frontBlobber, frontVision);
-	rearProcessor = new ProcessThread(rearCamera, rearBlobber, rearVision);
+	// the replay serves the recorded frames in step with the main loop
+	if (replayFilename.empty()) {
+		frontCapture = new CaptureThread(frontCamera, Config::cameraWidth, Config::cameraHeight);
+		rearCapture = new CaptureThread(rearCamera, Config::cameraWidth, Config::cameraHeight);
+	}
+
+	frontProcessor = new ProcessThread(frontCamera, frontBlobber, frontVision, frontCapture);
+	rearProcessor = new ProcessThread(rearCamera, rearBlobber, rearVision, rearCapture);
 
 	std::cout << "done!" << std::endl;
 }
@@ -523,6 +577,20 @@ void SoccerBot::setupCameras() {
 
 	ximeaFrontCamera = new XimeaCamera();
 	ximeaRearCamera = new XimeaCamera();
+	virtualFrontCamera = new VirtualCamera();
+	virtualRearCamera = new VirtualCamera();
+
+	if (!replayFilename.empty()) {
+		std::cout << "! Using replayed camera frames" << std::endl;
+
+		replayFrontCamera = new VirtualCamera();
+		replayRearCamera = new VirtualCamera();
+
+		frontCamera = replayFrontCamera;
+		rearCamera = replayRearCamera;
+
+		return;
+	}
 
 	ximeaFrontCamera->open(Config::frontCameraSerial);
 	ximeaRearCamera->open(Config::rearCameraSerial);
@@ -543,9 +611,6 @@ void SoccerBot::setupCameras() {
 		std::cout << "! Neither of the cameras could be opened" << std::endl;
 	}
 
-	virtualFrontCamera = new VirtualCamera();
-	virtualRearCamera = new VirtualCamera();
-
 	frontCamera = ximeaFrontCamera;
 	rearCamera = ximeaRearCamera;
 }
@@ -556,6 +621,33 @@ void SoccerBot::setupRobot() {
 	robot->setup();
 }
 
+void SoccerBot::setupCommands() {
+	commands.add("get-controller", "*", boost::bind(&SoccerBot::handleGetControllerCommand, this));
+	commands.add("set-controller", "s", boost::bind(&SoccerBot::handleSetControllerCommand, this, _1));
+	commands.add("get-state", "*", boost::bind(&SoccerBot::handleGetStateCommand, this));
+	commands.add("subscribe", "s", boost::bind(&SoccerBot::handleSubscribeCommand, this, _1));
+	commands.add("subscribe", "si", boost::bind(&SoccerBot::handleSubscribeCommand, this, _1));
+	commands.add("get-profile", "", boost::bind(&SoccerBot::handleGetProfileCommand, this, _1));
+	commands.add("get-profile", "s", boost::bind(&SoccerBot::handleGetProfileCommand, this, _1));
+	commands.add("profile-trace", "", boost::bind(&SoccerBot::handleProfileTraceCommand, this, _1));
+	commands.add("profile-trace", "f", boost::bind(&SoccerBot::handleProfileTraceCommand, this, _1));
+	commands.add("profile-trace", "fs", boost::bind(&SoccerBot::handleProfileTraceCommand, this, _1));
+	commands.add("reset-latency", "*", boost::bind(&SoccerBot::handleResetLatencyCommand, this));
+	commands.add("get-frame", "*", boost::bind(&SoccerBot::handleGetFrameCommand, this));
+	commands.add("stream-frames", "", boost::bind(&SoccerBot::handleStreamFramesCommand, this, _1));
+	commands.add("stream-frames", "i", boost::bind(&SoccerBot::handleStreamFramesCommand, this, _1));
+	commands.add("stream-frames", "is", boost::bind(&SoccerBot::handleStreamFramesCommand, this, _1));
+	commands.add("camera-choice", "i", boost::bind(&SoccerBot::handleCameraChoiceCommand, this, _1));
+	commands.add("camera-adjust", "ff", boost::bind(&SoccerBot::handleCameraAdjustCommand, this, _1));
+	commands.add("stream-choice", "s", boost::bind(&SoccerBot::handleStreamChoiceCommand, this, _1));
+	commands.add("blobber-threshold", "siiiif", boost::bind(&SoccerBot::handleBlobberThresholdCommand, this, _1));
+	commands.add("blobber-clear", "", boost::bind(&SoccerBot::handleBlobberClearCommand, this, _1));
+	commands.add("blobber-clear", "s", boost::bind(&SoccerBot::handleBlobberClearCommand, this, _1));
+	commands.add("screenshot", "s", boost::bind(&SoccerBot::handleScreenshotCommand, this, _1));
+	commands.add("list-screenshots", "*", boost::bind(&SoccerBot::handleListScreenshotsCommand, this));
+	commands.add("camera-translator", "ffffffff", boost::bind(&SoccerBot::handleCameraTranslatorCommand, this, _1));
+}
+
 void SoccerBot::setupControllers() {
 	std::cout << "! Setting up controllers.. ";
 
@@ -594,9 +686,53 @@ void SoccerBot::setupSignalHandler() {
 
 void SoccerBot::setupServer() {
 	server = new Server();
+	frameStreamer = new FrameStreamer(server, Config::cameraWidth, Config::cameraHeight);
+	statePublisher = new StatePublisher(server);
+}
+
+void SoccerBot::setupRecording() {
+	if (!replayFilename.empty()) {
+		replayer = new Replayer();
+		replayer->setRealtime(replayRealtime);
+
+		if (!replayer->open(replayFilename)) {
+			delete replayer;
+			replayer = NULL;
+		}
+	}
+
+	if (!recordFilename.empty()) {
+		recorder = new Recorder(Config::cameraWidth, Config::cameraHeight);
+
+		if (!recorder->open(recordFilename)) {
+			delete recorder;
+			recorder = NULL;
+		}
+	}
 }
 
 void SoccerBot::setupCommunication() {
+	if (!replayFilename.empty()) {
+		std::cout << "! Using replayed communication" << std::endl;
+
+		com = replayCommunication = new DummyCommunication();
+
+		return;
+	}
+
+	if (useFirmwareStub) {
+		std::cout << "! Using local firmware stub over ethernet" << std::endl;
+
+		firmwareStub = new FirmwareStub(Config::firmwareStubPort);
+		firmwareStub->setDelay(Config::firmwareStubDelay);
+		firmwareStub->setLoss(Config::firmwareStubLoss);
+		firmwareStub->start();
+
+		com = new EthernetCommunication("127.0.0.1", Config::firmwareStubPort, Config::communicationPort);
+
+		return;
+	}
+
 	try {
 		switch (Config::communicationMode) {
 			case Config::ETHERNET:
@@ -735,14 +871,14 @@ std::string SoccerBot::getActiveControllerName() {
 }
 
 void SoccerBot::handleServerMessages() {
-	Server::Message* message;
+	int messageCount;
 
 	//std::cout << "! Handling server messages.. ";
 
-	while ((message = server->dequeueMessage()) != NULL) {
-		handleServerMessage(message);
-
-		delete message;
+	while ((messageCount = server->dequeueMessages(serverMessages, Config::messageBatchSize)) > 0) {
+		for (int i = 0; i < messageCount; i++) {
+			handleServerMessage(&serverMessages[i]);
+		}
 	}
 
 	//std::cout << "done!" << std::endl;
@@ -751,55 +887,37 @@ void SoccerBot::handleServerMessages() {
 void SoccerBot::handleServerMessage(Server::Message* message) {
 	//std::cout << "! Request from " << message->client->id << ": " << message->content << std::endl;
 
-	if (Command::isValid(message->content)) {
-        Command command = Command::parse(message->content);
-
-        if (
-			activeController == NULL
-			|| (!activeController->handleCommand(command) && !activeController->handleRequest(message->content))
-		) {
-			if (command.name == "get-controller") {
-				handleGetControllerCommand(message);
-			} else if (command.name == "set-controller" && command.parameters.size() == 1) {
-				handleSetControllerCommand(command.parameters, message);
-			} else if (command.name == "get-state") {
-				handleGetStateCommand();
-			} else if (command.name == "get-frame") {
-				handleGetFrameCommand();
-			} else if (command.name == "camera-choice" && command.parameters.size() == 1) {
-                handleCameraChoiceCommand(command.parameters);
-            } else if (command.name == "camera-adjust" && command.parameters.size() == 2) {
-                handleCameraAdjustCommand(command.parameters);
-            } else if (command.name == "stream-choice" && command.parameters.size() == 1) {
-                handleStreamChoiceCommand(command.parameters);
-            } else if (command.name == "blobber-threshold" && command.parameters.size() == 6) {
-                handleBlobberThresholdCommand(command.parameters);
-            } else if (command.name == "blobber-clear" && (command.parameters.size() == 0 || command.parameters.size() == 1)) {
-                handleBlobberClearCommand(command.parameters);
-            } else if (command.name == "screenshot" && command.parameters.size() == 1) {
-                handleScreenshotCommand(command.parameters);
-            } else if (command.name == "list-screenshots") {
-                handleListScreenshotsCommand(message);
-			} else if (command.name == "camera-translator") {
-				handleCameraTranslatorCommand(command.parameters);
-			}
-			else {
-				std::cout << "- Unsupported command: " << command.name << " " << Util::toString(command.parameters) << std::endl;
-			}
-		}
-	} else {
+	if (!Command::isValid(message->content.c_str(), (int)message->content.size())) {
 		std::cout << "- Message '" << message->content << "' is not a valid command" << std::endl;
+
+		return;
 	}
+
+	Command::View command;
+
+	Command::tokenize(message->content.c_str(), (int)message->content.size(), command);
+
+	if (activeController != NULL && (activeController->handleCommand(command) || activeController->handleRequest(message->content))) {
+		return;
+	}
+
+	activeMessage = message;
+
+	if (!commands.dispatch(command)) {
+		std::cout << "- Unsupported command: " << message->content << std::endl;
+	}
+
+	activeMessage = NULL;
 }
 
-void SoccerBot::handleGetControllerCommand(Server::Message* message) {
-	std::cout << "! Client #" << message->client->id << " requested controller, sending: " << activeControllerName << std::endl;
+void SoccerBot::handleGetControllerCommand() {
+	std::cout << "! Client #" << activeMessage->client->id << " requested controller, sending: " << activeControllerName << std::endl;
 
-	message->respond(Util::json("controller", activeControllerName));
+	activeMessage->respond(Util::json("controller", activeControllerName));
 }
 
-void SoccerBot::handleSetControllerCommand(Command::Parameters parameters, Server::Message* message) {
-	std::string name = parameters[0];
+void SoccerBot::handleSetControllerCommand(const CommandDispatcher::Arguments& args) {
+	std::string name = args.getString(0);
 
 	if (setController(name)) {
 		std::cout << "+ Changed controller to: '" << name << "'" << std::endl;
@@ -807,41 +925,86 @@ void SoccerBot::handleSetControllerCommand(Command::Parameters parameters, Serve
 		std::cout << "- Failed setting controller to '" << name << "'" << std::endl;
 	}
 
-	message->respond(Util::json("controller", activeControllerName));
+	activeMessage->respond(Util::json("controller", activeControllerName));
 }
 
 void SoccerBot::handleGetStateCommand() {
 	stateRequested = true;
 }
 
+void SoccerBot::handleSubscribeCommand(const CommandDispatcher::Arguments& args) {
+	std::string topicName = args.getString(0);
+	StatePublisher::Topic topic = StatePublisher::getTopic(topicName);
+	int rate = args.getCount() > 1 ? args.getInt(1) : Config::stateRate;
+
+	if (topic == StatePublisher::TOPIC_COUNT) {
+		std::cout << "- Client #" << activeMessage->client->id << " tried to subscribe to unknown state topic '" << topicName << "'" << std::endl;
+
+		return;
+	}
+
+	statePublisher->subscribe(activeMessage->client, topic, rate);
+}
+
+void SoccerBot::handleGetProfileCommand(const CommandDispatcher::Arguments& args) {
+	activeMessage->respond(Util::json("profile", Profiler::getJSON()));
+
+	if (args.getCount() > 0 && args.getView(0) == "reset") {
+		Profiler::reset();
+	}
+}
+
+void SoccerBot::handleProfileTraceCommand(const CommandDispatcher::Arguments& args) {
+	double duration = args.getCount() > 0 ? args.getFloat(0) : Config::profileTraceDuration;
+	std::string filename = args.getCount() > 1 ? args.getString(1) : Config::profileTraceFilename;
+
+	Profiler::startTrace(filename, duration);
+}
+
+void SoccerBot::handleResetLatencyCommand() {
+	robot->resetLatency();
+}
+
 void SoccerBot::handleGetFrameCommand() {
-	frameRequested = true;
+	frameStreamer->requestFrame(activeMessage->client);
+}
+
+void SoccerBot::handleStreamFramesCommand(const CommandDispatcher::Arguments& args) {
+	int fps = args.getCount() > 0 ? args.getInt(0) : Config::frameStreamFps;
+	FrameStreamer::ClassificationFormat format = args.getCount() > 1 && args.getView(1) == "runs" ? FrameStreamer::RUN_CLASSIFICATION : FrameStreamer::JPEG_CLASSIFICATION;
+
+	frameStreamer->subscribe(activeMessage->client, fps, format);
 }
 
-void SoccerBot::handleCameraChoiceCommand(Command::Parameters parameters) {
-	debugCameraDir = Util::toInt(parameters[0]) == 2 ? Dir::REAR : Dir::FRONT;
+void SoccerBot::handleCameraChoiceCommand(const CommandDispatcher::Arguments& args) {
+	debugCameraDir = args.getInt(0) == 2 ? Dir::REAR : Dir::FRONT;
 
 	std::cout << "! Debugging now from " << (debugCameraDir == Dir::FRONT ? "front" : "rear") << " camera" << std::endl;
 }
 
-void SoccerBot::handleCameraAdjustCommand(Command::Parameters parameters) {
-	//Util::cameraCorrectionK = Util::toFloat(parameters[0]);
-	//Util::cameraCorrectionZoom = Util::toFloat(parameters[1]);
+void SoccerBot::handleCameraAdjustCommand(const CommandDispatcher::Arguments& args) {
+	//Util::cameraCorrectionK = args.getFloat(0);
+	//Util::cameraCorrectionZoom = args.getFloat(1);
 
 	//std::cout << "! Adjust camera correction k: " << Util::cameraCorrectionK << ", zoom: " << Util::cameraCorrectionZoom << std::endl;
 }
 
-void SoccerBot::handleStreamChoiceCommand(Command::Parameters parameters) {
-	std::string requestedStream = parameters[0];
+void SoccerBot::handleStreamChoiceCommand(const CommandDispatcher::Arguments& args) {
+	std::string requestedStream = args.getString(0);
 
 	if (requestedStream == "") {
 		std::cout << "! Switching to live stream" << std::endl;
 
-		frontProcessor->camera = ximeaFrontCamera;
-		rearProcessor->camera = ximeaRearCamera;
+		if (replayer != NULL) {
+			frontCamera = replayFrontCamera;
+			rearCamera = replayRearCamera;
+		} else {
+			frontCamera = ximeaFrontCamera;
+			rearCamera = ximeaRearCamera;
+		}
 
-		frontCamera = ximeaFrontCamera;
-		rearCamera = ximeaRearCamera;
+		frontProcessor->camera = frontCamera;
+		rearProcessor->camera = rearCamera;
 
 		activeStreamName = requestedStream;
 	} else {
@@ -872,13 +1035,13 @@ void SoccerBot::handleStreamChoiceCommand(Command::Parameters parameters) {
 	}
 }
 
-void SoccerBot::handleBlobberThresholdCommand(Command::Parameters parameters) {
-	std::string selectedColorName = parameters[0];
-    int centerX = Util::toInt(parameters[1]);
-    int centerY = Util::toInt(parameters[2]);
-    int mode = Util::toInt(parameters[3]);
-    int brushRadius = Util::toInt(parameters[4]);
-    float stdDev = Util::toFloat(parameters[5]);
+void SoccerBot::handleBlobberThresholdCommand(const CommandDispatcher::Arguments& args) {
+	std::string selectedColorName = args.getString(0);
+    int centerX = args.getInt(1);
+    int centerY = args.getInt(2);
+    int mode = args.getInt(3);
+    int brushRadius = args.getInt(4);
+    float stdDev = args.getFloat(5);
 
 	unsigned char* dataY = debugCameraDir == Dir::FRONT ? frontProcessor->dataY : rearProcessor->dataY;
 	unsigned char* dataU = debugCameraDir == Dir::FRONT ? frontProcessor->dataU : rearProcessor->dataU;
@@ -898,9 +1061,9 @@ void SoccerBot::handleBlobberThresholdCommand(Command::Parameters parameters) {
 	);
 }
 
-void SoccerBot::handleBlobberClearCommand(Command::Parameters parameters) {
-	if (parameters.size() == 1) {
-		std::string color = parameters[0];
+void SoccerBot::handleBlobberClearCommand(const CommandDispatcher::Arguments& args) {
+	if (args.getCount() == 1) {
+		std::string color = args.getString(0);
 
 		frontBlobber->clearColor(color);
 		rearBlobber->clearColor(color);
@@ -910,36 +1073,42 @@ void SoccerBot::handleBlobberClearCommand(Command::Parameters parameters) {
 	}
 }
 
-void SoccerBot::handleScreenshotCommand(Command::Parameters parameters) {
-	std::string name = parameters[0];
+void SoccerBot::handleScreenshotCommand(const CommandDispatcher::Arguments& args) {
+	std::string name = args.getString(0);
 
 	std::cout << "! Storing screenshot: " << name << std::endl;
 
+	// saved without copying, the processors keep their frames until their next run
 	ImageProcessor::saveBitmap(frontProcessor->frame, Config::screenshotsDirectory + "/" + name + "-front.scr", Config::cameraWidth * Config::cameraHeight * 4);
 	ImageProcessor::saveBitmap(rearProcessor->frame, Config::screenshotsDirectory + "/" + name + "-rear.scr", Config::cameraWidth * Config::cameraHeight * 4);
 	
-	ImageProcessor::saveJPEG(frontProcessor->rgb, Config::screenshotsDirectory + "/" + name + "-rgb-front.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
-	ImageProcessor::saveJPEG(frontProcessor->classification, Config::screenshotsDirectory + "/" + name + "-classification-front.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
+	// the debug images only exist while debugging
+	if (frontProcessor->rgb != NULL) {
+		ImageProcessor::saveJPEG(frontProcessor->rgb, Config::screenshotsDirectory + "/" + name + "-rgb-front.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
+		ImageProcessor::saveJPEG(frontProcessor->classification, Config::screenshotsDirectory + "/" + name + "-classification-front.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
+	}
 
-	ImageProcessor::saveJPEG(rearProcessor->rgb, Config::screenshotsDirectory + "/" + name + "-rgb-rear.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
-	ImageProcessor::saveJPEG(rearProcessor->classification, Config::screenshotsDirectory + "/" + name + "-classification-rear.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
+	if (rearProcessor->rgb != NULL) {
+		ImageProcessor::saveJPEG(rearProcessor->rgb, Config::screenshotsDirectory + "/" + name + "-rgb-rear.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
+		ImageProcessor::saveJPEG(rearProcessor->classification, Config::screenshotsDirectory + "/" + name + "-classification-rear.jpeg", Config::cameraWidth, Config::cameraHeight, 3);
+	}
 
 	broadcastScreenshots();
 }
 
-void SoccerBot::handleListScreenshotsCommand(Server::Message* message) {
+void SoccerBot::handleListScreenshotsCommand() {
 	broadcastScreenshots();
 }
 
-void SoccerBot::handleCameraTranslatorCommand(Command::Parameters parameters) {
-	float A = Util::toFloat(parameters[0]);
-	float B = Util::toFloat(parameters[1]);
-	float C = Util::toFloat(parameters[2]);
-	float k1 = Util::toFloat(parameters[3]);
-	float k2 = Util::toFloat(parameters[4]);
-	float k3 = Util::toFloat(parameters[5]);
-	float horizon = Util::toFloat(parameters[6]);
-	float distortionFocus = Util::toFloat(parameters[7]);
+void SoccerBot::handleCameraTranslatorCommand(const CommandDispatcher::Arguments& args) {
+	float A = args.getFloat(0);
+	float B = args.getFloat(1);
+	float C = args.getFloat(2);
+	float k1 = args.getFloat(3);
+	float k2 = args.getFloat(4);
+	float k3 = args.getFloat(5);
+	float horizon = args.getFloat(6);
+	float distortionFocus = args.getFloat(7);
 
 	//std::cout << "! Updating camera translator constants" << std::endl;
 
@@ -963,14 +1132,18 @@ void SoccerBot::handleCameraTranslatorCommand(Command::Parameters parameters) {
 }
 
 void SoccerBot::handleCommunicationMessages() {
-	std::string message;
+	int messageCount;
 
-	while (com->gotMessages()) {
-		message = com->dequeueMessage();
+	while ((messageCount = com->dequeueMessages(communicationMessages, Config::messageBatchSize)) > 0) {
+		for (int i = 0; i < messageCount; i++) {
+			//std::cout << "M < " << communicationMessages[i] << std::endl;
 
-		//std::cout << "M < " << message << std::endl;
+			if (recorder != NULL) {
+				recorder->recordMessage(communicationMessages[i]);
+			}
 
-		handleCommunicationMessage(message);
+			handleCommunicationMessage(communicationMessages[i]);
+		}
 	}
 
 	com->sync();
@@ -1015,6 +1188,75 @@ std::string SoccerBot::getStateJSON() {
     stream << "\"dt\":" << dt << ",";
     stream << "\"totalTime\":" << totalTime << ",";
 	stream << "\"gotBall\":" << (robot->dribbler->gotBall() ? "true" : "false") << ",";
+	stream << "\"queues\":{";
+	stream << "\"communication\":{\"depth\":" << com->getQueueDepth() << ",\"maxDepth\":" << com->getMaxQueueDepth() << ",\"dropped\":" << com->getDroppedMessageCount() << "},";
+	stream << "\"server\":{\"depth\":" << server->getQueueDepth() << ",\"maxDepth\":" << server->getMaxQueueDepth() << ",\"dropped\":" << server->getDroppedMessageCount() << "}";
+	stream << "},";
+
+	AbstractCommunication::SendStats sendStats = com->getSendStats();
+
+	FrameStreamer::Stats frameStats = frameStreamer->getStats();
+
+	stream << "\"frames\":{";
+	stream << "\"encoded\":" << frameStats.encoded << ",";
+	stream << "\"cacheHits\":" << frameStats.cacheHits << ",";
+	stream << "\"sent\":" << frameStats.sent << ",";
+	stream << "\"dropped\":" << frameStats.dropped << ",";
+	stream << "\"skipped\":" << frameStats.skipped;
+	stream << "},";
+
+	StatePublisher::Stats publisherStats = statePublisher->getStats();
+
+	stream << "\"publisher\":{";
+	stream << "\"published\":" << publisherStats.published << ",";
+	stream << "\"updates\":" << publisherStats.updates << ",";
+	stream << "\"values\":" << publisherStats.values << ",";
+	stream << "\"busy\":" << publisherStats.busy << ",";
+	stream << "\"invalid\":" << publisherStats.invalid;
+	stream << "},";
+
+	if (frontCapture != NULL && rearCapture != NULL) {
+		CaptureThread::Stats frontCaptureStats = frontCapture->getStats();
+		CaptureThread::Stats rearCaptureStats = rearCapture->getStats();
+
+		stream << "\"capture\":{";
+		stream << "\"front\":{\"captured\":" << frontCaptureStats.captured << ",\"stale\":" << frontCaptureStats.stale << ",\"overruns\":" << frontCaptureStats.overruns << "},";
+		stream << "\"rear\":{\"captured\":" << rearCaptureStats.captured << ",\"stale\":" << rearCaptureStats.stale << ",\"overruns\":" << rearCaptureStats.overruns << "}";
+		stream << "},";
+	}
+
+	// sections that only state topics use are left out while nobody subscribes to them
+	if (statePublisher->isSubscribed(StatePublisher::VISION_TOPIC) && visionResults->front != NULL && visionResults->rear != NULL) {
+		stream << "\"vision\":{";
+		stream << "\"front\":{";
+		debugObjectList("balls", stream, visionResults->front->balls);
+		stream << ",";
+		debugObjectList("goals", stream, visionResults->front->goals);
+		stream << "},";
+		stream << "\"rear\":{";
+		debugObjectList("balls", stream, visionResults->rear->balls);
+		stream << ",";
+		debugObjectList("goals", stream, visionResults->rear->goals);
+		stream << "}";
+		stream << "},";
+	}
+
+	if (statePublisher->isSubscribed(StatePublisher::LOCALIZER_TOPIC)) {
+		std::string localizerInfo = robot->robotLocalizer->getJSON();
+
+		stream << "\"localizer\":" << (localizerInfo.length() > 0 ? localizerInfo : "null") << ",";
+	}
+
+	stream << "\"send\":{";
+	stream << "\"pending\":" << sendStats.pending << ",";
+	stream << "\"coalesced\":" << sendStats.coalesced << ",";
+	stream << "\"dropped\":" << sendStats.dropped << ",";
+	stream << "\"datagrams\":" << sendStats.datagrams << ",";
+	stream << "\"inFlight\":" << sendStats.inFlight << ",";
+	stream << "\"maxInFlight\":" << sendStats.maxInFlight << ",";
+	stream << "\"backPressure\":" << sendStats.backPressure << ",";
+	stream << "\"errors\":" << sendStats.errors;
+	stream << "},";
 
 	/*
 	stream << "\"measurements\": {";
@@ -1070,3 +1312,33 @@ std::string SoccerBot::getStateJSON() {
 
     return stream.str();
 }
+
+void SoccerBot::debugObjectList(std::string name, std::stringstream& stream, const ObjectList& objects) {
+	const Object* object;
+	bool first = true;
+
+	stream << "\"" << name << "\":[";
+
+	for (ObjectListItc it = objects.begin(); it != objects.end(); it++) {
+		object = *it;
+
+		if (!first) {
+			stream << ",";
+		} else {
+			first = false;
+		}
+
+		stream << "{";
+		stream << "\"x\":" << object->x << ",";
+		stream << "\"y\":" << object->y << ",";
+		stream << "\"width\":" << object->width << ",";
+		stream << "\"height\":" << object->height << ",";
+		stream << "\"distance\":" << object->distance << ",";
+		stream << "\"angle\":" << object->angle << ",";
+		stream << "\"type\":" << object->type << ",";
+		stream << "\"behind\":" << (object->behind ? "true" : "false");
+		stream << "}";
+	}
+
+	stream << "]";
+}
@@ -0,0 +1,481 @@
+#include "StatePublisher.h"
+#include "Config.h"
+#include "Util.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstring>
+
+namespace {
+	const char* topicNames[StatePublisher::TOPIC_COUNT] = { "robot", "vision", "controller", "wheels", "localizer", "status" };
+
+	// the first path that matches decides the topic, paths not listed belong to the status topic
+	const struct {
+		const char* path;
+		StatePublisher::Topic topic;
+	} topicPaths[] = {
+		{ "robot.wheelFL", StatePublisher::WHEELS_TOPIC },
+		{ "robot.wheelFR", StatePublisher::WHEELS_TOPIC },
+		{ "robot.wheelRL", StatePublisher::WHEELS_TOPIC },
+		{ "robot.wheelRR", StatePublisher::WHEELS_TOPIC },
+		{ "robot.ballsRaw", StatePublisher::VISION_TOPIC },
+		{ "robot.ballsFiltered", StatePublisher::VISION_TOPIC },
+		{ "vision", StatePublisher::VISION_TOPIC },
+		{ "robot", StatePublisher::ROBOT_TOPIC },
+		{ "gotBall", StatePublisher::ROBOT_TOPIC },
+		{ "controllerName", StatePublisher::CONTROLLER_TOPIC },
+		{ "controllerState", StatePublisher::CONTROLLER_TOPIC },
+		{ "targetSide", StatePublisher::CONTROLLER_TOPIC },
+		{ "playing", StatePublisher::CONTROLLER_TOPIC },
+		{ "localizer", StatePublisher::LOCALIZER_TOPIC }
+	};
+
+	void skipSpace(const char*& pos, const char* end) {
+		while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) {
+			pos++;
+		}
+	}
+
+	// expects to be at the opening quote, stops after the closing one
+	void skipString(const char*& pos, const char* end) {
+		for (pos++; pos < end; pos++) {
+			if (*pos == '\\') {
+				pos++;
+			} else if (*pos == '"') {
+				pos++;
+
+				return;
+			}
+		}
+	}
+
+	void skipValue(const char*& pos, const char* end) {
+		if (*pos == '"') {
+			skipString(pos, end);
+
+			return;
+		}
+
+		if (*pos == '{' || *pos == '[') {
+			int depth = 0;
+
+			while (pos < end) {
+				if (*pos == '"') {
+					skipString(pos, end);
+
+					continue;
+				}
+
+				if (*pos == '{' || *pos == '[') {
+					depth++;
+				} else if (*pos == '}' || *pos == ']') {
+					depth--;
+				}
+
+				pos++;
+
+				if (depth == 0) {
+					return;
+				}
+			}
+
+			return;
+		}
+
+		while (pos < end && *pos != ',' && *pos != '}' && *pos != ']' && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n') {
+			pos++;
+		}
+	}
+}
+
+StatePublisher::StatePublisher(Server* server) : server(server), running(true), pending(false), processing(false), version(0) {
+
+}
+
+StatePublisher::~StatePublisher() {
+	close();
+	join();
+}
+
+void StatePublisher::close() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	running = false;
+
+	condition.notify_all();
+}
+
+StatePublisher::Topic StatePublisher::getTopic(const std::string& name) {
+	for (int i = 0; i < TOPIC_COUNT; i++) {
+		if (name == topicNames[i]) {
+			return (Topic)i;
+		}
+	}
+
+	return TOPIC_COUNT;
+}
+
+const char* StatePublisher::getTopicName(Topic topic) {
+	return topic >= 0 && topic < TOPIC_COUNT ? topicNames[topic] : "unknown";
+}
+
+void StatePublisher::subscribe(Server::Client* client, Topic topic, int rate) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	Subscriptions::iterator it = subscriptions.begin();
+
+	while (it != subscriptions.end() && (it->clientId != client->id || it->topic != topic)) {
+		it++;
+	}
+
+	if (rate <= 0) {
+		if (it != subscriptions.end()) {
+			subscriptions.erase(it);
+		}
+
+		std::cout << "! Client #" << client->id << " unsubscribed from " << getTopicName(topic) << " state" << std::endl;
+
+		return;
+	}
+
+	if (it == subscriptions.end()) {
+		Subscription subscription;
+
+		subscription.clientId = client->id;
+		subscription.connection = client->connection;
+		subscription.topic = topic;
+
+		subscriptions.push_back(subscription);
+		it = subscriptions.end() - 1;
+	}
+
+	it->interval = 1.0 / (rate < Config::stateMaxRate ? rate : Config::stateMaxRate);
+	it->lastVersion = -1;
+	it->full = true;
+	it->sent.clear();
+
+	std::cout << "! Client #" << client->id << " subscribed to " << getTopicName(topic) << " state at " << rate << "/s" << std::endl;
+}
+
+bool StatePublisher::isSubscribed(Topic topic) {
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (Subscriptions::const_iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+		if (it->topic == topic) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool StatePublisher::isWanted() {
+	boost::mutex::scoped_try_lock lock(mutex);
+
+	if (!lock.owns_lock() || pending || processing) {
+		return false;
+	}
+
+	double time = Util::millitime();
+
+	for (Subscriptions::const_iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+		// a client still busy with an earlier update would be skipped anyway
+		if (isDue(*it, time) && server->getBufferedAmount(it->connection) <= (size_t)Config::stateMaxBuffered) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool StatePublisher::publish(std::string& json) {
+	boost::mutex::scoped_try_lock lock(mutex);
+
+	if (!lock.owns_lock() || pending || processing) {
+		return false;
+	}
+
+	// the caller gets back the previous buffer and can reuse its memory
+	this->json.swap(json);
+
+	pending = true;
+	stats.published++;
+
+	condition.notify_one();
+
+	return true;
+}
+
+StatePublisher::Stats StatePublisher::getStats() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	return stats;
+}
+
+void* StatePublisher::run() {
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (running) {
+		if (!pending) {
+			condition.wait(lock);
+
+			continue;
+		}
+
+		processedJson.swap(json);
+		pending = false;
+		processing = true;
+
+		lock.unlock();
+
+		bool valid = flatten(processedJson);
+
+		lock.lock();
+
+		if (valid) {
+			version++;
+
+			deliver(lock);
+		} else {
+			stats.invalid++;
+		}
+
+		processing = false;
+	}
+
+	return NULL;
+}
+
+bool StatePublisher::isDue(const Subscription& subscription, double time) const {
+	return time - subscription.lastSendTime >= subscription.interval;
+}
+
+bool StatePublisher::flatten(const std::string& json) {
+	for (int i = 0; i < TOPIC_COUNT; i++) {
+		values[i].clear();
+	}
+
+	const char* pos = json.c_str();
+	const char* end = pos + json.size();
+
+	skipSpace(pos, end);
+
+	return pos < end && *pos == '{' && flattenObject(pos, end, "");
+}
+
+bool StatePublisher::flattenObject(const char*& pos, const char* end, const std::string& prefix) {
+	bool empty = true;
+
+	// skip the opening brace
+	pos++;
+
+	while (true) {
+		skipSpace(pos, end);
+
+		if (pos >= end) {
+			return false;
+		}
+
+		if (*pos == '}') {
+			pos++;
+
+			break;
+		}
+
+		if (*pos != '"') {
+			return false;
+		}
+
+		const char* keyStart = pos + 1;
+
+		skipString(pos, end);
+
+		std::string path = prefix.empty() ? std::string(keyStart, pos - 1) : prefix + "." + std::string(keyStart, pos - 1);
+
+		skipSpace(pos, end);
+
+		if (pos >= end || *pos != ':') {
+			return false;
+		}
+
+		pos++;
+		skipSpace(pos, end);
+
+		if (pos >= end) {
+			return false;
+		}
+
+		if (*pos == '{') {
+			if (!flattenObject(pos, end, path)) {
+				return false;
+			}
+		} else {
+			const char* valueStart = pos;
+
+			skipValue(pos, end);
+
+			if (pos == valueStart) {
+				return false;
+			}
+
+			addValue(path, valueStart, pos);
+		}
+
+		empty = false;
+
+		skipSpace(pos, end);
+
+		if (pos < end && *pos == ',') {
+			pos++;
+		}
+	}
+
+	// empty objects are kept as values so the client still gets them
+	if (empty && !prefix.empty()) {
+		values[getPathTopic(prefix)][prefix] = "{}";
+	}
+
+	return true;
+}
+
+void StatePublisher::addValue(const std::string& path, const char* start, const char* end) {
+	values[getPathTopic(path)][path].assign(start, end);
+}
+
+StatePublisher::Topic StatePublisher::getPathTopic(const std::string& path) {
+	for (unsigned int i = 0; i < sizeof(topicPaths) / sizeof(topicPaths[0]); i++) {
+		size_t length = strlen(topicPaths[i].path);
+
+		if (path.compare(0, length, topicPaths[i].path) == 0 && (path.size() == length || path[length] == '.')) {
+			return topicPaths[i].topic;
+		}
+	}
+
+	return STATUS_TOPIC;
+}
+
+bool StatePublisher::encode(const Subscription& subscription, std::string& message, int& valueCount) {
+	const Values& current = values[subscription.topic];
+	std::stringstream removed;
+	std::stringstream changed;
+	int removedCount = 0;
+	int changedCount = 0;
+
+	// both maps are sorted by path so they can be compared in a single pass
+	Values::const_iterator sentIt = subscription.sent.begin();
+	Values::const_iterator currentIt = current.begin();
+
+	while (sentIt != subscription.sent.end() || currentIt != current.end()) {
+		if (currentIt == current.end() || (sentIt != subscription.sent.end() && sentIt->first < currentIt->first)) {
+			removed << (removedCount++ > 0 ? "," : "") << "\"" << sentIt->first << "\"";
+			sentIt++;
+		} else if (sentIt == subscription.sent.end() || currentIt->first < sentIt->first) {
+			changed << (changedCount++ > 0 ? "," : "") << "\"" << currentIt->first << "\":" << currentIt->second;
+			currentIt++;
+		} else {
+			if (sentIt->second != currentIt->second) {
+				changed << (changedCount++ > 0 ? "," : "") << "\"" << currentIt->first << "\":" << currentIt->second;
+			}
+
+			sentIt++;
+			currentIt++;
+		}
+	}
+
+	valueCount = removedCount + changedCount;
+
+	if (valueCount == 0 && !subscription.full) {
+		return false;
+	}
+
+	std::stringstream payload;
+
+	payload << "{\"topic\":\"" << getTopicName(subscription.topic) << "\",";
+	payload << "\"full\":" << (subscription.full ? "true" : "false") << ",";
+	payload << "\"remove\":[" << removed.str() << "],";
+	payload << "\"set\":{" << changed.str() << "}}";
+
+	message = Util::json("state-delta", payload.str());
+
+	return true;
+}
+
+void StatePublisher::deliver(boost::mutex::scoped_lock& lock) {
+	std::vector<Subscription> targets;
+	double time = Util::millitime();
+
+	for (Subscriptions::iterator it = subscriptions.begin(); it != subscriptions.end(); ) {
+		if (it->connection.expired()) {
+			it = subscriptions.erase(it);
+
+			continue;
+		}
+
+		if (isDue(*it, time) && it->lastVersion < version) {
+			// the sent values are moved rather than copied and put back once done
+			targets.push_back(Subscription());
+			targets.back().clientId = it->clientId;
+			targets.back().connection = it->connection;
+			targets.back().topic = it->topic;
+			targets.back().full = it->full;
+			targets.back().sent.swap(it->sent);
+		}
+
+		it++;
+	}
+
+	// diffing and sending happens without holding the lock so the main loop never waits for it
+	lock.unlock();
+
+	std::vector<bool> sent(targets.size(), false);
+	std::vector<int> valueCounts(targets.size(), 0);
+	std::string message;
+
+	for (unsigned int i = 0; i < targets.size(); i++) {
+		if (server->getBufferedAmount(targets[i].connection) > (size_t)Config::stateMaxBuffered) {
+			continue;
+		}
+
+		if (encode(targets[i], message, valueCounts[i])) {
+			server->send(targets[i].connection, message);
+		}
+
+		targets[i].sent = values[targets[i].topic];
+		sent[i] = true;
+	}
+
+	lock.lock();
+
+	for (unsigned int i = 0; i < targets.size(); i++) {
+		if (!sent[i]) {
+			stats.busy++;
+		} else if (valueCounts[i] > 0 || targets[i].full) {
+			stats.updates++;
+			stats.values += valueCounts[i];
+		}
+
+		for (Subscriptions::iterator it = subscriptions.begin(); it != subscriptions.end(); it++) {
+			if (it->clientId != targets[i].clientId || it->topic != targets[i].topic) {
+				continue;
+			}
+
+			// subscribing again while the update was sent starts over with all values
+			if (it->full && !targets[i].full) {
+				break;
+			}
+
+			it->sent.swap(targets[i].sent);
+
+			if (sent[i]) {
+				it->lastSendTime = time - it->lastSendTime < it->interval * 2.0 ? it->lastSendTime + it->interval : time;
+				it->lastVersion = version;
+				it->full = false;
+			} else {
+				// a busy client is tried again after its interval rather than on every frame
+				it->lastSendTime = time;
+			}
+
+			break;
+		}
+	}
+}
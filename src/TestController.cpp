@@ -5,6 +5,8 @@
 #include "Coilgun.h"
 #include "Command.h"
 
+#include <boost/bind.hpp>
+
 /**
 * TODO
 * + fetch ball straight and search for goal if lost goal at large angle
@@ -174,6 +176,7 @@
 
 TestController::TestController(Robot* robot, AbstractCommunication* com) : BaseAI(robot, com), targetSide(Side::BLUE), manualSpeedX(0.0f), manualSpeedY(0.0f), manualOmega(0.0f), manualDribblerSpeed(0), manualKickStrength(0), blueGoalDistance(0.0f), yellowGoalDistance(0.0f), lastCommandTime(-1.0), lastBallTime(-1.0), lastNearLineTime(-1.0), lastNearGoalTime(-1.0), lastInCornerTime(-1.0), lastGoalObstructedTime(-1.0), lastTargetGoalAngle(0.0f), lastBall(NULL), lastTurnAroundTime(-1.0), lastClosestGoalDistance(-1.0f), lastTargetGoalDistance(-1.0f), framesRobotOutFront(0), framesRobotOutRear(0), isRobotOutFront(false), isRobotOutRear(false), isNearLine(false), isInCorner(false), isBallInWay(false), isAvoidingBallInWay(false), inCornerFrames(0), nearLineFrames(0), nearGoalFrames(0), visibleBallCount(0), visionResults(NULL), refFieldId(TestController::RefId::A), refRobotId(TestController::A) {
 	setupStates();
+	setupCommands();
 
 	speedMultiplier = 1.0f;
 };
@@ -182,10 +185,31 @@ TestController::~TestController() {
 
 }
 
+void TestController::setupCommands() {
+	commands.add("target-vector", "fff", boost::bind(&TestController::handleTargetVectorCommand, this, _1));
+	commands.add("set-dribbler", "i", boost::bind(&TestController::handleDribblerCommand, this, _1));
+	commands.add("adjust-dribbler-limits", "ii", boost::bind(&TestController::handleAdjustDribblerLimitsCommand, this, _1));
+	commands.add("dribbler-normal-limits", "*", boost::bind(&TestController::handleDribblerNormalLimitsCommand, this));
+	commands.add("dribbler-chip-kick-limits", "*", boost::bind(&TestController::handleDribblerChipKickLimitsCommand, this));
+	commands.add("kick", "i", boost::bind(&TestController::handleKickCommand, this, _1));
+	commands.add("chip-kick", "f", boost::bind(&TestController::handleChipKickCommand, this, _1));
+	commands.add("reset-position", "*", boost::bind(&TestController::handleResetPositionCommand, this));
+	commands.add("stop", "*", boost::bind(&TestController::handleStopCommand, this));
+	commands.add("reset", "*", boost::bind(&TestController::handleResetCommand, this));
+	commands.add("toggle-go", "*", boost::bind(&TestController::handleToggleGoCommand, this));
+	commands.add("toggle-side", "*", boost::bind(&TestController::handleToggleSideCommand, this));
+	commands.add("drive-to", "fff", boost::bind(&TestController::handleDriveToCommand, this, _1));
+	commands.add("turn-by", "f", boost::bind(&TestController::handleTurnByCommand, this, _1));
+	commands.add("parameter", "is", boost::bind(&TestController::handleParameterCommand, this, _1));
+	commands.add("ref-field-id", "s", boost::bind(&TestController::handleRefFieldIdCommand, this, _1));
+	commands.add("ref-robot-id", "s", boost::bind(&TestController::handleRefRobotIdCommand, this, _1));
+	commands.add("ref", "s", boost::bind(&TestController::handleRefExternalCommand, this, _1));
+}
+
 void TestController::reset() {
 	std::cout << "! Reset test-controller" << std::endl;
 
-	com->send("reset");
+	com->sendReset();
 	targetSide = Side::YELLOW; // will be switched to blue in handleToggleSideCommand()
 	totalDuration = 0.0f;
 	currentStateDuration = 0.0f;
@@ -256,71 +280,35 @@ void TestController::step(float dt, Vision::Results* visionResults) {
 	}
 }
 
-bool TestController::handleCommand(const Command& cmd) {
-	if (cmd.name == "target-vector" && cmd.parameters.size() == 3) {
-		handleTargetVectorCommand(cmd);
-	} else if (cmd.name == "set-dribbler" && cmd.parameters.size() == 1) {
-		handleDribblerCommand(cmd);
-	} else if (cmd.name == "adjust-dribbler-limits" && cmd.parameters.size() == 2) {
-		handleAdjustDribblerLimitsCommand(cmd);
-	} else if (cmd.name == "dribbler-normal-limits") {
-		robot->dribbler->useNormalLimits();
-	} else if (cmd.name == "dribbler-chip-kick-limits") {
-		robot->dribbler->useChipKickLimits();
-	} else if (cmd.name == "kick" && cmd.parameters.size() == 1) {
-		handleKickCommand(cmd);
-	} else if (cmd.name == "chip-kick" && cmd.parameters.size() == 1) {
-		handleChipKickCommand(cmd);
-	} else if (cmd.name == "reset-position") {
-		robot->setPosition(Config::fieldWidth / 2.0f, Config::fieldHeight / 2.0f, 0.0f);
-	} else if (cmd.name == "stop") {
-		handleResetCommand();
-		setState("manual-control");
-	} else if (cmd.name == "reset") {
-		handleResetCommand();
-	} else if (cmd.name == "toggle-go") {
-		handleToggleGoCommand();
-	} else if (cmd.name == "toggle-side") {
-		handleToggleSideCommand();
-	} else if (cmd.name == "drive-to" && cmd.parameters.size() == 3) {
-		handleDriveToCommand(cmd);
-	} else if (cmd.name == "turn-by" && cmd.parameters.size() == 1) {
-		handleTurnByCommand(cmd);
-	} else if (cmd.name.substr(0, 4) == "run-") {
-		setState(cmd.name.substr(4));
-	} else if (cmd.name == "parameter" && cmd.parameters.size() == 2) {
-		handleParameterCommand(cmd);
-	} else if (cmd.name == "ref-field-id" && cmd.parameters.size() == 1) {
-		handleRefFieldIdCommand(cmd);
-	} else if (cmd.name == "ref-robot-id" && cmd.parameters.size() == 1) {
-		handleRefRobotIdCommand(cmd);
-	} else if (cmd.name == "ref" && cmd.parameters.size() == 1) {
-		handleRefExternalCommand(cmd);
-	}
-	else {
-		return false;
+bool TestController::handleCommand(const Command::View& cmd) {
+	if (commands.dispatch(cmd)) {
+		return true;
+	} else if (cmd.name.startsWith("run-")) {
+		setState(cmd.name.substr(4).toString());
+
+		return true;
 	}
 
-	return true;
+	return false;
 }
 
-void TestController::handleTargetVectorCommand(const Command& cmd) {
-	manualSpeedX = Util::toFloat(cmd.parameters[0]);
-	manualSpeedY = Util::toFloat(cmd.parameters[1]);
-	manualOmega = Util::toFloat(cmd.parameters[2]);
+void TestController::handleTargetVectorCommand(const CommandDispatcher::Arguments& args) {
+	manualSpeedX = args.getFloat(0);
+	manualSpeedY = args.getFloat(1);
+	manualOmega = args.getFloat(2);
 
 	lastCommandTime = Util::millitime();
 }
 
-void TestController::handleDribblerCommand(const Command& cmd) {
-	manualDribblerSpeed = Util::toInt(cmd.parameters[0]);
+void TestController::handleDribblerCommand(const CommandDispatcher::Arguments& args) {
+	manualDribblerSpeed = args.getInt(0);
 
 	lastCommandTime = Util::millitime();
 }
 
-void TestController::handleAdjustDribblerLimitsCommand(const Command& cmd) {
-	int lowerLimitDelta = Util::toInt(cmd.parameters[0]);
-	int upperLimitDelta = Util::toInt(cmd.parameters[1]);
+void TestController::handleAdjustDribblerLimitsCommand(const CommandDispatcher::Arguments& args) {
+	int lowerLimitDelta = args.getInt(0);
+	int upperLimitDelta = args.getInt(1);
 	int currentLowerLimit = robot->dribbler->getLowerLimit();
 	int currentUpperLimit = robot->dribbler->getUpperLimit();
 	int scaler = 1;
@@ -328,20 +316,37 @@ void TestController::handleAdjustDribblerLimitsCommand(const Command& cmd) {
 	robot->dribbler->setLimits(currentLowerLimit + lowerLimitDelta, currentUpperLimit + upperLimitDelta);
 }
 
-void TestController::handleKickCommand(const Command& cmd) {
-	manualKickStrength = Util::toInt(cmd.parameters[0]);
+void TestController::handleDribblerNormalLimitsCommand() {
+	robot->dribbler->useNormalLimits();
+}
+
+void TestController::handleDribblerChipKickLimitsCommand() {
+	robot->dribbler->useChipKickLimits();
+}
+
+void TestController::handleKickCommand(const CommandDispatcher::Arguments& args) {
+	manualKickStrength = args.getInt(0);
 
 	lastCommandTime = Util::millitime();
 }
 
-void TestController::handleChipKickCommand(const Command& cmd) {
-	float distance = Util::toFloat(cmd.parameters[0]);
+void TestController::handleChipKickCommand(const CommandDispatcher::Arguments& args) {
+	float distance = args.getFloat(0);
 
 	std::cout << "! Chip-kicking to distance: " << distance << "m" << std::endl;
 
 	robot->chipKick(distance);
 }
 
+void TestController::handleResetPositionCommand() {
+	robot->setPosition(Config::fieldWidth / 2.0f, Config::fieldHeight / 2.0f, 0.0f);
+}
+
+void TestController::handleStopCommand() {
+	handleResetCommand();
+	setState("manual-control");
+}
+
 void TestController::handleResetCommand() {
 	if (!resetBtn.toggle()) {
 		return;
@@ -385,17 +390,17 @@ void TestController::handleToggleSideCommand() {
 	lastTurnAroundTime = -1.0;
 }
 
-void TestController::handleParameterCommand(const Command& cmd) {
-	int index = Util::toInt(cmd.parameters[0]);
-	std::string value = cmd.parameters[1];
+void TestController::handleParameterCommand(const CommandDispatcher::Arguments& args) {
+	int index = args.getInt(0);
+	std::string value = args.getString(1);
 
 	parameters[index] = value;
 
 	//std::cout << "! Received parameter #" << index << ": " << value << std::endl;
 }
 
-void TestController::handleRefFieldIdCommand(const Command& cmd) {
-	std::string id = cmd.parameters[0];
+void TestController::handleRefFieldIdCommand(const CommandDispatcher::Arguments& args) {
+	std::string id = args.getString(0);
 
 	std::cout << "! Got referee field id: " << id << std::endl;
 
@@ -408,8 +413,8 @@ void TestController::handleRefFieldIdCommand(const Command& cmd) {
 	}
 }
 
-void TestController::handleRefRobotIdCommand(const Command& cmd) {
-	std::string id = cmd.parameters[0];
+void TestController::handleRefRobotIdCommand(const CommandDispatcher::Arguments& args) {
+	std::string id = args.getString(0);
 
 	std::cout << "! Got referee robot id: " << id << std::endl;
 
@@ -426,8 +431,8 @@ void TestController::handleRefRobotIdCommand(const Command& cmd) {
 	}
 }
 
-void TestController::handleRefExternalCommand(const Command& cmd) {
-	std::string command = cmd.parameters[0];
+void TestController::handleRefExternalCommand(const CommandDispatcher::Arguments& args) {
+	std::string command = args.getString(0);
 
 	std::cout << "! Got referee command: " << command << ", my field id: " << getRefIdName(refFieldId) << ", my robot id: " << getRefIdName(refRobotId) << std::endl;
 
@@ -466,20 +471,20 @@ void TestController::handleRefExternalCommand(const Command& cmd) {
 	}
 }
 
-void TestController::handleDriveToCommand(const Command& cmd) {
+void TestController::handleDriveToCommand(const CommandDispatcher::Arguments& args) {
 	DriveToState* state = (DriveToState*)states["drive-to"];
 
-	state->x = Util::toFloat(cmd.parameters[0]);
-	state->y = Util::toFloat(cmd.parameters[1]);
-	state->orientation = Util::toFloat(cmd.parameters[2]);
+	state->x = args.getFloat(0);
+	state->y = args.getFloat(1);
+	state->orientation = args.getFloat(2);
 
 	setState("drive-to");
 }
 
-void TestController::handleTurnByCommand(const Command& cmd) {
+void TestController::handleTurnByCommand(const CommandDispatcher::Arguments& args) {
 	TurnByState* state = (TurnByState*)states["turn-by"];
 
-	state->angle = Math::degToRad(Util::toFloat(cmd.parameters[0]));
+	state->angle = Math::degToRad(args.getFloat(0));
 
 	setState("turn-by");
 }
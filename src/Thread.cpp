@@ -32,7 +32,9 @@ int Thread::join() {
     if (running) {
         result = pthread_join(handle, NULL);
 
+        // joining again is a no-op, the destructors of the threads join too
         if (result == 0) {
+            running = false;
             detached = false;
         }
     }
@@ -3,33 +3,24 @@
 #include <iostream>
 #include <ctime>
 #include <stdio.h>
-#include <Windows.h>
-#include <tchar.h> 
-#include <stdio.h>
-#include <strsafe.h>
 
 double Util::queryPerformanceFrequency = 0;
 __int64 Util::timerStartCount = 0;
+__int64 Util::performanceCounterFrequency = Platform::getCounterFrequency();
+std::atomic<double> Util::simulatedTime(-1.0);
 //float Util::cameraCorrectionK = Config::cameraCorrectionK;
 //float Util::cameraCorrectionZoom = Config::cameraCorrectionZoom;
 
 __int64 Util::timerStart() {
-	LARGE_INTEGER li;
-    QueryPerformanceFrequency(&li);
-
-    queryPerformanceFrequency = double(li.QuadPart)/1000.0;
+    queryPerformanceFrequency = double(performanceCounterFrequency)/1000.0;
 
-    QueryPerformanceCounter(&li);
-    timerStartCount = li.QuadPart;
+    timerStartCount = Platform::getCounter();
 
-	return li.QuadPart;
+	return timerStartCount;
 }
 
 double Util::timerEnd(__int64 startTime) {
-	LARGE_INTEGER li;
-    QueryPerformanceCounter(&li);
-
-    return double(li.QuadPart - (startTime != -1 ? startTime : timerStartCount)) / queryPerformanceFrequency;
+    return double(Platform::getCounter() - (startTime != -1 ? startTime : timerStartCount)) / queryPerformanceFrequency;
 }
 
 const std::string Util::base64Chars =
@@ -78,8 +69,30 @@ std::string Util::base64Encode(const unsigned char* data, unsigned int length) {
     return ret;
 }
 
+// the simulator sets the time it has stepped to so the timers of the robot and the controllers run on it
 double Util::millitime() {
-	return (double)timeGetTime() / 1000.0;
+	// set by the replay on the main thread while the other threads read the clock
+	double time = simulatedTime.load();
+
+	if (time >= 0.0) {
+		return time;
+	}
+
+	return (double)Platform::getMilliseconds() / 1000.0;
+}
+
+// seconds from the performance counter, only meaningful for measuring intervals
+double Util::preciseTime() {
+	return (double)Platform::getCounter() / (double)performanceCounterFrequency;
+}
+
+// nanoseconds from the performance counter, only meaningful for measuring intervals
+__int64 Util::nanotime() {
+	__int64 counter = Platform::getCounter();
+
+	// whole seconds and the remainder are converted separately so the multiplication does not overflow
+	return counter / performanceCounterFrequency * 1000000000LL
+		+ counter % performanceCounterFrequency * 1000000000LL / performanceCounterFrequency;
 }
 
 double Util::duration(double start) {
@@ -174,33 +187,6 @@ std::string Util::json(std::string id, std::string payload) {
 	return "{\"id\":\"" + id + "\",\"payload\":" + payload + "}";
 }
 
-std::vector<std::string> Util::getFilesInDir(std::string path){
-	std::vector<std::string> files;
-
-	TCHAR szDir[MAX_PATH];
-	HANDLE hFind = INVALID_HANDLE_VALUE;
-	WIN32_FIND_DATA ffd;
-	LARGE_INTEGER filesize;
-
-	StringCchCopy(szDir, MAX_PATH, path.c_str());
-	StringCchCat(szDir, MAX_PATH, TEXT("\\*"));
-
-	hFind = FindFirstFile(szDir, &ffd);
-
-	if (INVALID_HANDLE_VALUE == hFind) {
-		return files;
-	}
-
-	do {
-		if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-			// directory ffd.cFileName
-		} else {
-			filesize.LowPart = ffd.nFileSizeLow;
-			filesize.HighPart = ffd.nFileSizeHigh;
-			
-			files.push_back(ffd.cFileName);
-		}
-	} while (FindNextFile(hFind, &ffd) != 0);
-
-	return files;
+std::vector<std::string> Util::getFilesInDir(std::string path) {
+	return Platform::getFilesInDir(path);
 }
@@ -1,9 +1,12 @@
 #include "VirtualCamera.h"
+#include "FrameGenerator.h"
 #include "ImageProcessor.h"
 #include "Config.h"
 #include "Util.h"
 
-VirtualCamera::VirtualCamera() : data(NULL), bufferSize(0), frameNr(0) {
+#include <string.h>
+
+VirtualCamera::VirtualCamera() : data(NULL), bufferSize(0), frameNr(0), replaying(false), fresh(false), generator(NULL), generatorDir(Dir::FRONT) {
 
 }
 
@@ -13,11 +16,58 @@ bool VirtualCamera::loadImage(std::string filename, int size) {
 	}
 
 	bufferSize = size;
+	replaying = false;
 
 	return ImageProcessor::loadBitmap(filename, data, size);
 }
 
+void VirtualCamera::setFrame(const unsigned char* frameData, int size, int number, double timestamp) {
+	if (data == NULL || bufferSize < size) {
+		if (data != NULL) delete[] data;
+
+		data = new unsigned char[size];
+	}
+
+	memcpy(data, frameData, size);
+
+	bufferSize = size;
+	frame.number = number;
+	frame.timestamp = timestamp;
+	replaying = true;
+	fresh = true;
+}
+
+void VirtualCamera::setGenerator(FrameGenerator* generator, Dir dir) {
+	this->generator = generator;
+
+	generatorDir = dir;
+}
+
 BaseCamera::Frame* VirtualCamera::getFrame() {
+	if (generator != NULL) {
+		frame.data = generator->render(generatorDir);
+		frame.size = generator->getFrameSize();
+		frame.number = frameNr++;
+		frame.width = Config::cameraWidth;
+		frame.height = Config::cameraHeight;
+		frame.timestamp = Util::millitime();
+		frame.fresh = true;
+
+		return &frame;
+	}
+
+	if (replaying) {
+		frame.data = data;
+		frame.size = bufferSize;
+		frame.width = Config::cameraWidth;
+		frame.height = Config::cameraHeight;
+		frame.fresh = fresh;
+
+		fresh = false;
+
+		return &frame;
+	}
+
 	frame.data = data;
     frame.size = bufferSize;
     frame.number = frameNr++;
@@ -56,13 +56,11 @@ void Vision::setDebugImage(unsigned char* image, int width, int height) {
 	canvas.height = height;
 }
 
-Vision::Result* Vision::process() {
-	Result* result = new Result();
-
+void Vision::process(Result* result) {
 	result->vision = this;
 
-	result->goals = processGoals(dir);
-	result->balls = processBalls(dir, result->goals);
+	processGoals(dir, result);
+	processBalls(dir, result);
 
 	updateColorDistances();
 	updateColorOrder();
@@ -70,16 +68,13 @@ Vision::Result* Vision::process() {
 	result->colorOrder = colorOrder;
 	result->whiteDistance = whiteDistance;
 	result->blackDistance = blackDistance;
-
-	return result;
 }
 
-ObjectList Vision::processBalls(Dir dir, ObjectList& goals) {
-	ObjectList allBalls;
-	ObjectList filteredBalls;
-
+void Vision::processBalls(Dir dir, Result* result) {
     Distance distance;
 
+	allObjects.clear();
+
     Blobber::Blob* blob = blobber->getBlobs("ball");
 
     while (blob != NULL) {
@@ -107,7 +102,7 @@ ObjectList Vision::processBalls(Dir dir, ObjectList& goals) {
 		int width = blob->x2 - blob->x1;
 		int height = blob->y2 - blob->y1;
 
-        Object* ball = new Object(
+        Object* ball = result->objects.create(Object(
             blob->x1 + width / 2,
             blob->y1 + height / 2,
             width,
@@ -119,20 +114,24 @@ ObjectList Vision::processBalls(Dir dir, ObjectList& goals) {
             distance.angle,
 			3,
 			dir == Dir::FRONT ? false : true
-        );
+        ));
+
+		if (ball == NULL) {
+			break;
+		}
 		
-        allBalls.push_back(ball);
+        allObjects.push_back(ball);
 
         blob = blob->next;
     }
 
 	// TODO Make the overlap margin dependent on distance (larger for objects close-by)
-	ObjectList mergedBalls = Object::mergeOverlapping(allBalls, Config::ballOverlapMargin);
+	Object::mergeOverlapping(allObjects, mergedObjects, result->objects, Config::ballOverlapMargin);
 
-	for (ObjectListItc it = mergedBalls.begin(); it != mergedBalls.end(); it++) {
+	for (ObjectListItc it = mergedObjects.begin(); it != mergedObjects.end(); it++) {
 		Object* ball = *it;
 
-		if (isValidBall(ball, dir, goals)) {
+		if (isValidBall(ball, dir, result->goals)) {
 			int extendHeightBelow = getPixelsBelow(ball->x, ball->y + ball->height / 2, validColorsBelowBall);
 
 			if (extendHeightBelow > 0) {
@@ -162,18 +161,15 @@ ObjectList Vision::processBalls(Dir dir, ObjectList& goals) {
 				continue;
 			}
 
-			filteredBalls.push_back(ball);
+			result->balls.push_back(ball);
 		}
 	}
-
-	return filteredBalls;
 }
 
-ObjectList Vision::processGoals(Dir dir) {
-	ObjectList allGoals;
-	ObjectList filteredGoals;
-
+void Vision::processGoals(Dir dir, Result* result) {
     Distance distance;
+
+	allObjects.clear();
     
     for (int i = 0; i < 2; i++) {
         Blobber::Blob* blob = blobber->getBlobs(i == 0 ? "yellow-goal" : "blue-goal");
@@ -203,7 +199,7 @@ ObjectList Vision::processGoals(Dir dir) {
 			int width = blob->x2 - blob->x1;
 			int height = blob->y2 - blob->y1;
 
-			Object* goal = new Object(
+			Object* goal = result->objects.create(Object(
 				blob->x1 + width / 2,
 				blob->y1 + height / 2,
 				width,
@@ -215,25 +211,29 @@ ObjectList Vision::processGoals(Dir dir) {
 				distance.angle,
 				i == 0 ? Side::YELLOW : Side::BLUE,
 				dir == Dir::FRONT ? false : true
-			);
+			));
+
+			if (goal == NULL) {
+				break;
+			}
 
 			goal->processed = false;
-			allGoals.push_back(goal);
+			allObjects.push_back(goal);
 
             blob = blob->next;
         }
     }
 
-	ObjectList mergedGoals = Object::mergeOverlapping(allGoals, Config::goalOverlapMargin, true);
+	Object::mergeOverlapping(allObjects, mergedObjects, result->objects, Config::goalOverlapMargin, true);
 
 	float maxGoalDistance = Math::sqrt(Math::pow(Config::fieldHeight / 2.0f, 2.0) + Math::pow(Config::fieldWidth, 2.0f));
 
-	for (ObjectListItc it = mergedGoals.begin(); it != mergedGoals.end(); it++) {
+	for (ObjectListItc it = mergedObjects.begin(); it != mergedObjects.end(); it++) {
 		Object* goal = *it;
 
 		if (
 			isValidGoal(goal, goal->type == 0 ? Side::YELLOW : Side::BLUE)
-			// && isNotOpponentMarker(goal, goal->type == 0 ? Side::YELLOW : Side::BLUE, mergedGoals)
+			// && isNotOpponentMarker(goal, goal->type == 0 ? Side::YELLOW : Side::BLUE, mergedObjects)
 		) {
 			// TODO Extend the goal downwards using extended color / limited ammount horizontal too
 
@@ -262,11 +262,9 @@ ObjectList Vision::processGoals(Dir dir) {
 				continue;
 			}*/
 
-			filteredGoals.push_back(goal);
+			result->goals.push_back(goal);
 		}
 	}
-
-	return filteredGoals;
 }
 
 bool Vision::isValidGoal(Object* goal, Side side) {
@@ -0,0 +1,660 @@
+#include "VisionBenchmark.h"
+#include "Blobber.h"
+#include "Vision.h"
+#include "CameraTranslator.h"
+#include "ImageProcessor.h"
+#include "FrameBufferPool.h"
+#include "VirtualCamera.h"
+#include "Util.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+	const char* stageNames[] = { "bayer", "yuyv", "blobber", "vision", "total" };
+}
+
+VisionBenchmark::VisionBenchmark() :
+	width(Config::cameraWidth), height(Config::cameraHeight), iterations(0),
+	frontBlobber(NULL), rearBlobber(NULL),
+	frontCameraTranslator(NULL), rearCameraTranslator(NULL),
+	frontVision(NULL), rearVision(NULL),
+	dataY(NULL), dataU(NULL), dataV(NULL), dataYUYV(NULL)
+{
+
+}
+
+VisionBenchmark::~VisionBenchmark() {
+	if (frontVision != NULL) delete frontVision; frontVision = NULL;
+	if (rearVision != NULL) delete rearVision; rearVision = NULL;
+	if (frontCameraTranslator != NULL) delete frontCameraTranslator; frontCameraTranslator = NULL;
+	if (rearCameraTranslator != NULL) delete rearCameraTranslator; rearCameraTranslator = NULL;
+	if (frontBlobber != NULL) delete frontBlobber; frontBlobber = NULL;
+	if (rearBlobber != NULL) delete rearBlobber; rearBlobber = NULL;
+	FrameBufferPool::release(dataY); dataY = NULL;
+	FrameBufferPool::release(dataU); dataU = NULL;
+	FrameBufferPool::release(dataV); dataV = NULL;
+	FrameBufferPool::release(dataYUYV); dataYUYV = NULL;
+}
+
+bool VisionBenchmark::load(const std::string& directory) {
+	std::vector<std::string> files = Util::getFilesInDir(directory);
+	std::string extension = ".scr";
+
+	std::sort(files.begin(), files.end());
+
+	for (unsigned int i = 0; i < files.size(); i++) {
+		const std::string& filename = files[i];
+
+		if (filename.size() <= extension.size() || filename.compare(filename.size() - extension.size(), extension.size(), extension) != 0) {
+			continue;
+		}
+
+		std::ifstream file((directory + "/" + filename).c_str(), std::ios::in | std::ios::binary);
+		Capture capture;
+
+		capture.name = filename.substr(0, filename.size() - extension.size());
+		capture.dir = Util::strpos(capture.name, "-rear") != -1 ? Dir::REAR : Dir::FRONT;
+		capture.data.resize(width * height);
+		capture.runCount = 0;
+		capture.blobCount = 0;
+		capture.synthetic = false;
+		capture.foundCount = 0;
+		capture.extraCount = 0;
+		capture.distanceError = 0.0f;
+		capture.angleError = 0.0f;
+
+		// screenshots are saved four times the size of the raw bayer frame that they start with
+		if (!file.read((char*)&capture.data[0], capture.data.size())) {
+			std::cout << "- Skipping screenshot " << filename << " smaller than a " << width << "x" << height << " frame" << std::endl;
+
+			continue;
+		}
+
+		captures.push_back(capture);
+	}
+
+	if (captures.empty()) {
+		std::cout << "- No screenshots found in " << directory << std::endl;
+
+		return false;
+	}
+
+	std::cout << "! Loaded " << captures.size() << " screenshots from " << directory << std::endl;
+
+	return true;
+}
+
+bool VisionBenchmark::generate(int sceneCount, int ballCount, int robotCount) {
+	setup();
+
+	FrameGenerator generator(frontBlobber, frontCameraTranslator, rearCameraTranslator, width, height);
+	VirtualCamera camera;
+
+	srand(Config::syntheticSeed);
+
+	for (int i = 0; i < sceneCount; i++) {
+		generator.setScene(FrameGenerator::getRandomScene(ballCount, robotCount));
+
+		for (int j = 0; j < 2; j++) {
+			Capture capture;
+			std::stringstream name;
+
+			name << "synthetic-" << i << (j == 0 ? "" : "-rear");
+
+			capture.name = name.str();
+			capture.dir = j == 0 ? Dir::FRONT : Dir::REAR;
+			capture.runCount = 0;
+			capture.blobCount = 0;
+			capture.synthetic = true;
+			capture.foundCount = 0;
+			capture.extraCount = 0;
+			capture.distanceError = 0.0f;
+			capture.angleError = 0.0f;
+			capture.visibleBalls = generator.getVisibleBalls(capture.dir);
+
+			camera.setGenerator(&generator, capture.dir);
+
+			BaseCamera::Frame* frame = camera.getFrame();
+
+			capture.data.assign(frame->data, frame->data + frame->size);
+
+			captures.push_back(capture);
+		}
+	}
+
+	std::cout << "! Rendered " << captures.size() << " frames of " << sceneCount << " scenes with " << ballCount << " balls and " << robotCount << " robots" << std::endl;
+
+	return sceneCount > 0;
+}
+
+void VisionBenchmark::setup() {
+	if (frontVision != NULL) {
+		return;
+	}
+
+	frontBlobber = new Blobber();
+	rearBlobber = new Blobber();
+
+	frontBlobber->initialize(width, height);
+	rearBlobber->initialize(width, height);
+
+	frontBlobber->loadOptions(Config::blobberConfigFilename);
+	rearBlobber->loadOptions(Config::blobberConfigFilename);
+
+	frontCameraTranslator = new CameraTranslator();
+	rearCameraTranslator = new CameraTranslator();
+
+	frontCameraTranslator->setConstants(
+		Config::frontCameraA, Config::frontCameraB, Config::frontCameraC,
+		Config::cameraDistortionK1, Config::cameraDistortionK2, Config::cameraDistortionK3,
+		Config::frontCameraHorizon, Config::cameraDistortionFocus,
+		width, height
+	);
+
+	rearCameraTranslator->setConstants(
+		Config::rearCameraA, Config::rearCameraB, Config::rearCameraC,
+		Config::cameraDistortionK1, Config::cameraDistortionK2, Config::cameraDistortionK3,
+		Config::rearCameraHorizon, Config::cameraDistortionFocus,
+		width, height
+	);
+
+	std::cout << "  > loading camera mappings.. ";
+	frontCameraTranslator->loadMappings(Config::distortMappingFilenameFrontX, Config::distortMappingFilenameFrontY);
+	rearCameraTranslator->loadMappings(Config::distortMappingFilenameRearX, Config::distortMappingFilenameRearY);
+	std::cout << "done!" << std::endl;
+
+	frontVision = new Vision(frontBlobber, frontCameraTranslator, Dir::FRONT, width, height);
+	rearVision = new Vision(rearBlobber, rearCameraTranslator, Dir::REAR, width, height);
+
+	// the same aligned planes as the process thread
+	dataY = FrameBufferPool::acquire(FrameBufferPool::Y_PLANE, width, height);
+	dataU = FrameBufferPool::acquire(FrameBufferPool::CHROMA_PLANE, width, height);
+	dataV = FrameBufferPool::acquire(FrameBufferPool::CHROMA_PLANE, width, height);
+	dataYUYV = FrameBufferPool::acquire(FrameBufferPool::YUYV_FORMAT, width, height);
+}
+
+void VisionBenchmark::run(int iterations) {
+	setup();
+
+	this->iterations = iterations;
+
+	for (unsigned int i = 0; i < captures.size(); i++) {
+		for (int stage = 0; stage < STAGE_COUNT; stage++) {
+			captures[i].durations[stage].clear();
+		}
+	}
+
+	std::cout << "! Benchmarking vision over " << captures.size() << " screenshots for " << iterations << " iterations" << std::endl;
+
+	// the first pass warms up the caches and stores what was detected
+	for (unsigned int i = 0; i < captures.size(); i++) {
+		process(captures[i], false);
+	}
+
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		for (unsigned int i = 0; i < captures.size(); i++) {
+			process(captures[i], true);
+		}
+	}
+
+	for (int stage = 0; stage < STAGE_COUNT; stage++) {
+		std::vector<__int64> durations;
+
+		for (unsigned int i = 0; i < captures.size(); i++) {
+			durations.insert(durations.end(), captures[i].durations[stage].begin(), captures[i].durations[stage].end());
+		}
+
+		std::cout << "  > " << stageNames[stage] << ": median " << getPercentile(durations, 0.5f) << "ms, p99 " << getPercentile(durations, 0.99f) << "ms" << std::endl;
+	}
+
+	int visibleCount = 0;
+	int foundCount = 0;
+	int extraCount = 0;
+	float distanceError = 0.0f;
+	float angleError = 0.0f;
+
+	for (unsigned int i = 0; i < captures.size(); i++) {
+		if (!captures[i].synthetic) {
+			continue;
+		}
+
+		visibleCount += captures[i].visibleBalls.size();
+		foundCount += captures[i].foundCount;
+		extraCount += captures[i].extraCount;
+		distanceError += captures[i].distanceError * captures[i].foundCount;
+		angleError += captures[i].angleError * captures[i].foundCount;
+	}
+
+	if (visibleCount > 0 || extraCount > 0) {
+		std::cout << "  > found " << foundCount << " of " << visibleCount << " rendered balls, " << extraCount << " extra"
+			<< ", mean distance error " << (foundCount > 0 ? distanceError / foundCount : 0.0f) << "m"
+			<< ", mean angle error " << (foundCount > 0 ? Math::radToDeg(angleError / foundCount) : 0.0f) << " degrees" << std::endl;
+	}
+}
+
+void VisionBenchmark::process(Capture& capture, bool record) {
+	Blobber* blobber = capture.dir == Dir::FRONT ? frontBlobber : rearBlobber;
+	Vision* vision = capture.dir == Dir::FRONT ? frontVision : rearVision;
+	__int64 times[STAGE_COUNT];
+
+	times[BAYER_STAGE] = Util::nanotime();
+
+	ImageProcessor::bayerRGGBToI420(&capture.data[0], dataY, dataU, dataV, width, height);
+
+	times[YUYV_STAGE] = Util::nanotime();
+
+	ImageProcessor::I420ToYUYV(dataY, dataU, dataV, dataYUYV, width, height);
+
+	times[BLOBBER_STAGE] = Util::nanotime();
+
+	blobber->processFrame((Blobber::Pixel*)dataYUYV);
+
+	times[VISION_STAGE] = Util::nanotime();
+
+	vision->setDebugImage(NULL, 0, 0);
+
+	result.reset(0.0, 0);
+	vision->process(&result);
+
+	times[TOTAL_STAGE] = Util::nanotime();
+
+	if (record) {
+		for (int stage = 0; stage < TOTAL_STAGE; stage++) {
+			capture.durations[stage].push_back(times[stage + 1] - times[stage]);
+		}
+
+		capture.durations[TOTAL_STAGE].push_back(times[TOTAL_STAGE] - times[BAYER_STAGE]);
+	} else {
+		capture.runCount = blobber->getRunCount();
+		capture.blobCount = 0;
+
+		for (int i = 0; i < blobber->getColorCount(); i++) {
+			capture.blobCount += blobber->getBlobCount(i);
+		}
+
+		capture.balls = getObjectsJSON(result.balls);
+		capture.goals = getObjectsJSON(result.goals);
+
+		if (capture.synthetic) {
+			matchBalls(capture, result.balls);
+		}
+	}
+}
+
+double VisionBenchmark::getPercentile(std::vector<__int64>& durations, float percentile) {
+	if (durations.empty()) {
+		return 0.0;
+	}
+
+	std::sort(durations.begin(), durations.end());
+
+	return (double)durations[(int)(percentile * (durations.size() - 1) + 0.5f)] / 1000000.0;
+}
+
+void VisionBenchmark::matchBalls(Capture& capture, const ObjectList& balls) {
+	std::vector<bool> matched(balls.size(), false);
+
+	capture.foundCount = 0;
+	capture.distanceError = 0.0f;
+	capture.angleError = 0.0f;
+
+	// every rendered ball takes the closest detection in angle that is not taken yet
+	for (unsigned int i = 0; i < capture.visibleBalls.size(); i++) {
+		const FrameGenerator::VisibleBall& visibleBall = capture.visibleBalls[i];
+		int bestIndex = -1;
+		float bestAngleError = Config::syntheticMatchAngle;
+
+		for (unsigned int index = 0; index < balls.size(); index++) {
+			Object* ball = balls[index];
+			float angleError = Math::abs(Math::getAngleDiff(ball->angle, visibleBall.angle));
+
+			if (
+				matched[index]
+				|| angleError > bestAngleError
+				|| Math::abs(ball->distance - visibleBall.distance) > visibleBall.distance * Config::syntheticMatchDistance
+			) {
+				continue;
+			}
+
+			bestIndex = (int)index;
+			bestAngleError = angleError;
+		}
+
+		if (bestIndex == -1) {
+			continue;
+		}
+
+		matched[bestIndex] = true;
+		capture.foundCount++;
+		capture.distanceError += Math::abs(balls[bestIndex]->distance - visibleBall.distance);
+		capture.angleError += bestAngleError;
+	}
+
+	capture.extraCount = (int)balls.size() - capture.foundCount;
+
+	if (capture.foundCount > 0) {
+		capture.distanceError /= capture.foundCount;
+		capture.angleError /= capture.foundCount;
+	}
+}
+
+std::string VisionBenchmark::getObjectsJSON(const ObjectList& objects) {
+	std::stringstream stream;
+
+	stream << "[";
+
+	for (ObjectListItc it = objects.begin(); it != objects.end(); it++) {
+		Object* object = *it;
+
+		stream << (it != objects.begin() ? "," : "") << "{";
+		stream << "\"x\":" << object->x << ",";
+		stream << "\"y\":" << object->y << ",";
+		stream << "\"width\":" << object->width << ",";
+		stream << "\"height\":" << object->height << ",";
+		stream << "\"area\":" << object->area << ",";
+		stream << "\"distance\":" << object->distance << ",";
+		stream << "\"angle\":" << object->angle << ",";
+		stream << "\"type\":" << object->type;
+		stream << "}";
+	}
+
+	stream << "]";
+
+	return stream.str();
+}
+
+void VisionBenchmark::debugStages(std::stringstream& stream, std::vector<__int64>* durations) {
+	stream << "{";
+
+	for (int stage = 0; stage < STAGE_COUNT; stage++) {
+		stream << (stage > 0 ? "," : "") << "\"" << stageNames[stage] << "\":{";
+		stream << "\"median\":" << getPercentile(durations[stage], 0.5f) << ",";
+		stream << "\"p99\":" << getPercentile(durations[stage], 0.99f);
+		stream << "}";
+	}
+
+	stream << "}";
+}
+
+std::string VisionBenchmark::getJSON() {
+	std::stringstream stream;
+	std::vector<__int64> durations[STAGE_COUNT];
+
+	for (unsigned int i = 0; i < captures.size(); i++) {
+		for (int stage = 0; stage < STAGE_COUNT; stage++) {
+			durations[stage].insert(durations[stage].end(), captures[i].durations[stage].begin(), captures[i].durations[stage].end());
+		}
+	}
+
+	stream << "{";
+	stream << "\"iterations\":" << iterations << ",";
+	stream << "\"width\":" << width << ",";
+	stream << "\"height\":" << height << ",";
+	stream << "\"stages\":";
+	debugStages(stream, durations);
+	stream << ",\"captures\":{";
+
+	for (unsigned int i = 0; i < captures.size(); i++) {
+		Capture& capture = captures[i];
+
+		stream << (i > 0 ? "," : "") << "\"" << capture.name << "\":{";
+		stream << "\"camera\":\"" << (capture.dir == Dir::FRONT ? "front" : "rear") << "\",";
+		stream << "\"runs\":" << capture.runCount << ",";
+		stream << "\"blobs\":" << capture.blobCount << ",";
+		stream << "\"balls\":" << capture.balls << ",";
+		stream << "\"goals\":" << capture.goals << ",";
+
+		if (capture.synthetic) {
+			stream << "\"rendered\":{";
+			stream << "\"balls\":" << capture.visibleBalls.size() << ",";
+			stream << "\"found\":" << capture.foundCount << ",";
+			stream << "\"extra\":" << capture.extraCount << ",";
+			stream << "\"distanceError\":" << capture.distanceError << ",";
+			stream << "\"angleError\":" << capture.angleError;
+			stream << "},";
+		}
+
+		stream << "\"stages\":";
+		debugStages(stream, capture.durations);
+		stream << "}";
+	}
+
+	stream << "}}";
+
+	return stream.str();
+}
+
+bool VisionBenchmark::save(const std::string& filename) {
+	if (filename.empty()) {
+		std::cout << getJSON() << std::endl;
+
+		return true;
+	}
+
+	std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+
+	if (!file.is_open()) {
+		std::cout << "- Opening benchmark result file '" << filename << "' failed" << std::endl;
+
+		return false;
+	}
+
+	file << getJSON() << std::endl;
+
+	std::cout << "! Wrote vision benchmark results to " << filename << std::endl;
+
+	return true;
+}
+
+bool VisionBenchmark::compare(const std::string& baselineFilename, const std::string& resultFilename) {
+	Values baseline;
+	Values result;
+
+	if (!loadValues(baselineFilename, baseline) || !loadValues(resultFilename, result)) {
+		return false;
+	}
+
+	bool passed = true;
+
+	std::cout << "! Comparing " << resultFilename << " to baseline " << baselineFilename << std::endl;
+
+	// only the medians decide as the 99th percentiles are too noisy over a short run
+	for (int stage = 0; stage < STAGE_COUNT; stage++) {
+		std::string path = std::string("stages.") + stageNames[stage];
+		double baselineMedian = getNumber(baseline, path + ".median");
+		double resultMedian = getNumber(result, path + ".median");
+		double change = baselineMedian > 0.0 ? resultMedian / baselineMedian - 1.0 : 0.0;
+		bool slower = change > Config::visionBenchmarkTolerance;
+
+		std::cout << "  > " << stageNames[stage] << ": median " << baselineMedian << "ms -> " << resultMedian << "ms (" << (change >= 0.0 ? "+" : "") << (int)(change * 100.0) << "%)"
+			<< ", p99 " << getNumber(baseline, path + ".p99") << "ms -> " << getNumber(result, path + ".p99") << "ms"
+			<< (slower ? " SLOWER" : "") << std::endl;
+
+		if (slower) {
+			passed = false;
+		}
+	}
+
+	std::string prefix = "captures.";
+	std::string suffix = ".camera";
+	int changedCount = 0;
+
+	for (Values::const_iterator it = baseline.begin(); it != baseline.end(); it++) {
+		const std::string& path = it->first;
+
+		if (path.compare(0, prefix.size(), prefix) != 0 || path.size() <= prefix.size() + suffix.size() || path.compare(path.size() - suffix.size(), suffix.size(), suffix) != 0) {
+			continue;
+		}
+
+		std::string name = path.substr(prefix.size(), path.size() - prefix.size() - suffix.size());
+		std::string capturePath = prefix + name + ".";
+
+		if (result.find(path) == result.end()) {
+			std::cout << "  > " << name << ": missing from the result" << std::endl;
+
+			passed = false;
+
+			continue;
+		}
+
+		// the detections differ when any value of the capture other than the timings does
+		bool changed = false;
+
+		for (Values::const_iterator value = baseline.lower_bound(capturePath); value != baseline.end() && value->first.compare(0, capturePath.size(), capturePath) == 0; value++) {
+			if (value->first.compare(capturePath.size(), 7, "stages.") == 0) {
+				continue;
+			}
+
+			Values::const_iterator other = result.find(value->first);
+
+			if (other == result.end() || other->second != value->second) {
+				changed = true;
+
+				break;
+			}
+		}
+
+		for (Values::const_iterator value = result.lower_bound(capturePath); !changed && value != result.end() && value->first.compare(0, capturePath.size(), capturePath) == 0; value++) {
+			if (value->first.compare(capturePath.size(), 7, "stages.") != 0 && baseline.find(value->first) == baseline.end()) {
+				changed = true;
+			}
+		}
+
+		if (changed) {
+			std::cout << "  > " << name << ": detections changed, runs " << getNumber(baseline, capturePath + "runs") << " -> " << getNumber(result, capturePath + "runs")
+				<< ", blobs " << getNumber(baseline, capturePath + "blobs") << " -> " << getNumber(result, capturePath + "blobs")
+				<< ", balls " << getNumber(baseline, capturePath + "balls") << " -> " << getNumber(result, capturePath + "balls")
+				<< ", goals " << getNumber(baseline, capturePath + "goals") << " -> " << getNumber(result, capturePath + "goals") << std::endl;
+
+			changedCount++;
+			passed = false;
+		}
+	}
+
+	std::cout << "! " << (passed ? "No regressions" : "Regressions found") << ", " << changedCount << " screenshots with changed detections" << std::endl;
+
+	return passed;
+}
+
+bool VisionBenchmark::loadValues(const std::string& filename, Values& values) {
+	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+	if (!file.is_open()) {
+		std::cout << "- Opening benchmark result file '" << filename << "' failed" << std::endl;
+
+		return false;
+	}
+
+	std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const char* pos = json.c_str();
+
+	if (!parseValue(pos, pos + json.size(), "", values)) {
+		std::cout << "- Benchmark result file '" << filename << "' is not valid json" << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// flattens the values into dot separated paths with array items by their index, arrays also store their length
+bool VisionBenchmark::parseValue(const char*& pos, const char* end, const std::string& path, Values& values) {
+	while (pos < end && isspace((unsigned char)*pos)) pos++;
+
+	if (pos >= end) {
+		return false;
+	}
+
+	if (*pos == '{' || *pos == '[') {
+		bool isObject = *pos++ == '{';
+		char close = isObject ? '}' : ']';
+		int count = 0;
+
+		while (true) {
+			while (pos < end && isspace((unsigned char)*pos)) pos++;
+
+			if (pos < end && *pos == close && count == 0) {
+				pos++;
+
+				break;
+			}
+
+			std::string key = Util::toString(count);
+
+			if (isObject) {
+				const char* keyStart = ++pos;
+
+				while (pos < end && *pos != '"') pos++;
+
+				if (pos >= end) {
+					return false;
+				}
+
+				key.assign(keyStart, pos++);
+
+				while (pos < end && isspace((unsigned char)*pos)) pos++;
+
+				if (pos >= end || *pos++ != ':') {
+					return false;
+				}
+			}
+
+			if (!parseValue(pos, end, path.empty() ? key : path + "." + key, values)) {
+				return false;
+			}
+
+			count++;
+
+			while (pos < end && isspace((unsigned char)*pos)) pos++;
+
+			if (pos < end && *pos == ',') {
+				pos++;
+			} else if (pos < end && *pos == close) {
+				pos++;
+
+				break;
+			} else {
+				return false;
+			}
+		}
+
+		if (!isObject) {
+			values[path] = Util::toString(count);
+		}
+
+		return true;
+	}
+
+	const char* start = pos;
+
+	if (*pos == '"') {
+		start = ++pos;
+
+		while (pos < end && *pos != '"') {
+			pos += *pos == '\\' ? 2 : 1;
+		}
+
+		if (pos >= end) {
+			return false;
+		}
+
+		values[path] = std::string(start, pos++);
+
+		return true;
+	}
+
+	while (pos < end && *pos != ',' && *pos != '}' && *pos != ']' && !isspace((unsigned char)*pos)) pos++;
+
+	values[path] = std::string(start, pos);
+
+	return pos > start;
+}
+
+double VisionBenchmark::getNumber(const Values& values, const std::string& path) {
+	Values::const_iterator it = values.find(path);
+
+	return it != values.end() ? Util::toDouble(it->second) : 0.0;
+}
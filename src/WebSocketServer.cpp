@@ -66,6 +66,22 @@ void WebSocketServer::send(websocketpp::connection_hdl connection, std::string m
 	}
 }
 
+void WebSocketServer::sendBinary(websocketpp::connection_hdl connection, const std::string& data) {
+	try {
+		server->send(connection, data, websocketpp::frame::opcode::BINARY);
+	} catch (...) {
+		std::cout << "! Sending binary server message of " << data.size() << " bytes failed" << std::endl;
+	}
+}
+
+size_t WebSocketServer::getBufferedAmount(websocketpp::connection_hdl connection) {
+	try {
+		return server->get_con_from_hdl(connection)->get_buffered_amount();
+	} catch (...) {
+		return 0;
+	}
+}
+
 void WebSocketServer::onOpen(websocketpp::connection_hdl connection) {
 	connections.insert(connection);
 
@@ -1,8 +1,9 @@
 #include "XimeaCamera.h"
+#include "Util.h"
 
 #include <iostream>
 
-XimeaCamera::XimeaCamera() : opened(false), acquisitioning(false) {
+XimeaCamera::XimeaCamera() : opened(false), acquisitioning(false), timestampOffset(0.0), timestampOffsetKnown(false) {
     image.size = sizeof(XI_IMG);
     image.bp = NULL;
     image.bp_size = 0;
@@ -107,7 +108,7 @@ XimeaCamera::Frame* XimeaCamera::getFrame() {
     frame.number = image.nframe;
     frame.width = image.width;
     frame.height = image.height;
-    frame.timestamp = (double)image.tsSec + (double)image.tsUSec / 1000000.0;
+    frame.timestamp = toHostTime((double)image.tsSec + (double)image.tsUSec / 1000000.0);
     frame.fresh = frame.number != lastFrameNumber;
 
 	int frameNumberDiff = frame.number - lastFrameNumber;
@@ -135,6 +136,20 @@ XimeaCamera::Frame* XimeaCamera::getFrame() {
     return &frame;
 }
 
+double XimeaCamera::toHostTime(double cameraTime) {
+	double offset = Util::millitime() - cameraTime;
+
+	// the smallest observed offset corresponds to the shortest transfer delay, relax it slowly to follow clock drift
+	timestampOffset += 0.0001;
+
+	if (!timestampOffsetKnown || offset < timestampOffset) {
+		timestampOffset = offset;
+		timestampOffsetKnown = true;
+	}
+
+	return cameraTime + timestampOffset;
+}
+
 void XimeaCamera::startAcquisition() {
     if (!opened) {
 		std::cout << "- Unable to start acquisition, open camera first" << std::endl;
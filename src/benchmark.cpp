@@ -0,0 +1,53 @@
+// benchmarks of the portable core, built with it on systems where the robot itself can't be
+//
+// vision <screenshots directory> [iterations] [result file]
+// vision-synthetic <scenes> <balls> [robots] [iterations] [result file]
+// vision-compare <baseline file> <result file>
+// controller <matches> [balls] [result file]
+
+#include "VisionBenchmark.h"
+#include "FieldSimulator.h"
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char* argv[]) {
+	if (argc >= 3 && strcmp(argv[1], "vision") == 0) {
+		VisionBenchmark benchmark;
+
+		if (!benchmark.load(argv[2])) {
+			return 1;
+		}
+
+		benchmark.run(argc > 3 ? atoi(argv[3]) : 100);
+
+		return benchmark.save(argc > 4 ? argv[4] : "") ? 0 : 1;
+	} else if (argc >= 4 && strcmp(argv[1], "vision-synthetic") == 0) {
+		VisionBenchmark benchmark;
+
+		if (!benchmark.generate(atoi(argv[2]), atoi(argv[3]), argc > 4 ? atoi(argv[4]) : 0)) {
+			return 1;
+		}
+
+		benchmark.run(argc > 5 ? atoi(argv[5]) : 100);
+
+		return benchmark.save(argc > 6 ? argv[6] : "") ? 0 : 1;
+	} else if (argc >= 4 && strcmp(argv[1], "vision-compare") == 0) {
+		return VisionBenchmark::compare(argv[2], argv[3]) ? 0 : 1;
+	} else if (argc >= 3 && strcmp(argv[1], "controller") == 0) {
+		FieldSimulator simulator;
+
+		simulator.simulate(atoi(argv[2]), argc > 3 ? atoi(argv[3]) : 11);
+
+		return simulator.save(argc > 4 ? argv[4] : "") ? 0 : 1;
+	}
+
+	std::cout << "Usage:" << std::endl;
+	std::cout << "  " << argv[0] << " vision <screenshots directory> [iterations] [result file]" << std::endl;
+	std::cout << "  " << argv[0] << " vision-synthetic <scenes> <balls> [robots] [iterations] [result file]" << std::endl;
+	std::cout << "  " << argv[0] << " vision-compare <baseline file> <result file>" << std::endl;
+	std::cout << "  " << argv[0] << " controller <matches> [balls] [result file]" << std::endl;
+
+	return 1;
+}
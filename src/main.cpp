@@ -10,6 +10,11 @@
 #endif*/
 
 #include "SoccerBot.h"
+#include "DispatchBenchmark.h"
+#include "FramerBenchmark.h"
+#include "CommBenchmark.h"
+#include "VisionBenchmark.h"
+#include "FieldSimulator.h"
 
 #include <iostream>
 
@@ -26,6 +31,10 @@ int main(int argc, char* argv[]) {
 	#endif*/
 
 	bool showGui = false;
+	bool useFirmwareStub = false;
+	bool replayRealtime = false;
+	std::string recordFilename;
+	std::string replayFilename;
 
 	if (argc > 0) {
         std::cout << "! Parsing command line options" << std::endl;
@@ -35,6 +44,95 @@ int main(int argc, char* argv[]) {
                 showGui = true;
 
                 std::cout << "  > Showing the GUI" << std::endl;
+            } else if (strcmp(argv[i], "benchmark-dispatch") == 0) {
+                DispatchBenchmark benchmark;
+
+                benchmark.run(1000000);
+
+                return 0;
+            } else if (strcmp(argv[i], "benchmark-framer") == 0) {
+                FramerBenchmark benchmark;
+
+                if (i + 1 < argc) {
+                    if (!benchmark.load(argv[i + 1])) {
+                        return 1;
+                    }
+                } else {
+                    benchmark.generate(100000);
+                }
+
+                benchmark.run(200);
+
+                return 0;
+            } else if (strcmp(argv[i], "benchmark-comm") == 0) {
+                // benchmark-comm [ethernet|serial] [delay ms] [loss 0..1] [stub serial port] [serial port]
+                bool serial = i + 1 < argc && strcmp(argv[i + 1], "serial") == 0;
+                int delay = i + 2 < argc ? atoi(argv[i + 2]) : 0;
+                float loss = i + 3 < argc ? (float)atof(argv[i + 3]) : 0.0f;
+                CommBenchmark benchmark(serial ? CommBenchmark::SERIAL : CommBenchmark::ETHERNET, delay, loss);
+
+                if (i + 5 < argc) {
+                    benchmark.setSerialPorts(argv[i + 4], argv[i + 5]);
+                }
+
+                if (!benchmark.setup()) {
+                    return 1;
+                }
+
+                benchmark.run(10.0, 500);
+
+                return 0;
+            } else if (strcmp(argv[i], "benchmark-vision") == 0 && i + 1 < argc) {
+                // benchmark-vision <screenshots directory> [iterations] [result file]
+                VisionBenchmark benchmark;
+
+                if (!benchmark.load(argv[i + 1])) {
+                    return 1;
+                }
+
+                benchmark.run(i + 2 < argc ? atoi(argv[i + 2]) : 100);
+
+                return benchmark.save(i + 3 < argc ? argv[i + 3] : "") ? 0 : 1;
+            } else if (strcmp(argv[i], "benchmark-vision-synthetic") == 0 && i + 2 < argc) {
+                // benchmark-vision-synthetic <scenes> <balls> [robots] [iterations] [result file]
+                VisionBenchmark benchmark;
+
+                if (!benchmark.generate(atoi(argv[i + 1]), atoi(argv[i + 2]), i + 3 < argc ? atoi(argv[i + 3]) : 0)) {
+                    return 1;
+                }
+
+                benchmark.run(i + 4 < argc ? atoi(argv[i + 4]) : 100);
+
+                return benchmark.save(i + 5 < argc ? argv[i + 5] : "") ? 0 : 1;
+            } else if (strcmp(argv[i], "benchmark-vision-compare") == 0 && i + 2 < argc) {
+                // benchmark-vision-compare <baseline file> <result file>
+                return VisionBenchmark::compare(argv[i + 1], argv[i + 2]) ? 0 : 1;
+            } else if (strcmp(argv[i], "benchmark-controller") == 0 && i + 1 < argc) {
+                // benchmark-controller <matches> [balls] [result file]
+                FieldSimulator simulator;
+
+                simulator.simulate(atoi(argv[i + 1]), i + 2 < argc ? atoi(argv[i + 2]) : 11);
+
+                return simulator.save(i + 3 < argc ? argv[i + 3] : "") ? 0 : 1;
+            } else if (strcmp(argv[i], "firmware-stub") == 0) {
+                useFirmwareStub = true;
+
+                std::cout << "  > Using local firmware stub" << std::endl;
+            } else if (strcmp(argv[i], "record") == 0 && i + 1 < argc) {
+                // record <file>
+                recordFilename = argv[++i];
+
+                std::cout << "  > Recording to " << recordFilename << std::endl;
+            } else if (strcmp(argv[i], "replay") == 0 && i + 1 < argc) {
+                // replay <file> [realtime]
+                replayFilename = argv[++i];
+
+                if (i + 1 < argc && strcmp(argv[i + 1], "realtime") == 0) {
+                    replayRealtime = true;
+                    i++;
+                }
+
+                std::cout << "  > Replaying " << replayFilename << (replayRealtime ? " in real time" : " as fast as possible") << std::endl;
             } else {
                 std::cout << "  > Unknown command line option: " << argv[i] << std::endl;
 
@@ -50,6 +148,10 @@ int main(int argc, char* argv[]) {
 	SoccerBot* soccerBot = new SoccerBot();
 
 	soccerBot->showGui = showGui;
+	soccerBot->useFirmwareStub = useFirmwareStub;
+	soccerBot->recordFilename = recordFilename;
+	soccerBot->replayFilename = replayFilename;
+	soccerBot->replayRealtime = replayRealtime;
 
 	soccerBot->setup();
 	soccerBot->run();